@@ -4,7 +4,7 @@ use std::net::TcpStream;
 use std::sync::atomic::{AtomicBool, Ordering};
 use std::sync::{mpsc, Arc};
 use std::thread;
-use std::time::Duration;
+use std::time::{Duration, Instant};
 use byteorder::{ByteOrder, LittleEndian};
 
 // Message type definitions
@@ -37,6 +37,16 @@ Usage:
 struct Count {
     inb: u64,
     outb: u64,
+    latencies_us: Vec<u32>, // round-trip time of each echoed request
+}
+
+// Returns the value at the given percentile (0.0 ~ 100.0) of a sorted slice
+fn percentile(sorted: &[u32], pct: f64) -> u32 {
+    if sorted.is_empty() {
+        return 0;
+    }
+    let rank = ((pct / 100.0) * (sorted.len() - 1) as f64).round() as usize;
+    sorted[rank.min(sorted.len() - 1)]
 }
 
 // Chat message struct
@@ -179,7 +189,7 @@ fn main() {
         let length = length;
 
         thread::spawn(move || {
-            let mut sum = Count { inb: 0, outb: 0 };
+            let mut sum = Count { inb: 0, outb: 0, latencies_us: Vec::new() };
             // Generate test data
             let data_length = std::cmp::min(length, MESSAGE_DATA_SIZE);
             let test_data = vec![b'A'; data_length];
@@ -207,6 +217,7 @@ fn main() {
                 // Create and send CLIENT_CHAT message
                 let message = ChatMessage::new(CLIENT_CHAT, &test_data);
                 let out_buf = message.pack();
+                let sent_at = Instant::now();
                 
                 match stream.write_all(&out_buf) {
                     Err(_) => {
@@ -244,6 +255,7 @@ fn main() {
                                    response.msg_type == SERVER_INFO {
                                     // Process normal response
                                     sum.inb += 1;
+                                    sum.latencies_us.push(sent_at.elapsed().as_micros() as u32);
                                 }
                             },
                             Err(_) => {
@@ -264,14 +276,15 @@ fn main() {
         None => println!("Sorry, but all threads died already."),
     }
 
-    let mut sum = Count { inb: 0, outb: 0 };
+    let mut sum = Count { inb: 0, outb: 0, latencies_us: Vec::new() };
     let mut received_responses = 0;
     
     for _ in 0..number {
         match rx.recv() {
-            Ok(c) => {
+            Ok(mut c) => {
                 sum.inb += c.inb;
                 sum.outb += c.outb;
+                sum.latencies_us.append(&mut c.latencies_us);
                 received_responses += 1;
             },
             Err(_) => {}
@@ -297,4 +310,14 @@ fn main() {
         let success_rate = (sum.inb as f64 / sum.outb as f64) * 100.0;
         println!("Success rate: {:.2}%", success_rate);
     }
+    
+    // Echo round-trip latency distribution
+    sum.latencies_us.sort_unstable();
+    println!(
+        "Latency: p50={}us p99={}us p999={}us max={}us",
+        percentile(&sum.latencies_us, 50.0),
+        percentile(&sum.latencies_us, 99.0),
+        percentile(&sum.latencies_us, 99.9),
+        sum.latencies_us.last().copied().unwrap_or(0)
+    );
 }
@@ -53,6 +53,8 @@ def main():
                                  help="일반 벤치마크 실행 (기본값: 사용)")
     benchmark_group.add_argument("--strace", action="store_true", default=False,
                                  help="strace를 사용한 벤치마크 실행 (기본값: 사용 안 함)")
+    benchmark_group.add_argument("--ring-profiles", action="store_true", default=False,
+                                 help="io_uring 링 프로파일(default / single-issuer)별 p99 지연 비교 (기본값: 사용 안 함)")
     
     args = parser.parse_args()
     
@@ -84,6 +86,25 @@ def main():
     print(f"벤치마크 유형: {'일반' if args.regular else ''} {'strace' if args.strace else ''}")
     print(f"벤치마크 모드: {'종합' if is_combined else '단일'}")
     
+    # 링 프로파일 비교 (io_uring 서버 전용, 첫 번째 스레드/연결 수 사용)
+    if args.ring_profiles:
+        from bench_project.runners.ring_profile_benchmark import run_ring_profile_benchmark
+        print("\n===== 링 프로파일 비교 벤치마크 시작 =====")
+        result = run_ring_profile_benchmark(
+            args.connections[0],
+            args.threads[0],
+            args.server_address,
+            duration=args.duration,
+            results_dir=CONFIG['results_dir'],
+            timestamp=timestamp,
+            server_type=SERVER_TYPE_IOURING
+        )
+        if not result:
+            print("링 프로파일 비교 벤치마크 실패")
+            return 1
+        print("\n===== 벤치마크 완료 =====")
+        return 0
+    
     # 단일 스레드 수와 단일 연결 수로 실행 (일반 벤치마크)
     if not is_combined:
         thread_count = args.threads[0]
@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+
+import os
+import sys
+import csv
+import subprocess
+import datetime
+import time
+
+# 패키지 경로 추가
+sys.path.insert(0, os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__)))))
+
+# 절대 경로로 임포트
+from bench_project.utils.command import stop_server
+from bench_project.utils.parsers import parse_bench_output, parse_latency_output
+from bench_project.runners.start_server import start_server
+
+# 비교할 링 프로파일 (서버 --ring-profile 옵션 값)
+RING_PROFILES = ["default", "single-issuer"]
+
+def run_ring_profile_benchmark(conn_count, thread_count, server_address,
+                               duration=30, results_dir="benchmark_results",
+                               timestamp=None, server_type=None):
+    """Compare echo latency of the io_uring server with and without the single-issuer ring profile."""
+    if timestamp is None:
+        timestamp = datetime.datetime.now().strftime("%Y%m%d-%H%M%S")
+    
+    print("\n===== Starting ring profile comparison =====")
+    print(f"Connections: {conn_count}, Threads: {thread_count}, Duration: {duration}s")
+    
+    os.makedirs(results_dir, exist_ok=True)
+    csv_file = os.path.join(results_dir, f"ring_profile_results_{timestamp}.csv")
+    
+    results = []
+    for profile in RING_PROFILES:
+        print(f"\n----- Ring profile: {profile} -----")
+        server_process = start_server(thread_count, server_type=server_type,
+                                      server_args=[f"--ring-profile={profile}"])
+        if not server_process:
+            print(f"Failed to start server with profile {profile}. Aborting comparison.")
+            return None
+        
+        cmd = [
+            "cargo", "run", "--release", "--bin", "bench", "--",
+            "-a", server_address,
+            "-c", str(conn_count),
+            "-t", str(duration),
+            "-l", str(1024)
+        ]
+        print(f"Running: {' '.join(cmd)}")
+        result = subprocess.run(cmd, capture_output=True, text=True)
+        stop_server(server_process)
+        
+        if result.returncode != 0:
+            print(f"Benchmark failed for profile {profile} (exit code {result.returncode})")
+            if result.stderr:
+                print(result.stderr)
+            return None
+        
+        output = result.stdout
+        print(output)
+        
+        result_file = os.path.join(results_dir, f"ring_profile_{profile}_conn_{conn_count}_{timestamp}.txt")
+        with open(result_file, 'w', encoding='utf-8') as f:
+            f.write(output)
+        
+        tps_request, tps_response, success_rate = parse_bench_output(output, duration)
+        latency = parse_latency_output(output)
+        results.append({
+            "ring_profile": profile,
+            "connection_count": conn_count,
+            "thread_count": thread_count,
+            "tps_response": tps_response,
+            "success_rate": success_rate,
+            "latency_p50_us": latency["p50"],
+            "latency_p99_us": latency["p99"],
+            "latency_p999_us": latency["p999"],
+            "timestamp": timestamp
+        })
+        
+        time.sleep(1)  # 포트가 해제될 시간
+    
+    with open(csv_file, 'w', newline='', encoding='utf-8') as f:
+        writer = csv.DictWriter(f, fieldnames=list(results[0].keys()))
+        writer.writeheader()
+        writer.writerows(results)
+    print(f"Results saved to CSV file: {csv_file}")
+    
+    # 요약 비교 출력
+    print("\n===== Ring profile comparison =====")
+    print(f"{'profile':<15}{'resp/sec':>12}{'p50(us)':>10}{'p99(us)':>10}{'p999(us)':>10}")
+    for r in results:
+        print(f"{r['ring_profile']:<15}{r['tps_response']:>12}{r['latency_p50_us']:>10}"
+              f"{r['latency_p99_us']:>10}{r['latency_p999_us']:>10}")
+    base_p99 = results[0]["latency_p99_us"]
+    if base_p99 > 0:
+        for r in results[1:]:
+            change = (r["latency_p99_us"] - base_p99) / base_p99 * 100.0
+            print(f"p99 change ({r['ring_profile']} vs {results[0]['ring_profile']}): {change:+.1f}%")
+    
+    return results
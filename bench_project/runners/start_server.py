@@ -8,7 +8,7 @@ sys.path.insert(0, os.path.abspath(os.path.join(os.path.dirname(__file__), '../.
 from bench_project.utils.command import start_server as cmd_start_server
 from bench_project.config import CONFIG, SERVER_TYPE_IOURING, SERVER_TYPE_EPOLL
 
-def start_server(thread_count, server_type=None):
+def start_server(thread_count, server_type=None, server_args=None):
     """시스템 설정에 맞는 서버를 시작합니다."""
     if server_type is None:
         server_type = CONFIG.get('default_server_type', SERVER_TYPE_IOURING)
@@ -17,9 +17,11 @@ def start_server(thread_count, server_type=None):
     
     print(f"\n===== 서버 시작 (스레드: {thread_count}, 유형: {server_type}) =====")
     print(f"서버 주소: {host}:{port}")
+    if server_args:
+        print(f"서버 옵션: {' '.join(server_args)}")
     
     # 서버 시작
-    server_process = cmd_start_server(thread_count, server_type=server_type)
+    server_process = cmd_start_server(thread_count, server_type=server_type, server_args=server_args)
     if not server_process:
         print("서버 시작 실패!")
         return None
@@ -69,8 +69,11 @@ def find_server_pid(server_address):
     print(f"Warning: Could not find server process using port {port}")
     return None
 
-def start_server(thread_count=4, server_type=None):
-    """Start the server with the specified number of threads and server type."""
+def start_server(thread_count=4, server_type=None, server_args=None):
+    """Start the server with the specified number of threads and server type.
+
+    server_args: extra server options (e.g. ["--ring-profile=single-issuer"])
+    """
     # 서버 유형이 지정되지 않으면 기본 유형 사용
     if server_type is None:
         server_type = CONFIG['default_server_type']
@@ -97,6 +100,8 @@ def start_server(thread_count=4, server_type=None):
         host,
         port
     ]
+    if server_args:
+        server_cmd.extend(server_args)
     
     
     server_process = subprocess.Popen(server_cmd)
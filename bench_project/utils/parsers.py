@@ -38,6 +38,21 @@ def parse_bench_output(output, duration):
     
     return tps_request, tps_response, success_rate
 
+def parse_latency_output(output):
+    """Parse the latency line of the benchmark output (values in microseconds)."""
+    latency = {"p50": 0, "p99": 0, "p999": 0, "max": 0}
+    
+    # Parse "Latency: p50={}us p99={}us p999={}us max={}us"
+    latency_match = re.search(r'Latency: p50=(\d+)us p99=(\d+)us p999=(\d+)us max=(\d+)us', output)
+    if latency_match:
+        latency["p50"] = int(latency_match.group(1))
+        latency["p99"] = int(latency_match.group(2))
+        latency["p999"] = int(latency_match.group(3))
+        latency["max"] = int(latency_match.group(4))
+        print(f"Latency: p50={latency['p50']}us, p99={latency['p99']}us")
+    
+    return latency
+
 def parse_strace_output(output):
     """Parse strace output to extract system call statistics."""
     syscalls = {}
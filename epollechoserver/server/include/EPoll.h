@@ -38,6 +38,8 @@ public:
     void prepareAccept(int socket_fd);
     void prepareRead(int client_fd);
     bool prepareWrite(int client_fd, const void* buf, unsigned len);
+    // 이미 메시지를 담은 버퍼를 복사 없이 클라이언트 큐에 추가 (참조를 하나 더 잡음, 쓰기 오프셋은 큐 항목별)
+    bool prepareWriteShared(int client_fd, const IOBuffer& buffer);
     void prepareClose(int client_fd);
     
     // 이벤트 처리
@@ -2,7 +2,7 @@
 
 #include <vector>
 #include <list>
-#include <queue>
+#include <deque>
 #include <mutex>
 #include <unordered_map>
 #include <cstdint>
@@ -16,20 +16,37 @@ struct IOBuffer {
     size_t length;           // 현재 저장된 데이터 길이
     size_t write_offset;     // 쓰기 오프셋
     int buffer_id;           // 버퍼 ID
+    bool droppable;          // 느린 수신자 정책이 버릴 수 있는 브로드캐스트 항목
 
-    IOBuffer() : data(nullptr), length(0), write_offset(0), buffer_id(-1) {}
-    IOBuffer(uint8_t* buf, int id) : data(buf), length(0), write_offset(0), buffer_id(id) {}
+    IOBuffer() : data(nullptr), length(0), write_offset(0), buffer_id(-1), droppable(false) {}
+    IOBuffer(uint8_t* buf, int id) : data(buf), length(0), write_offset(0), buffer_id(id), droppable(false) {}
+};
+
+// 송신 큐가 찬 연결에 브로드캐스트를 넣을 때의 처리
+enum class SlowConsumerPolicy : uint8_t {
+    DROP_OLDEST = 0,  // 아직 보내지 않은 가장 오래된 브로드캐스트를 버림
+    DROP_NEWEST = 1,  // 새 브로드캐스트를 버림
+    COALESCE = 2,     // 아직 보내지 않은 브로드캐스트를 모두 버리고 새 것만 남김
+    DISCONNECT = 3    // 연결을 끊음
 };
 
 // EPoll 버퍼 관리 클래스
 class EPollBuffer {
 public:
+    // 클라이언트별 송신 큐 상한 (넘으면 읽기를 멈추고 브로드캐스트는 정책대로 처리)
+    static constexpr size_t MAX_CLIENT_QUEUE_BUFFERS = 32;
+    static constexpr size_t MAX_CLIENT_QUEUE_BYTES = 16 * 1024;
+    
+    enum class Admission { ACCEPT, DROP, DISCONNECT };
+    
     explicit EPollBuffer(size_t buffer_size = IOBuffer::IO_BUFFER_SIZE, size_t buffer_count = 256);
     ~EPollBuffer();
     
     // 버퍼 할당 및 해제
     IOBuffer allocateBuffer();
     void releaseBuffer(int buffer_id);
+    // 여러 클라이언트 큐가 같은 버퍼를 보낼 때 참조 추가 (releaseBuffer가 마지막 참조에서만 풀로 반환)
+    void retainBuffer(int buffer_id);
     
     // 클라이언트별 버퍼 관리
     void addToClientQueue(int client_fd, IOBuffer& buffer);
@@ -38,6 +55,13 @@ public:
     void removeProcessedBuffer(int client_fd);
     void clearClientBuffers(int client_fd);
     
+    // 송신 큐 흐름 제어
+    bool isClientQueueFull(int client_fd) const;
+    bool isClientQueueDrained(int client_fd) const;  // 상한의 절반 이하로 줄었는지
+    // length 바이트 브로드캐스트를 넣을 수 있는지 정책대로 판단 (ACCEPT면 자리를 비워 둠)
+    Admission admitShared(int client_fd, size_t length);
+    void setSlowConsumerPolicy(SlowConsumerPolicy policy) { slow_consumer_ = policy; }
+    
     // 데이터 관리
     ssize_t readToBuffer(int fd, IOBuffer& buffer);
     ssize_t writeFromBuffer(int fd, IOBuffer& buffer);
@@ -54,11 +78,22 @@ public:
 private:
     std::vector<uint8_t*> buffer_pool_;
     std::list<int> free_buffers_;
+    std::vector<uint32_t> buffer_refs_;  // 버퍼별 참조 수 (할당 시 1)
     std::mutex buffer_mutex_;
     size_t buffer_size_;
     size_t buffer_count_;
     
     // 클라이언트별 버퍼 큐 관리
-    std::unordered_map<int, std::queue<IOBuffer>> client_buffers_;
+    struct ClientQueue {
+        std::deque<IOBuffer> buffers;
+        size_t bytes = 0;  // 큐에 남은 버퍼의 데이터 길이 합
+    };
+    bool fits(const ClientQueue& queue, size_t length) const {
+        return queue.buffers.size() < MAX_CLIENT_QUEUE_BUFFERS && queue.bytes + length <= MAX_CLIENT_QUEUE_BYTES;
+    }
+    bool dropOldestShared(ClientQueue& queue);
+    
+    std::unordered_map<int, ClientQueue> client_buffers_;
     mutable std::mutex client_mutex_;
+    SlowConsumerPolicy slow_consumer_ = SlowConsumerPolicy::DROP_OLDEST;
 }; 
\ No newline at end of file
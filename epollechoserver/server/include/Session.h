@@ -3,19 +3,21 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include "Socket.h"
 #include "EPoll.h"
 #include "Context.h"
 
 class Session {
 public:
-    explicit Session(int32_t id);
+    explicit Session(int32_t id, SlowConsumerPolicy slow_consumer = SlowConsumerPolicy::DROP_OLDEST);
     ~Session();
     
     int32_t getSessionId() const { return session_id_; }
     std::set<int32_t> getClientFds() const;
     
-    void addClient(SocketPtr client_socket);
+    // room_member: CLIENT_JOIN으로 옮겨 와 이 세션의 채팅방에 바로 참가
+    void addClient(SocketPtr client_socket, bool room_member = false);
     void removeClient(SocketPtr client_socket);
     size_t getClientCount() const { return client_sockets_.size(); }
     
@@ -45,6 +47,10 @@ private:
     epoll_event events[EPoll::MAX_EVENTS];
     // 클라이언트 소켓 맵 (file descriptor -> Socket 객체)
     std::unordered_map<int32_t, SocketPtr> client_sockets_;
+    // 채팅방 멤버 (CLIENT_JOIN한 연결, 나머지는 에코만 받음)
+    std::unordered_set<int32_t> room_members_;
+    // 송신 큐가 차서 읽기를 멈춘 연결 (큐가 절반 아래로 줄면 handleWrite가 다시 읽음)
+    std::unordered_set<int32_t> paused_reads_;
     // EPoll 인스턴스
     std::unique_ptr<EPoll> epoll_;
     int event_count;
@@ -19,6 +19,8 @@ public:
     void setThreadCount(unsigned int thread_count) {
         thread_count_ = thread_count > 0 ? thread_count : std::thread::hardware_concurrency();
     }
+    // initialize() 전에 호출 (세션마다 송신 큐가 찬 연결에 적용)
+    void setSlowConsumerPolicy(SlowConsumerPolicy policy) { slow_consumer_ = policy; }
     void start();
     void stop();
     
@@ -54,6 +56,7 @@ private:
     
     // 쓰레드 수 설정
     unsigned int thread_count_{0};
+    SlowConsumerPolicy slow_consumer_{SlowConsumerPolicy::DROP_OLDEST};
     std::atomic<bool> should_terminate_{false};  
     // 쓰레드 실행 상태
     std::atomic<bool> running_{false};
@@ -8,6 +8,7 @@
 #include <atomic>
 #include <csignal>
 #include <cstdlib>  // getenv
+#include <string>
 
 std::atomic<bool> running(true);
 
@@ -19,8 +20,8 @@ void signal_handler(int signal) {
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 3 || argc > 4) {
-        LOG_ERROR("Usage: ", argv[0], " <host> <port> [num_threads]");
+    if (argc < 3 || argc > 5) {
+        LOG_ERROR("Usage: ", argv[0], " <host> <port> [num_threads] [drop-oldest|drop-newest|coalesce|disconnect]");
         return 1;
     }
 
@@ -56,7 +57,7 @@ int main(int argc, char* argv[]) {
 
         // 쓰레드 수 인수 처리 (선택적)
         unsigned int thread_count = std::thread::hardware_concurrency(); // 기본값은 CPU 코어 수
-        if (argc == 4) {
+        if (argc >= 4) {
             thread_count = static_cast<unsigned int>(std::stoi(argv[3]));
             if (thread_count == 0) {
                 LOG_ERROR("Number of threads must be greater than 0");
@@ -67,9 +68,29 @@ int main(int argc, char* argv[]) {
             LOG_INFO("Using hardware concurrency: ", thread_count, " threads");
         }
 
+        // 느린 수신자 정책 (송신 큐가 찬 연결에 브로드캐스트를 넣을 때)
+        SlowConsumerPolicy slow_consumer = SlowConsumerPolicy::DROP_OLDEST;
+        if (argc == 5) {
+            const std::string policy = argv[4];
+            if (policy == "drop-oldest") {
+                slow_consumer = SlowConsumerPolicy::DROP_OLDEST;
+            } else if (policy == "drop-newest") {
+                slow_consumer = SlowConsumerPolicy::DROP_NEWEST;
+            } else if (policy == "coalesce") {
+                slow_consumer = SlowConsumerPolicy::COALESCE;
+            } else if (policy == "disconnect") {
+                slow_consumer = SlowConsumerPolicy::DISCONNECT;
+            } else {
+                LOG_ERROR("Unknown slow consumer policy: ", policy);
+                return 1;
+            }
+            LOG_INFO("Using slow consumer policy: ", policy);
+        }
+
         // 세션 매니저 초기화
         auto& session_manager = SessionManager::getInstance();
         session_manager.setThreadCount(thread_count);
+        session_manager.setSlowConsumerPolicy(slow_consumer);
         session_manager.initialize();
         session_manager.start();
 
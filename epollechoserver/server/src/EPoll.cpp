@@ -144,6 +144,34 @@ bool EPoll::prepareWrite(int client_fd, const void* buf, unsigned len) {
     return result;
 }
 
+bool EPoll::prepareWriteShared(int client_fd, const IOBuffer& buffer) {
+    if (!buffer.data || buffer.length == 0) {
+        LOG_ERROR("Invalid shared buffer for prepareWriteShared");
+        return false;
+    }
+    
+    if (!epoll_initialized_) {
+        LOG_ERROR("EPoll not initialized for prepareWriteShared");
+        return false;
+    }
+    
+    EPollBuffer& buffer_manager = getBufferManager();
+    buffer_manager.retainBuffer(buffer.buffer_id);
+    
+    // 클라이언트 큐에 추가 (같은 데이터를 가리키는 항목, 쓰기 오프셋은 처음부터)
+    IOBuffer entry(buffer.data, buffer.buffer_id);
+    entry.length = buffer.length;
+    entry.droppable = true;
+    buffer_manager.addToClientQueue(client_fd, entry);
+    
+    bool result = modifyEvent(client_fd, BASE_EVENTS | EPOLLOUT);
+    if (!result) {
+        LOG_ERROR("Failed to modify event for write on client ", client_fd);
+    }
+    
+    return result;
+}
+
 void EPoll::prepareClose(int client_fd) {
     try {
         // 클라이언트 버퍼 정리
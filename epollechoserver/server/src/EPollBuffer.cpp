@@ -9,6 +9,7 @@ EPollBuffer::EPollBuffer(size_t buffer_size, size_t buffer_count)
     : buffer_size_(buffer_size), buffer_count_(buffer_count) {
     // 버퍼 풀 초기화
     buffer_pool_.reserve(buffer_count);
+    buffer_refs_.assign(buffer_count, 0);
     for (size_t i = 0; i < buffer_count; ++i) {
         uint8_t* buffer = new uint8_t[buffer_size];
         buffer_pool_.push_back(buffer);
@@ -38,6 +39,7 @@ IOBuffer EPollBuffer::allocateBuffer() {
     
     int buffer_id = free_buffers_.front();
     free_buffers_.pop_front();
+    buffer_refs_[buffer_id] = 1;
     
     return IOBuffer(buffer_pool_[buffer_id], buffer_id);
 }
@@ -49,26 +51,45 @@ void EPollBuffer::releaseBuffer(int buffer_id) {
     }
     
     std::lock_guard<std::mutex> lock(buffer_mutex_);
-    free_buffers_.push_back(buffer_id);
+    if (buffer_refs_[buffer_id] == 0) {
+        LOG_ERROR("Buffer ", buffer_id, " released twice");
+        return;
+    }
+    // 공유 버퍼는 마지막 큐가 다 보낼 때까지 풀로 돌아가지 않음
+    if (--buffer_refs_[buffer_id] == 0) {
+        free_buffers_.push_back(buffer_id);
+    }
+}
+
+void EPollBuffer::retainBuffer(int buffer_id) {
+    if (buffer_id < 0 || buffer_id >= static_cast<int>(buffer_pool_.size())) {
+        LOG_ERROR("Invalid buffer index: ", buffer_id);
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(buffer_mutex_);
+    ++buffer_refs_[buffer_id];
 }
 
 void EPollBuffer::addToClientQueue(int client_fd, IOBuffer& buffer) {
     std::lock_guard<std::mutex> lock(client_mutex_);
-    client_buffers_[client_fd].push(std::move(buffer));
+    ClientQueue& queue = client_buffers_[client_fd];
+    queue.bytes += buffer.length;
+    queue.buffers.push_back(std::move(buffer));
     LOG_DEBUG("Added buffer ", buffer.buffer_id, " to client ", client_fd, "'s queue");
 }
 
 bool EPollBuffer::hasDataToWrite(int client_fd) const {
     std::lock_guard<std::mutex> lock(client_mutex_);
     auto it = client_buffers_.find(client_fd);
-    return it != client_buffers_.end() && !it->second.empty();
+    return it != client_buffers_.end() && !it->second.buffers.empty();
 }
 
 IOBuffer& EPollBuffer::getNextBufferToWrite(int client_fd) {
     std::lock_guard<std::mutex> lock(client_mutex_);
     auto it = client_buffers_.find(client_fd);
-    if (it != client_buffers_.end() && !it->second.empty()) {
-        return it->second.front();
+    if (it != client_buffers_.end() && !it->second.buffers.empty()) {
+        return it->second.buffers.front();
     }
     
     static IOBuffer empty_buffer;
@@ -79,9 +100,10 @@ IOBuffer& EPollBuffer::getNextBufferToWrite(int client_fd) {
 void EPollBuffer::removeProcessedBuffer(int client_fd) {
     std::lock_guard<std::mutex> lock(client_mutex_);
     auto it = client_buffers_.find(client_fd);
-    if (it != client_buffers_.end() && !it->second.empty()) {
-        int buffer_id = it->second.front().buffer_id;
-        it->second.pop();
+    if (it != client_buffers_.end() && !it->second.buffers.empty()) {
+        int buffer_id = it->second.buffers.front().buffer_id;
+        it->second.bytes -= it->second.buffers.front().length;
+        it->second.buffers.pop_front();
         releaseBuffer(buffer_id);
         LOG_DEBUG("Removed and released buffer ", buffer_id, " from client ", client_fd, "'s queue");
     }
@@ -92,9 +114,8 @@ void EPollBuffer::clearClientBuffers(int client_fd) {
     auto it = client_buffers_.find(client_fd);
     if (it != client_buffers_.end()) {
         size_t count = 0;
-        while (!it->second.empty()) {
-            releaseBuffer(it->second.front().buffer_id);
-            it->second.pop();
+        for (const IOBuffer& buffer : it->second.buffers) {
+            releaseBuffer(buffer.buffer_id);
             count++;
         }
         client_buffers_.erase(it);
@@ -102,6 +123,63 @@ void EPollBuffer::clearClientBuffers(int client_fd) {
     }
 }
 
+bool EPollBuffer::isClientQueueFull(int client_fd) const {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    auto it = client_buffers_.find(client_fd);
+    return it != client_buffers_.end() && !fits(it->second, 0);
+}
+
+bool EPollBuffer::isClientQueueDrained(int client_fd) const {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    auto it = client_buffers_.find(client_fd);
+    return it == client_buffers_.end() ||
+           (it->second.buffers.size() <= MAX_CLIENT_QUEUE_BUFFERS / 2 && it->second.bytes <= MAX_CLIENT_QUEUE_BYTES / 2);
+}
+
+EPollBuffer::Admission EPollBuffer::admitShared(int client_fd, size_t length) {
+    std::lock_guard<std::mutex> lock(client_mutex_);
+    auto it = client_buffers_.find(client_fd);
+    if (it == client_buffers_.end() || fits(it->second, length)) {
+        return Admission::ACCEPT;
+    }
+    ClientQueue& queue = it->second;
+    
+    switch (slow_consumer_) {
+        case SlowConsumerPolicy::DROP_OLDEST:
+            while (!fits(queue, length) && dropOldestShared(queue)) {
+            }
+            break;
+        case SlowConsumerPolicy::COALESCE:
+            while (dropOldestShared(queue)) {
+            }
+            break;
+        case SlowConsumerPolicy::DISCONNECT:
+            return Admission::DISCONNECT;
+        case SlowConsumerPolicy::DROP_NEWEST:
+            break;
+    }
+    // 버릴 브로드캐스트가 없으면 (에코 응답으로 찬 큐) 새 것을 버림
+    return fits(queue, length) ? Admission::ACCEPT : Admission::DROP;
+}
+
+bool EPollBuffer::dropOldestShared(ClientQueue& queue) {
+    // 일부만 쓴 맨 앞 버퍼는 버리면 스트림이 깨지므로 건너뜀
+    auto it = queue.buffers.begin();
+    if (it != queue.buffers.end() && it->write_offset > 0) {
+        ++it;
+    }
+    while (it != queue.buffers.end() && !it->droppable) {
+        ++it;
+    }
+    if (it == queue.buffers.end()) {
+        return false;
+    }
+    queue.bytes -= it->length;
+    releaseBuffer(it->buffer_id);
+    queue.buffers.erase(it);
+    return true;
+}
+
 ssize_t EPollBuffer::readToBuffer(int fd, IOBuffer& buffer) {
     if (!buffer.data || buffer.length >= buffer_size_) {
         LOG_ERROR("Invalid buffer for reading or buffer full");
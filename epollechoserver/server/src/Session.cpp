@@ -10,16 +10,18 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <sstream>
+#include <vector>
 
 // 메시지 관련 상수
 #define CHAT_MESSAGE_HEADER_SIZE sizeof(ChatMessageHeader)
 #define MAX_MESSAGE_SIZE 1021
 #define BUFFER_SIZE (CHAT_MESSAGE_HEADER_SIZE + MAX_MESSAGE_SIZE)
 
-Session::Session(int32_t id) : session_id_(id) {
+Session::Session(int32_t id, SlowConsumerPolicy slow_consumer) : session_id_(id) {
     // EPoll 인스턴스 생성
     epoll_ = std::make_unique<EPoll>();
     epoll_->initEPoll();  // 명시적 초기화 호출
+    epoll_->getBufferManager().setSlowConsumerPolicy(slow_consumer);
     
     LOG_INFO("[Session ", id, "] Created with epoll instance");
 }
@@ -62,7 +64,7 @@ std::set<int32_t> Session::getClientFds() const {
     return fds;
 }
 
-void Session::addClient(SocketPtr client_socket) {
+void Session::addClient(SocketPtr client_socket, bool room_member) {
     if (!client_socket || !client_socket->isValid()) {
         LOG_ERROR("[Session ", session_id_, "] Attempted to add invalid client socket");
         return;
@@ -75,6 +77,9 @@ void Session::addClient(SocketPtr client_socket) {
     
     // 세션의 클라이언트 목록에 추가
     client_sockets_[client_fd] = client_socket;
+    if (room_member) {
+        room_members_.insert(client_fd);
+    }
     LOG_INFO("[Session ", session_id_, "] Added client ", client_fd, ", total clients: ", client_sockets_.size());
 }
 
@@ -88,6 +93,8 @@ void Session::removeClient(SocketPtr client_socket) {
     
     // 세션의 클라이언트 목록에서 제거
     size_t count = client_sockets_.erase(client_fd);
+    room_members_.erase(client_fd);
+    paused_reads_.erase(client_fd);
     if (count > 0) {
         // EPoll에서 클라이언트 소켓 제거
         epoll_->removeEvent(client_fd);
@@ -176,6 +183,15 @@ void Session::handleRead(SocketPtr client_socket) {
     int read_attempts = 0;
     
     while (read_attempts++ < MAX_READ_ATTEMPTS) {
+        // 송신 큐가 찬 연결은 읽지 않음 (소켓 수신 버퍼가 차서 TCP 윈도우가 닫히고 상대가 보내는 속도가 늦춰짐)
+        // 엣지 트리거라 남은 데이터의 EPOLLIN은 다시 오지 않으므로 큐가 줄어들면 handleWrite가 직접 다시 읽음
+        if (buffer_manager.isClientQueueFull(client_fd)) {
+            if (paused_reads_.insert(client_fd).second) {
+                LOG_DEBUG("[Session ", session_id_, "] Send queue of client ", client_fd, " is full, pausing reads");
+            }
+            break;
+        }
+        
         // 버퍼가 없으면 이벤트 무시
         if (!buffer_manager.hasAvailableBuffers()) {
             LOG_ERROR("[Session ", session_id_, "] Read error due to no buffers on fd: ", client_fd);
@@ -228,6 +244,22 @@ void Session::handleRead(SocketPtr client_socket) {
                 LOG_DEBUG("[Session ", session_id_, "] Processing message type ", static_cast<int>(message->header.type), 
                          ", length: ", message->header.length);
                 
+                // 세션 참가/퇴장은 에코하지 않고 처리 (연결이 다른 세션으로 옮겨 가거나 닫혔으면 이 소켓의 읽기를 멈춤)
+                if (message->header.type == MessageType::CLIENT_JOIN || message->header.type == MessageType::CLIENT_LEAVE) {
+                    processMessage(client_socket, message);
+                    buffer_manager.releaseBuffer(io_buffer.buffer_id);
+                    if (client_sockets_.find(client_fd) == client_sockets_.end()) {
+                        return;
+                    }
+                    continue;
+                }
+                
+                // 방 멤버가 보낸 채팅은 다른 멤버에게 공유 버퍼 하나로 전달
+                if (message->header.type == MessageType::CLIENT_CHAT && room_members_.count(client_fd) &&
+                    room_members_.size() > 1) {
+                    broadcastMessage(client_socket, message);
+                }
+                
                 // 에코: 메시지를 복사하고 타입을 SERVER_ECHO로 변경하여 클라이언트에게 전송
                 ChatMessage echo_message;
                 echo_message.header.type = MessageType::SERVER_ECHO;  // 서버 에코 타입으로 변경
@@ -333,6 +365,13 @@ void Session::handleWrite(SocketPtr client_socket) {
             LOG_ERROR("[Session ", session_id_, "] Failed to modify events to remove EPOLLOUT");
         }
     }
+    
+    // 멈췄던 읽기는 큐가 상한의 절반 아래로 줄었을 때 재개 (멈춤/재개를 반복하지 않도록)
+    if (paused_reads_.count(client_fd) && buffer_manager.isClientQueueDrained(client_fd)) {
+        paused_reads_.erase(client_fd);
+        LOG_DEBUG("[Session ", session_id_, "] Send queue of client ", client_fd, " drained, resuming reads");
+        handleRead(client_socket);
+    }
 }
 
 void Session::handleClose(SocketPtr client_socket) {
@@ -352,6 +391,8 @@ void Session::handleClose(SocketPtr client_socket) {
         
         // 세션에서 클라이언트 제거
         client_sockets_.erase(client_fd);
+        room_members_.erase(client_fd);
+        paused_reads_.erase(client_fd);
         
         // 소켓 자원 정리
         if (epoll_) {
@@ -444,27 +485,27 @@ void Session::handleJoinSession(SocketPtr client_socket, const ChatMessage* mess
     LOG_INFO("[Session ", session_id_, "] Client ", client_socket->getSocketFd(), " requested JOIN");
     
     try {
-        // 이미 이 세션에 있는지 확인
         int32_t client_fd = client_socket->getSocketFd();
-        auto it = client_sockets_.find(client_fd);
+        int32_t target_session_id = session_id_;
+        if (message->header.length >= sizeof(int32_t)) {
+            memcpy(&target_session_id, message->data, sizeof(int32_t));
+        }
         
-        if (it != client_sockets_.end()) {
-            // 이미 세션에 속해 있음
-            LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " already in this session");
-            
+        if (target_session_id == session_id_) {
+            // 이미 이 세션에 있으면 연결은 그대로 두고 채팅방에 참가
             std::stringstream ss;
-            ss << "Already in session " << session_id_;
+            if (!room_members_.insert(client_fd).second) {
+                LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " already in this session");
+                ss << "Already in session " << session_id_;
+            } else {
+                ss << "Joined session " << session_id_;
+            }
             std::string msg = ss.str();
             sendMessage(client_socket, MessageType::SERVER_ACK, msg.c_str(), msg.length());
             return;
         }
         
         // 대상 세션으로 이동 처리
-        int32_t target_session_id = session_id_;
-        if (message->header.length >= sizeof(int32_t)) {
-            memcpy(&target_session_id, message->data, sizeof(int32_t));
-        }
-        
         onClientJoinSession(client_socket, target_session_id);
     } catch (const std::exception& e) {
         LOG_ERROR("[Session ", session_id_, "] Error handling JOIN: ", e.what());
@@ -510,25 +551,51 @@ void Session::broadcastMessage(SocketPtr sender_socket, const ChatMessage* messa
     }
     
     int32_t sender_fd = sender_socket->getSocketFd();
+    EPollBuffer& buffer_manager = epoll_->getBufferManager();
     
-    // 메시지 복사하여 서버 메시지로 변환
-    ChatMessage broadcast_msg;
-    broadcast_msg.header.type = MessageType::SERVER_CHAT;
-    broadcast_msg.header.length = message->header.length;
-    memcpy(broadcast_msg.data, message->data, message->header.length);
+    // 서버 메시지를 버퍼 하나에 한 번만 만들고 수신자마다 참조를 잡아 같은 버퍼를 큐에 넣음
+    IOBuffer shared = buffer_manager.allocateBuffer();
+    if (!shared.data) {
+        LOG_ERROR("[Session ", session_id_, "] No buffer for broadcast from client ", sender_fd);
+        return;
+    }
+    buffer_manager.makeMessage(shared, MessageType::SERVER_CHAT, message->data, message->header.length);
+    
+    // 방의 다른 멤버에게 전송 (송신자 제외, 송신 큐가 찬 멤버는 느린 수신자 정책대로 처리)
+    size_t delivered = 0;
+    size_t dropped = 0;
+    std::vector<SocketPtr> slow_consumers;
+    for (const int32_t fd : room_members_) {
+        auto it = client_sockets_.find(fd);
+        if (fd != sender_fd && it != client_sockets_.end() && it->second && it->second->isValid()) {
+            switch (buffer_manager.admitShared(fd, shared.length)) {
+                case EPollBuffer::Admission::ACCEPT:
+                    if (epoll_->prepareWriteShared(fd, shared)) {
+                        ++delivered;
+                    }
+                    break;
+                case EPollBuffer::Admission::DROP:
+                    ++dropped;
+                    break;
+                case EPollBuffer::Admission::DISCONNECT:
+                    slow_consumers.push_back(it->second);
+                    break;
+            }
+        }
+    }
     
-    size_t total_size = CHAT_MESSAGE_HEADER_SIZE + message->header.length;
+    // 만든 쪽의 참조를 놓음 (마지막 수신자의 쓰기가 끝나면 풀로 반환)
+    buffer_manager.releaseBuffer(shared.buffer_id);
     
-    // 모든 클라이언트에게 전송 (송신자 제외)
-    for (const auto& [fd, client_socket] : client_sockets_) {
-        if (fd != sender_fd && client_socket && client_socket->isValid()) {
-            // EPoll을 통해 쓰기 작업 수행 (버퍼는 즉시 해제됨)
-            epoll_->prepareWrite(fd, &broadcast_msg, total_size);
-        }
+    // 멤버 목록을 도는 동안에는 닫지 않고 끝난 뒤에 닫음
+    for (const auto& socket : slow_consumers) {
+        LOG_WARN("[Session ", session_id_, "] Send queue of client ", socket->getSocketFd(),
+                 " full, disconnecting slow consumer");
+        handleClose(socket);
     }
     
     LOG_DEBUG("[Session ", session_id_, "] Broadcasted message from client ", sender_fd, 
-               " to ", client_sockets_.size() - 1, " other clients");
+               " to ", delivered, " other clients (dropped for ", dropped, ", disconnected ", slow_consumers.size(), ")");
 }
 
 void Session::onClientJoinSession(SocketPtr client_socket, int32_t target_session_id) {
@@ -556,7 +623,7 @@ void Session::onClientJoinSession(SocketPtr client_socket, int32_t target_sessio
         sessionManager.removeSession(client_fd);
         
         // 새 세션에 클라이언트 추가
-        targetSession->addClient(client_socket);
+        targetSession->addClient(client_socket, true);
         
         LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " moved to session ", target_session_id);
     }
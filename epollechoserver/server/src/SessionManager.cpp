@@ -40,7 +40,7 @@ void SessionManager::initialize() {
     
     for (unsigned int i = 0; i < num_sessions; ++i) {
         int32_t session_id = static_cast<int32_t>(next_session_id_++);
-        auto session = std::make_shared<Session>(session_id);
+        auto session = std::make_shared<Session>(session_id, slow_consumer_);
         sessions_[session_id] = session;
         available_sessions_.push_back(session_id);
         LOG_DEBUG("[SessionManager] Created session ", session_id);
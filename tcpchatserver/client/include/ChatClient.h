@@ -2,6 +2,7 @@
 #include "Context.h"
 #include <string>
 #include <functional>
+#include <vector>
 
 class ChatClient {
 public:
@@ -14,7 +15,11 @@ public:
     // 기본 기능
     bool joinSession(int32_t sessionId);
     bool leaveSession();
-    bool sendChat(const std::string& message);
+    bool sendChat(const std::string& message, uint8_t flags = FRAME_FLAG_NONE);
+    bool sendCommand(const std::string& command);
+    
+    // v2 프레임 사용 (64 KB까지의 메시지, 첫 v2 프레임부터 서버 응답도 v2)
+    void setProtocolV2(bool enabled) { protocolV2_ = enabled; }
     
     // 콜백 설정
     using MessageCallback = std::function<void(const std::string&)>;
@@ -24,10 +29,12 @@ public:
 private:
     int socket_;
     bool running_;
+    bool protocolV2_{false};
+    std::vector<uint8_t> readBuffer_;  // 수신 프레임 버퍼 (v2 최대 프레임까지 늘어남)
  
     MessageCallback messageCallback_;
     
     void mainLoop();
-    bool sendMessage(MessageType type, const void* data, size_t length);
-    void handleMessage(const ChatMessage& message);
+    bool sendMessage(MessageType type, const void* data, size_t length, uint8_t flags = FRAME_FLAG_NONE);
+    void handleMessage(const FrameHeader& header, const uint8_t* payload);
 }; 
\ No newline at end of file
@@ -4,17 +4,21 @@
 #include <thread>
 #include <atomic>
 #include <chrono>
+#include <cstdlib>
 
 void printHelp() {
     std::cout << "\n사용 가능한 명령어:\n"
               << "/echo <메시지> - 에코 테스트\n"
+              << "/join <방> - 채팅방 참가 (이후 채팅은 방의 다른 멤버에게도 전달)\n"
+              << "/big <바이트 수> - 큰 바이너리 메시지 에코 테스트 (v2 모드)\n"
+              << "/announce <토큰> <메시지> - 서버의 모든 연결에 공지 (서버의 --announce-token 필요)\n"
               << "/quit - 프로그램 종료\n"
               << "/help - 도움말 보기\n" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 3) {
-        std::cout << "사용법: " << argv[0] << " <서버IP> <포트>" << std::endl;
+    if (argc != 3 && !(argc == 4 && std::string(argv[3]) == "v2")) {
+        std::cout << "사용법: " << argv[0] << " <서버IP> <포트> [v2]" << std::endl;
         return 1;
     }
 
@@ -23,6 +27,7 @@ int main(int argc, char* argv[]) {
     setvbuf(stdout, nullptr, _IONBF, 0);
 
     ChatClient client;
+    client.setProtocolV2(argc == 4);
     std::atomic<bool> running(true);
 
     // 콜백 설정
@@ -72,6 +77,31 @@ int main(int argc, char* argv[]) {
                 } else {
                     std::cout << "사용법: /echo <메시지>" << std::endl;
                 }
+            } else if (cmd.substr(0, 4) == "join") {
+                // /join 명령어 처리
+                if (cmd.length() > 5) {
+                    int32_t room_id = static_cast<int32_t>(std::strtol(cmd.c_str() + 5, nullptr, 10));
+                    std::cout << "채팅방 참가 요청: " << room_id << std::endl;
+                    client.joinSession(room_id);
+                } else {
+                    std::cout << "사용법: /join <방>" << std::endl;
+                }
+            } else if (cmd.substr(0, 8) == "announce") {
+                // /announce 명령어 처리: 서버 전체 공지 (CLIENT_COMMAND "announce <토큰> <메시지>")
+                if (cmd.length() > 9) {
+                    client.sendCommand("announce " + cmd.substr(9));
+                } else {
+                    std::cout << "사용법: /announce <토큰> <메시지>" << std::endl;
+                }
+            } else if (cmd.substr(0, 3) == "big") {
+                // /big 명령어 처리: 지정한 크기의 바이너리 페이로드를 v2 프레임으로 전송
+                size_t size = cmd.length() > 4 ? std::strtoul(cmd.c_str() + 4, nullptr, 10) : 0;
+                if (size > 0) {
+                    std::cout << "큰 메시지 에코 테스트 전송: " << size << " bytes" << std::endl;
+                    client.sendChat(std::string(size, 'x'), FRAME_FLAG_BINARY);
+                } else {
+                    std::cout << "사용법: /big <바이트 수>" << std::endl;
+                }
             } else {
                 std::cout << "알 수 없는 명령어입니다. /help를 입력하여 도움말을 확인하세요." << std::flush;
             }
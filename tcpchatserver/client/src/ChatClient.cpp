@@ -54,7 +54,6 @@ void ChatClient::mainLoop() {
     fd_set readfds;
     struct timeval tv;
     char buffer[1024];
-    uint8_t readBuffer[1024]; // 수신 버퍼 
 
     while (running_) {
         FD_ZERO(&readfds);
@@ -77,35 +76,40 @@ void ChatClient::mainLoop() {
 
         // 소켓으로부터 데이터 수신
         if (FD_ISSET(socket_, &readfds)) {
-            // 먼저 헤더만 읽어서 메시지 길이 확인
-            ChatMessageHeader header;
-            ssize_t headerBytesRead = recv(socket_, &header, sizeof(header), MSG_PEEK);
+            // 먼저 헤더만 읽어서 메시지 길이 확인 (v2 헤더는 길이 varint에 따라 3~5바이트)
+            uint8_t headerBytes[MAX_FRAME_HEADER_SIZE];
+            ssize_t headerBytesRead = recv(socket_, headerBytes, sizeof(headerBytes), MSG_PEEK);
             
             if (headerBytesRead <= 0) {
                 break; // 연결 종료 또는 오류
             }
             
-            if (headerBytesRead < sizeof(header)) {
+            FrameHeader header{};
+            const int parsed = parseFrameHeader(headerBytes, static_cast<size_t>(headerBytesRead), header);
+            if (parsed == 0) {
                 continue; // 헤더가 완전히 도착하지 않음, 다음 루프에서 다시 시도
             }
             
             // 헤더의 length 필드 검증
-            if (header.length > MAX_MESSAGE_SIZE) {
-                std::string error_msg = "비정상 메시지 수신: type=" + std::to_string(static_cast<int>(header.type)) + 
+            if (parsed < 0) {
+                std::string error_msg = "비정상 메시지 수신: type=" + std::to_string(static_cast<int>(headerBytes[0])) + 
                     ", length=" + std::to_string(header.length) + 
-                    " (최대 허용=" + std::to_string(MAX_MESSAGE_SIZE) + ")";
+                    " (최대 허용=" + std::to_string(header.v2 ? MAX_V2_MESSAGE_SIZE : MAX_MESSAGE_SIZE) + ")";
                 std::cerr << error_msg << std::endl;
                 
                 // 유효하지 않은 데이터 건너뛰기 
-                recv(socket_, readBuffer, sizeof(header), 0);
+                recv(socket_, headerBytes, static_cast<size_t>(headerBytesRead), 0);
                 continue;
             }
             
             // 실제 메시지 크기 계산
-            size_t totalMessageSize = sizeof(header) + header.length;
+            size_t totalMessageSize = header.size + header.length;
+            if (readBuffer_.size() < totalMessageSize) {
+                readBuffer_.resize(totalMessageSize);
+            }
             
-            // 전체 메시지 읽기
-            ssize_t bytesRead = recv(socket_, readBuffer, totalMessageSize, 0);
+            // 전체 메시지 읽기 (큰 v2 프레임은 여러 세그먼트로 나뉘어 도착하므로 모두 받을 때까지 대기)
+            ssize_t bytesRead = recv(socket_, readBuffer_.data(), totalMessageSize, MSG_WAITALL);
             if (bytesRead <= 0) {
                 break;
             }
@@ -116,12 +120,7 @@ void ChatClient::mainLoop() {
                 continue;
             }
             
-            // 메시지 구조체로 변환
-            ChatMessage message;
-            memcpy(&message.header, readBuffer, sizeof(header));
-            memcpy(message.data, readBuffer + sizeof(header), message.header.length);
-            
-            handleMessage(message);
+            handleMessage(header, readBuffer_.data() + header.size);
         }
 
         // 표준 입력 처리 (필요한 경우)
@@ -148,37 +147,40 @@ bool ChatClient::leaveSession() {
     return sendMessage(MessageType::CLIENT_LEAVE, nullptr, 0);
 }
 
-bool ChatClient::sendChat(const std::string& message) {
-    return sendMessage(MessageType::CLIENT_CHAT, message.c_str(), message.length());
+bool ChatClient::sendChat(const std::string& message, uint8_t flags) {
+    return sendMessage(MessageType::CLIENT_CHAT, message.c_str(), message.length(), flags);
+}
+
+bool ChatClient::sendCommand(const std::string& command) {
+    return sendMessage(MessageType::CLIENT_COMMAND, command.c_str(), command.length());
 }
 
-bool ChatClient::sendMessage(MessageType type, const void* data, size_t length) {
+bool ChatClient::sendMessage(MessageType type, const void* data, size_t length, uint8_t flags) {
     if (socket_ < 0 || !running_) {
         return false;
     }
 
     // 데이터 크기 검증
-    if (length > MAX_MESSAGE_SIZE) {
-        std::cerr << "메시지 크기 초과: " << length << " > " << MAX_MESSAGE_SIZE << std::endl;
+    const size_t maxSize = protocolV2_ ? MAX_V2_MESSAGE_SIZE : MAX_MESSAGE_SIZE;
+    if (length > maxSize) {
+        std::cerr << "메시지 크기 초과: " << length << " > " << maxSize << std::endl;
         return false;
     }
 
-    // 실제 전송 크기 계산
-    size_t totalSize = sizeof(ChatMessageHeader) + length;
-    
     // 버퍼 할당 및 메시지 구성
-    uint8_t* buffer = new uint8_t[totalSize];
-    ChatMessageHeader* header = reinterpret_cast<ChatMessageHeader*>(buffer);
-    header->type = type;
-    header->length = static_cast<uint16_t>(length);
+    uint8_t* buffer = new uint8_t[MAX_FRAME_HEADER_SIZE + length];
+    const size_t headerSize = encodeFrameHeader(buffer, type, flags, static_cast<uint32_t>(length), protocolV2_);
+    
+    // 실제 전송 크기 계산
+    size_t totalSize = headerSize + length;
     
     // 데이터 복사
     if (data && length > 0) {
-        memcpy(buffer + sizeof(ChatMessageHeader), data, length);
+        memcpy(buffer + headerSize, data, length);
     }
     
     // 전송
-    ssize_t bytesSent = send(socket_, buffer, totalSize, 0);
+    ssize_t bytesSent = send(socket_, buffer, totalSize, MSG_WAITALL);
     delete[] buffer;
     
     if (bytesSent != static_cast<ssize_t>(totalSize)) {
@@ -189,12 +191,16 @@ bool ChatClient::sendMessage(MessageType type, const void* data, size_t length)
     return true;
 }
 
-void ChatClient::handleMessage(const ChatMessage& message) {
-    std::string messageData(message.data, message.header.length);
+void ChatClient::handleMessage(const FrameHeader& header, const uint8_t* payload) {
+    std::string messageData(reinterpret_cast<const char*>(payload), header.length);
     
-    switch (message.header.type) {
+    switch (header.type) {
         case MessageType::SERVER_ECHO: {
             // 에코 메시지 (클라이언트가 보낸 메시지를 서버가 그대로 돌려보냄)
+            // 큰 메시지나 바이너리 페이로드는 내용 대신 크기만 출력
+            if ((header.flags & FRAME_FLAG_BINARY) || header.length > MAX_MESSAGE_SIZE) {
+                messageData = "<" + std::to_string(header.length) + " bytes>";
+            }
             if (messageCallback_) {
                 messageCallback_("에코: " + messageData);
             } else {
@@ -203,6 +209,19 @@ void ChatClient::handleMessage(const ChatMessage& message) {
             break;
         }
             
+        case MessageType::SERVER_CHAT: {
+            // 같은 세션 방의 다른 멤버가 보낸 메시지
+            if ((header.flags & FRAME_FLAG_BINARY) || header.length > MAX_MESSAGE_SIZE) {
+                messageData = "<" + std::to_string(header.length) + " bytes>";
+            }
+            if (messageCallback_) {
+                messageCallback_("[채팅] " + messageData);
+            } else {
+                std::cout << "[채팅] " << messageData << std::endl;
+            }
+            break;
+        }
+            
         case MessageType::SERVER_NOTIFICATION: {
             // 서버 알림 (세션 참가 등)
             if (messageCallback_) {
@@ -215,7 +234,7 @@ void ChatClient::handleMessage(const ChatMessage& message) {
             
         default: {
             // 다른 메시지 타입은 단순히 로깅
-            std::string log_msg = "메시지 타입 " + std::to_string(static_cast<int>(message.header.type)) + ": " + messageData;
+            std::string log_msg = "메시지 타입 " + std::to_string(static_cast<int>(header.type)) + ": " + messageData;
             if (messageCallback_) {
                 messageCallback_(log_msg);
             } else {
@@ -2,6 +2,7 @@
 #include <liburing.h>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
 
 #pragma pack(push, 1)  // 1바이트 정렬 시작
 
@@ -24,16 +25,47 @@ enum class OperationType : uint8_t {
     ACCEPT = 1,
     READ = 2,
     WRITE = 3,
-    CLOSE = 4
+    CLOSE = 4,
+    WAKEUP = 5,   // 세션 웨이크업 eventfd 폴링
+    SEND_FD = 6,  // 다른 링으로 고정 파일 전달 (IORING_OP_MSG_RING, 송신 측 완료)
+    RECV_FD = 7,  // 다른 링에서 전달받은 고정 파일 (수신 측 CQE)
+    SEND_ZC = 8,  // 제로 카피 전송 (전송 결과 CQE + IORING_CQE_F_NOTIF 알림 CQE)
+    WRITE_FIXED = 9,  // 등록 송신 버퍼 풀에서 전송 (buffer_idx = 풀 슬롯, 완료 CQE에서 슬롯 반환)
+    SEND_SKIP = 10,   // IOSQE_CQE_SKIP_SUCCESS 고정 버퍼 전송 (실패 시에만 CQE, 성공은 CQ를 지나간 뒤 확인)
+    CANCEL = 11,      // 멀티샷 recv 취소 (IOSQE_CQE_SKIP_SUCCESS, 실패 시에만 CQE)
+    SEND_CLIENT = 12, // 다른 링으로 일반 fd 번호 전달 (IORING_OP_MSG_RING, 송신 측은 실패 시에만 CQE)
+    RECV_CLIENT = 13, // 다른 링에서 전달받은 일반 fd (수신 측 CQE, res = fd)
+    SEND_MIGRATION = 14,  // CLIENT_JOIN 세션 이동 알림 (IORING_OP_MSG_RING, 송신 측은 실패 시에만 CQE)
+    RECV_MIGRATION = 15,  // 세션 이동 알림 수신 (대상 링 CQE, 연결 상태는 대상 세션의 대기열에 있음)
+    RECV_MIGRATION_FD = 16, // 세션 이동으로 전달받은 고정 파일 (대상 링 CQE, res = 새 슬롯, client_fd = 이동 티켓)
+    SEND_VECTOR = 17,     // 송신 풀 슬롯 여러 개를 sendmsg 한 번으로 전송 (buffer_idx = 벡터 전송 레코드)
+    SEND_ROOM = 18,       // 다른 세션 방 수신함 알림 (IORING_OP_MSG_RING, 송신 측은 실패 시에만 CQE, buffer_idx = 대상 세션)
+    RECV_ROOM = 19,       // 방 수신함 알림 수신 (대상 링 CQE, 메시지는 대상 세션의 수신함에 있음)
+    HISTORY_SYNC = 20     // 방 히스토리 세그먼트 fdatasync (그룹 커밋, buffer_idx = 세션의 동기화 태그)
 };
 
 // 서버 내부에서 사용하는 작업 컨텍스트
+// 고정 파일(direct descriptor) 모드에서는 client_fd에 fd 대신 고정 파일 슬롯 번호가 들어감
 struct Operation {
     int32_t client_fd;        // 4 bytes
     OperationType op_type;    // 1 byte
     uint16_t buffer_idx;      // 2 bytes
 };
 
+// Operation 컨텍스트를 user_data(64비트) 값으로 인코딩 (getContext와 동일한 배치)
+inline uint64_t makeContext(OperationType type, int32_t client_fd, uint16_t buffer_idx) {
+    uint64_t user_data = 0;
+    auto* buffer = reinterpret_cast<uint8_t*>(&user_data);
+    
+    *(reinterpret_cast<int32_t*>(buffer)) = client_fd;
+    buffer += 4;
+    *buffer = static_cast<uint8_t>(type);
+    buffer += 1;
+    *(reinterpret_cast<uint16_t*>(buffer)) = buffer_idx;
+    
+    return user_data;
+}
+
 // io_uring_cqe에서 Operation 컨텍스트를 추출하는 인라인 함수
 inline Operation getContext(io_uring_cqe* cqe) {
     Operation ctx{};
@@ -79,4 +111,81 @@ struct ChatMessage {
 #pragma pack(pop)   // 정렬 설정 복원
 
 static constexpr size_t MAX_MESSAGE_SIZE = 1021;  // 최대 데이터 크기
-static constexpr size_t CHAT_MESSAGE_HEADER_SIZE = sizeof(ChatMessageHeader);  // 헤더 크기
\ No newline at end of file
+static constexpr size_t CHAT_MESSAGE_HEADER_SIZE = sizeof(ChatMessageHeader);  // 헤더 크기
+
+// 프로토콜 v2 프레임: [type | FRAME_V2_BIT][flags][페이로드 길이 varint (LEB128, 1~3바이트)][페이로드]
+// v1 메시지 타입은 모두 0x80 미만이므로 첫 바이트로 프레임 버전을 구분 (같은 포트에서 v1/v2 연결 공존)
+// 클라이언트가 v2 프레임을 한 번 보내면 서버는 그 연결의 응답을 v2로 보냄
+static constexpr uint8_t FRAME_V2_BIT = 0x80;
+static constexpr size_t MAX_V2_MESSAGE_SIZE = 65536;  // v2 최대 페이로드 (64 KB)
+static constexpr size_t MAX_FRAME_HEADER_SIZE = 5;    // type + flags + varint 3바이트
+
+// v2 헤더 flags (서버는 해석하지 않고 에코/전달하는 프레임에 그대로 실어 보냄)
+enum FrameFlags : uint8_t {
+    FRAME_FLAG_NONE = 0x00,
+    FRAME_FLAG_BINARY = 0x01     // 페이로드가 텍스트가 아님 (붙여 넣은 로그, 작은 첨부 파일 등)
+};
+
+// v1/v2 공통으로 해석한 프레임 헤더
+struct FrameHeader {
+    MessageType type;
+    uint8_t flags;
+    bool v2;
+    uint8_t size;                // 헤더 바이트 수 (v1: 3, v2: 3~5)
+    uint32_t length;             // 페이로드 길이
+};
+
+// 헤더 해석: 완성되면 1, 바이트가 더 필요하면 0, 형식 오류(길이 상한 초과 등)면 -1
+inline int parseFrameHeader(const uint8_t* data, size_t available, FrameHeader& header) {
+    if (available == 0) {
+        return 0;
+    }
+    if (!(data[0] & FRAME_V2_BIT)) {
+        if (available < CHAT_MESSAGE_HEADER_SIZE) {
+            return 0;
+        }
+        uint16_t length;
+        memcpy(&length, data + 1, sizeof(length));
+        header = FrameHeader{static_cast<MessageType>(data[0]), FRAME_FLAG_NONE, false,
+                             static_cast<uint8_t>(CHAT_MESSAGE_HEADER_SIZE), length};
+        return length <= MAX_MESSAGE_SIZE ? 1 : -1;
+    }
+    
+    uint32_t length = 0;
+    for (size_t i = 0; i < MAX_FRAME_HEADER_SIZE - 2; ++i) {
+        if (available < i + 3) {
+            return 0;
+        }
+        const uint8_t byte = data[2 + i];
+        length |= static_cast<uint32_t>(byte & 0x7F) << (7 * i);
+        if (!(byte & 0x80)) {
+            header = FrameHeader{static_cast<MessageType>(data[0] & ~FRAME_V2_BIT), data[1], true,
+                                 static_cast<uint8_t>(i + 3), length};
+            return length <= MAX_V2_MESSAGE_SIZE ? 1 : -1;
+        }
+    }
+    return -1;
+}
+
+// 헤더를 out에 기록하고 바이트 수 반환 (out은 MAX_FRAME_HEADER_SIZE 이상, v1은 length <= MAX_MESSAGE_SIZE)
+inline size_t encodeFrameHeader(uint8_t* out, MessageType type, uint8_t flags, uint32_t length, bool v2) {
+    if (!v2) {
+        const uint16_t length16 = static_cast<uint16_t>(length);
+        out[0] = static_cast<uint8_t>(type);
+        memcpy(out + 1, &length16, sizeof(length16));
+        return CHAT_MESSAGE_HEADER_SIZE;
+    }
+    
+    out[0] = static_cast<uint8_t>(type) | FRAME_V2_BIT;
+    out[1] = flags;
+    size_t size = 2;
+    do {
+        uint8_t byte = length & 0x7F;
+        length >>= 7;
+        if (length) {
+            byte |= 0x80;
+        }
+        out[size++] = byte;
+    } while (length);
+    return size;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <atomic>
+#include <liburing.h>
+
+/**
+ * @brief 링별 고정 파일(direct descriptor) 테이블의 슬롯 관리자
+ *
+ * 희소(sparse) 파일 테이블을 등록하고 슬롯 사용 상태를 추적합니다.
+ * 슬롯 번호 자체는 커널이 IORING_FILE_INDEX_ALLOC으로 고르지만, 커널 할당이
+ * 실패(-ENFILE)하지 않도록 사용 전에 reserve()로 용량을 예약합니다.
+ *
+ * reserve()/unreserve()는 다른 스레드(Listener)에서 호출할 수 있고,
+ * commit()/release()는 링을 소유한 스레드에서만 호출합니다.
+ */
+class FixedFileTable {
+public:
+    FixedFileTable(io_uring* ring, unsigned num_slots);
+    ~FixedFileTable();
+
+    // 등록할 테이블 크기를 RLIMIT_NOFILE 이하로 제한 (커널이 초과 등록을 -EMFILE로 거부)
+    static unsigned clampToFileLimit(unsigned num_slots);
+
+    // 슬롯 하나의 용량을 예약 (테이블이 가득 차면 false)
+    bool reserve();
+    // 전달이 실패하여 예약한 용량을 되돌림
+    void unreserve();
+
+    // 커널이 할당한 슬롯을 사용 중으로 기록 (예약되지 않은 경우 예약도 함께 수행)
+    bool commit(unsigned slot, bool reserved = true);
+    // close_direct 완료 후 슬롯을 반환
+    void release(unsigned slot);
+
+    unsigned capacity() const { return num_slots_; }
+    unsigned used() const { return used_.load(std::memory_order_relaxed); }
+    unsigned available() const { return num_slots_ - used(); }
+
+    FixedFileTable(const FixedFileTable&) = delete;
+    FixedFileTable& operator=(const FixedFileTable&) = delete;
+
+private:
+    io_uring* ring_;                    // io_uring 인스턴스 (소유권 없음)
+    const unsigned num_slots_;          // 등록된 슬롯 수
+    std::atomic<unsigned> used_{0};     // 예약 + 사용 중인 슬롯 수
+    std::vector<uint8_t> in_use_;       // 슬롯별 사용 여부 (소유 스레드 전용)
+};
@@ -3,52 +3,237 @@
 #include <memory>
 #include <atomic>
 #include "UringBuffer.h"
+#include "FixedFileTable.h"
+#include "SendBufferPool.h"
 #include "Context.h"
 #include <vector>
 #include <mutex>
 #include <unordered_map>
+#include <deque>
+
+// 링 생성 옵션 (기본값은 플래그 없는 일반 링)
+struct RingOptions {
+    bool sqpoll = false;              // IORING_SETUP_SQPOLL
+    unsigned sq_thread_idle_ms = 1000;  // 폴러 스레드 유휴 대기 시간
+    int sq_thread_cpu = -1;           // 폴러 고정 CPU (-1: 고정 안 함, IORING_SETUP_SQ_AFF)
+    int attach_wq_fd = -1;            // 폴러/io-wq를 공유할 부모 링 fd (IORING_SETUP_ATTACH_WQ)
+    bool single_issuer = false;       // SINGLE_ISSUER | DEFER_TASKRUN | COOP_TASKRUN (activate() 필요)
+    bool register_ring_fd = false;    // 소유 스레드에서 io_uring_register_ring_fd 호출
+    unsigned fixed_file_slots = 0;    // >0이면 고정 파일 테이블을 등록하고 클라이언트 I/O를 슬롯 번호로 수행
+    unsigned sq_entries = 0;          // SQ 크기 (0: NUM_SUBMISSION_QUEUE_ENTRIES)
+    unsigned cq_entries = 0;          // CQ 크기 (0: 커널 기본값 2 x SQ, >0이면 IORING_SETUP_CQSIZE)
+    bool auto_resize = false;         // 연결 수에 맞춰 CQ를 런타임에 확장 (IORING_REGISTER_RESIZE_RINGS, DEFER_TASKRUN 링 전용)
+    bool provided_buffers = true;     // recv용 provided buffer ring 등록 여부
+    unsigned iowq_max_bounded = 0;    // activate()에서 적용할 io-wq 워커 상한 (0: 변경 안 함)
+    unsigned iowq_max_unbounded = 0;
+    int iowq_cpu = -1;                // activate()에서 적용할 io-wq CPU 친화도 (-1: 변경 안 함)
+    unsigned send_zc_threshold = 0;   // 이 크기 이상의 응답은 IORING_OP_SEND_ZC로 전송 (0: 항상 복사 write)
+    unsigned send_pool_slots = 0;     // >0이면 송신 전용 등록 버퍼 풀을 만들고 write_fixed로 전송
+    bool send_skip_success = false;   // 풀 전송에 IOSQE_CQE_SKIP_SUCCESS 적용 (실패한 전송만 CQE를 올림)
+    bool recv_bundle = false;         // 멀티샷 recv에 IORING_RECVSEND_BUNDLE 적용 (CQE 하나가 연속 버퍼 여러 개를 덮음)
+    bool recv_incremental = false;    // 큰 provided buffer를 IOU_PBUF_RING_INC로 등록해 여러 recv가 이어서 채움 (송신 풀 필요)
+    unsigned recv_buffer_size = 0;    // 증분 모드 버퍼 크기 (0: UringBuffer::INCREMENTAL_BUFFER_SIZE)
+    unsigned recv_buffer_count = 0;   // 증분 모드 버퍼 개수 (0: UringBuffer::NUM_INCREMENTAL_BUFFERS)
+    unsigned recv_buffers = 0;        // 기본 그룹에 처음 올릴 버퍼 수 (0: recv_buffer_cap 전부)
+    unsigned recv_buffer_cap = 0;     // 기본 그룹 버퍼 상한, 링 엔트리 수 (0: UringBuffer::NUM_IO_BUFFERS)
+    bool buffer_debug = false;        // 배치마다 PARSER 상태로 남은 recv 버퍼(누수)를 검사하고 회수
+    bool recv_size_classes = false;   // 크기별 버퍼 그룹(RECV_BUFFER_CLASSES)을 등록하고 연결마다 그룹을 골라 recv (송신 풀 필요)
+};
+
+// 크기별 recv 버퍼 그룹 (작은 것부터, 1 KB 클래스는 기본 버퍼 그룹과 같음)
+struct RecvBufferClass {
+    unsigned buffer_size;
+    uint16_t num_buffers;
+};
 
 class IOUring {
 public:
+    static constexpr unsigned MAX_SEND_VECTOR = 64;  // 벡터 전송 하나가 묶는 최대 iovec 수 (송신 풀 슬롯 64 KB, v2 큰 프레임 하나)
     static constexpr unsigned NUM_SUBMISSION_QUEUE_ENTRIES = 8192;
     static constexpr unsigned CQE_BATCH_SIZE = 512;
     static constexpr unsigned NUM_WAIT_ENTRIES = 1;
-    IOUring();
+    static constexpr unsigned MIN_SUBMISSION_QUEUE_ENTRIES = 256;
+    static constexpr unsigned MAX_COMPLETION_QUEUE_ENTRIES = 65536;  // 커널 IORING_MAX_CQ_ENTRIES
+    static constexpr unsigned CQES_PER_CONNECTION = 4;             // 연결당 동시에 대기할 수 있는 CQE (recv/write/close 여유분)
+    static constexpr RecvBufferClass RECV_BUFFER_CLASSES[] = {
+        {128, 8192},     // 접속 알림, 짧은 채팅 (1 MB)
+        {1024, 4096},    // 기본 그룹 (4 MB)
+        {16384, 256},    // 최대 크기에 가까운 프레임 (4 MB)
+    };
+
+    // 예상 연결 수로부터 SQ/CQ 크기 계산 (2의 거듭제곱, SQ <= NUM_SUBMISSION_QUEUE_ENTRIES)
+    static unsigned submissionEntriesFor(size_t connections);
+    static unsigned completionEntriesFor(size_t connections, unsigned sq_entries);
+
+    explicit IOUring(const RingOptions& options = RingOptions{});
     ~IOUring();
 
+    // 링을 구동할 스레드에서 한 번 호출 (비활성 링 활성화, 링 fd/버퍼 링 등록, io-wq 설정)
+    void activate();
+
     // IO 준비 메서드
     void prepareAccept(int socket_fd);
-    void prepareRead(int client_fd);
+    void prepareWakeup(int event_fd);
+    // poll_first: 소켓이 비어 있을 가능성이 높으면 recv 시도 없이 poll부터 등록 (IORING_RECVSEND_POLL_FIRST)
+    // recv_class: 버퍼를 고를 크기 클래스 (READ 컨텍스트의 buffer_idx에 기록되어 CQE에서 그룹을 찾는 데 쓰임)
+    void prepareRead(int client_fd, bool poll_first = false, unsigned recv_class = 0);
+    // 진행 중인 멀티샷 recv 취소 (recv는 -ECANCELED로 끝나므로 다른 클래스로 다시 등록할 수 있음)
+    void prepareCancelRead(int client_fd, unsigned recv_class);
+    // recv 버퍼 bid에 만든 응답 전송 (호출자가 버퍼를 SENDING으로 기록해 두어야 함, 큰 응답은 SEND_ZC)
     void prepareWrite(int client_fd, const void* buf, unsigned len, uint16_t bid);
     void prepareClose(int client_fd);
+    // 송신 풀 슬롯에 담긴 len 바이트를 전송 (skip_success면 성공 CQE를 생략하는 고정 버퍼 send, 아니면 write_fixed)
+    // 슬롯은 호출자(송신 큐)가 소유하며, 생략된 성공은 takeConfirmedSends()로 전달됨
+    void prepareSendFromPool(int client_fd, uint16_t slot, unsigned len, bool skip_success);
+    // iovec count개를 순서대로 sendmsg 한 번에 전송 (항상 완료 CQE가 옴, 반환값은 CQE의 buffer_idx인 레코드 번호)
+    // 가리키는 메모리(송신 풀 슬롯, recv 버퍼)는 호출자가 완료 CQE까지 유지
+    uint16_t prepareSendVector(int client_fd, const iovec* iov, unsigned count);
+    // SEND_VECTOR CQE 처리: msghdr/iovec 레코드를 재사용 목록에 반환
+    void releaseSendVector(uint16_t record);
+    // 일반 fd 번호를 다른 링으로 전달 (대상 링은 res = client_fd인 RECV_CLIENT CQE를 받음, tag는 송신 측 실패 CQE용)
+    void prepareSendClient(int target_ring_fd, int client_fd, uint16_t tag);
+    // 세션 이동 알림: 대상 링에 RECV_MIGRATION CQE를 올려 대기열에 넣은 연결을 가져가게 함
+    void prepareSendMigration(int target_ring_fd, int client_fd, uint16_t tag);
+    // 방 수신함 알림: 대상 링에 RECV_ROOM CQE를 올려 수신함에 넣은 메시지를 처리하게 함 (tag: 대상 세션 번호)
+    void prepareRoomNotify(int target_ring_fd, uint16_t tag);
+    // 방 히스토리 세그먼트 파일 fdatasync (io-wq에서 실행되어 세션 스레드는 블로킹되지 않음, SQE가 없으면 false)
+    bool prepareHistorySync(int file_fd, uint16_t tag);
+    // 고정 파일 슬롯을 다른 링으로 전달 (대상 링은 target_user_data를 담은 RECV_FD CQE를 받음)
+    void prepareSendFd(int target_ring_fd, unsigned slot, uint64_t target_user_data, uint16_t tag);
     
     // IO 이벤트 처리 관련 메서드 (Session에서 처리하므로 중복 제거)
     unsigned peekCQE(io_uring_cqe** cqes);
+    // 블로킹 없는 완료 수집 (DEFER_TASKRUN 링은 지연된 task work를 먼저 실행)
+    unsigned pollCQE(io_uring_cqe** cqes);
     void advanceCQ(unsigned count);
-    int submitAndWait();
+    // timeout_ms > 0이면 io_uring_submit_and_wait_timeout으로 대기 (시간 초과 시 -ETIME)
+    int submitAndWait(unsigned timeout_ms = 0);
 
-    // Non-blocking submit
-    int submit() {
-        return io_uring_submit(&ring_);
-    }
+    // Non-blocking submit (SQPOLL 모드에서는 폴러가 잠든 경우에만 시스템 콜 발생)
+    int submit();
+
+    // CQ 오버플로 감시: 커널 백로그에 CQE가 쌓여 있으면 true (IORING_SQ_CQ_OVERFLOW)
+    bool hasCQOverflow() const { return IO_URING_READ_ONCE(*ring_.sq.kflags) & IORING_SQ_CQ_OVERFLOW; }
+    // 백로그도 할당하지 못해 커널이 버린 CQE 누적 수
+    unsigned getDroppedCQEs() const { return IO_URING_READ_ONCE(*ring_.cq.koverflow); }
+    // 연결 수가 CQ 용량을 넘었거나 오버플로가 발생하면 CQ를 확장 (확장했으면 true)
+    // CQE를 들고 있지 않은 시점(advanceCQ 이후)에만 호출해야 함
+    bool growForConnections(size_t connections, bool overflowed);
 
     // 버퍼 관리 관련 메서드    
     void releaseBuffer(uint16_t idx) { buffer_manager_->releaseBuffer(idx, buffer_manager_->getBaseAddr()); }
-    void handleWriteComplete(int32_t client_fd, uint16_t buffer_idx, int32_t bytes_written);
+    // SEND_ZC CQE 처리: 알림 CQE를 받았거나 알림이 오지 않는 경우에만 버퍼 반환 (알림 CQE이면 true)
+    bool handleSendZcComplete(io_uring_cqe* cqe, uint16_t buffer_idx);
+    bool usesZeroCopy() const { return send_zc_threshold_ > 0; }
+    bool wantsZeroCopy(unsigned len) const { return send_zc_threshold_ > 0 && len >= send_zc_threshold_; }
+
+    // 풀 전송이 성공 CQE를 생략하는지 (생략하면 완료를 기다릴 수 없지만 MSG_DONTWAIT라 제출 순서대로 끝남)
+    bool skipsSendSuccess() const { return send_skip_success_; }
+    // 커널이 이미 실행한 CQE_SKIP_SUCCESS 전송을 확인 대기로 옮김 (실패했다면 그 CQE는 이미 CQ에 있음)
+    void reclaimIssuedSends();
+    // 실패 CQE를 처리한 skip 모드 전송을 확인 대기에서 뺌
+    void discardSkipSend(uint16_t slot);
+    // 실패 CQE 없이 세션이 CQ를 지나간 (성공한) skip 모드 전송의 (client_fd, 슬롯)을 out에 덧붙임
+    void takeConfirmedSends(std::vector<std::pair<int32_t, uint16_t>>& out);
 
     UringBuffer& getBufferManager() { return *buffer_manager_; }
+    // 고정 파일 모드가 아니면 nullptr
+    FixedFileTable* getFileTable() { return file_table_.get(); }
+    bool usesFixedFiles() const { return file_table_ != nullptr; }
+    // 송신 풀을 쓰지 않으면 nullptr
+    SendBufferPool* getSendPool() { return send_pool_.get(); }
     const UringBuffer& getBufferManager() const { return *buffer_manager_; }
     
+    bool hasProvidedBuffers() const { return buffer_manager_ != nullptr; }
+    bool usesRecvBundle() const { return recv_bundle_; }
+    bool usesIncrementalRecv() const { return buffer_manager_ && buffer_manager_->isIncremental(); }
+
+    // 크기별 버퍼 그룹: 클래스 모드가 아니면 기본 버퍼 그룹 하나만 있음
+    bool usesRecvSizeClasses() const { return recv_classes_.size() > 1; }
+    unsigned getRecvClassCount() const { return static_cast<unsigned>(recv_classes_.size()); }
+    unsigned getDefaultRecvClass() const { return default_recv_class_; }
+    UringBuffer& getRecvClass(unsigned recv_class) { return *recv_classes_[recv_class]; }
+    void releaseBuffer(unsigned recv_class, uint16_t idx) {
+        recv_classes_[recv_class]->releaseBuffer(idx, recv_classes_[recv_class]->getBaseAddr());
+    }
+
+    // recv CQE가 링에서 가져간 버퍼를 해당 클래스의 장부에 기록 (번들은 bytes가 덮는 버퍼 전부)
+    void noteRecvBuffers(unsigned recv_class, uint16_t buffer_idx, unsigned bytes, uint32_t cqe_flags);
+    // 디버그 모드 누수 검사 (CQE 배치 처리 후 호출, 회수한 버퍼 수 반환)
+    unsigned auditRecvBuffers();
+    // 배치 동안 반환된 버퍼를 그룹별로 한 번에 링에 공개 (submit 전에 자동 호출)
+    void flushBufferReleases();
+    // 클라이언트를 찾을 수 없는 등 처리하지 않은 recv CQE의 버퍼를 바로 반환
+    void discardRecvBuffers(unsigned recv_class, uint16_t buffer_idx, unsigned bytes, uint32_t cqe_flags);
+    // 남은 버퍼가 적은 그룹을 상한까지 한 덩어리씩 확장 (추가한 버퍼 수 반환)
+    unsigned growRecvBuffers();
+
     // 링 및 버퍼 관리자 접근자
     io_uring* getRing() { return &ring_; }
+    int getRingFd() const { return ring_.ring_fd; }
+    bool isSqPoll() const { return sqpoll_; }
+    bool isSingleIssuer() const { return single_issuer_; }
+    uint64_t getSqPollWakeups() const { return sqpoll_wakeups_; }
+    unsigned getSQEntries() const { return sq_entries_; }
+    unsigned getCQEntries() const { return cq_entries_; }
 
 private:
-    void initRing();
+    void initRing(const RingOptions& options);
+    void initRegisteredResources();
+    void initRecvClasses();
+    void applyIoWqLimits();
+    bool isOpcodeSupported(int opcode);
     io_uring_sqe* getSQE();
     void setContext(io_uring_sqe* sqe, OperationType type, int client_fd = -1, uint16_t buffer_idx = 0);
 
     io_uring ring_;
     bool ring_initialized_;
+    bool sqpoll_{false};                // 실제로 SQPOLL이 적용되었는지 여부
+    bool single_issuer_{false};         // 실제로 SINGLE_ISSUER가 적용되었는지 여부
+    bool defer_taskrun_{false};         // 완료가 커널 진입 시에만 게시되는 DEFER_TASKRUN 링 여부
+    bool register_ring_fd_{false};
+    bool activated_{false};
+    bool auto_resize_{false};           // 런타임 확장 사용 여부 (미지원 커널에서는 첫 실패 후 해제)
+    unsigned sq_entries_{0};            // 커널이 실제로 할당한 SQ/CQ 크기
+    unsigned cq_entries_{0};
+    unsigned fixed_file_slots_{0};
+    bool provided_buffers_{true};
+    unsigned iowq_max_workers_[2]{0, 0};  // [bounded, unbounded]
+    int iowq_cpu_{-1};
+    uint64_t sqpoll_wakeups_{0};        // 잠든 폴러를 깨운 횟수
+    unsigned send_zc_threshold_{0};     // SEND_ZC 사용 최소 크기 (0: 사용 안 함, 미지원 커널에서는 0으로 해제)
+    unsigned send_pool_slots_{0};
+    bool recv_bundle_{false};           // 번들 recv 사용 여부 (IORING_FEAT_RECVSEND_BUNDLE이 없으면 해제)
+    bool send_skip_success_{false};
+    bool recv_size_classes_{false};     // 크기별 버퍼 그룹 요청 여부 (등록 실패 시 기본 버퍼 그룹만 사용)
+    bool recv_incremental_{false};      // 증분 소비 버퍼 링 요청 여부 (등록 실패 시 기본 버퍼 링으로 대체)
+    unsigned recv_buffer_size_{0};
+    unsigned recv_buffer_count_{0};
+    unsigned recv_buffers_initial_{0};
+    unsigned recv_buffer_cap_{0};
+    bool buffer_debug_{false};
+    // skip 모드 전송: 커널은 실패 CQE를 올린 뒤에 SQ head를 갱신하므로, head가 SQ 위치를 지난 시점의 CQ tail까지
+    // 세션이 CQE를 처리했는데 실패 CQE가 없었다면 성공한 전송
+    // (io_uring ABI가 보장하는 순서가 아니라 현재 커널 구현에 기댄 추정이므로 --send-skip-success는 실험적 옵트인)
+    struct SkipSend {
+        unsigned position;   // skip_pending_: SQ 위치, skip_issued_: 실행을 확인한 시점의 CQ tail
+        int32_t client_fd;
+        uint16_t slot;
+    };
+    std::deque<SkipSend> skip_pending_;   // 커널이 아직 가져가지 않은 전송
+    std::deque<SkipSend> skip_issued_;    // 실행되었고 그 전에 올라온 CQE의 처리를 기다리는 전송
+    // 벡터 전송 레코드: 커널이 완료할 때까지 msghdr/iovec이 유지되어야 하므로 주소가 바뀌지 않는 deque에 보관
+    struct SendVector {
+        msghdr msg{};
+        iovec iov[MAX_SEND_VECTOR];
+    };
+    std::deque<SendVector> send_vectors_;
+    std::vector<uint16_t> free_send_vectors_;
     std::unique_ptr<UringBuffer> buffer_manager_;
+    std::vector<std::unique_ptr<UringBuffer>> extra_buffer_groups_;  // 기본 그룹 외의 크기 클래스
+    std::vector<UringBuffer*> recv_classes_;  // 크기 순 recv 버퍼 그룹 (클래스 번호 -> 그룹)
+    unsigned default_recv_class_{0};          // recv_classes_에서 buffer_manager_의 위치
+    std::unique_ptr<FixedFileTable> file_table_;
+    std::unique_ptr<SendBufferPool> send_pool_;
     std::atomic<uint64_t> total_messages_{0};
 }; 
@@ -7,6 +7,12 @@
 #include <unistd.h>  // for close()
 
 class Listener {
+public:
+    // 고정 파일 모드에서 accept된 슬롯은 세션 링으로 전달 즉시 닫히므로 작은 테이블로 충분
+    static constexpr unsigned NUM_FIXED_FILE_SLOTS = 4096;
+    // accept와 fd/슬롯 전달만 제출하므로 작은 SQ로 충분
+    static constexpr unsigned NUM_SUBMISSION_QUEUE_ENTRIES = 256;
+
 private:
     // 생성자를 private으로 변경
     explicit Listener(int port);
@@ -21,6 +27,13 @@ private:
     // 메인 루프에서 반복적으로 사용되는 변수들을 멤버 변수로 이동
     io_uring_cqe* cqes_[IOUring::CQE_BATCH_SIZE];
     SessionManager& session_manager_; // 싱글톤 참조를 저장
+    
+    // CQE 핸들러
+    void handleAccept(io_uring_cqe* cqe);
+    void dispatchClient(int client_fd);
+    void handleSendClientFailed(io_uring_cqe* cqe, const Operation& ctx);
+    void dispatchDirectClient(unsigned slot);
+    void handleSendFdComplete(io_uring_cqe* cqe, const Operation& ctx);
 
 public:
     // 소멸자는 public으로 유지
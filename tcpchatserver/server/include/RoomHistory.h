@@ -0,0 +1,155 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Context.h"
+
+/**
+ * @brief 방 히스토리 세그먼트 파일 하나 (mmap한 append-only 로그)
+ *
+ * 파일은 만들 때 전체 크기를 미리 할당하고 MAP_SHARED로 매핑합니다. 기록은 매핑에 memcpy만 하므로 (페이지 캐시)
+ * 세션 스레드는 블로킹되지 않고, 디스크 반영은 기록한 세션이 자기 링에 넣는 fdatasync가 배치 단위로 맡습니다.
+ * 한 번 쓴 레코드는 바뀌지 않으므로 재생 전송은 매핑을 그대로 가리키며, 매핑은 마지막 참조
+ * (방 로그, 전송 중인 재생, 진행 중인 동기화)가 풀릴 때 해제됩니다.
+ *
+ * 파일 형식: [헤더 16B: magic, 버전, 생성 시각] + 레코드* (8바이트 정렬),
+ * 레코드는 [길이 4B][CRC32C 4B][기록 시각 8B][타입][flags][예약 6B][페이로드].
+ * 길이가 0인 레코드 헤더(미리 할당한 0 영역)가 끝을 나타냅니다. MAP_SHARED 페이지는 순서 없이 디스크에 반영되므로
+ * 크래시 뒤에는 헤더만 있고 페이로드가 비어 있을 수 있어, 복구할 때 헤더와 페이로드의 CRC32C가 맞지 않는 첫 레코드에서 자릅니다.
+ */
+class HistorySegment {
+public:
+    static constexpr uint32_t MAGIC = 0x48434852;     // "RHCH"
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t RECORD_HEADER_SIZE = 24;
+    static constexpr size_t RECORD_ALIGN = 8;
+
+    // 새 세그먼트 파일을 만들어 매핑 (실패 시 std::runtime_error)
+    static std::shared_ptr<HistorySegment> create(const std::string& path, uint64_t sequence, size_t capacity);
+    // 기존 세그먼트를 매핑하고 레코드를 훑어 끝을 찾음 (체크섬이 맞지 않는 꼬리는 0으로 지움, 실패 시 std::runtime_error)
+    static std::shared_ptr<HistorySegment> open(const std::string& path, uint64_t sequence);
+    ~HistorySegment();
+
+    HistorySegment(const HistorySegment&) = delete;
+    HistorySegment& operator=(const HistorySegment&) = delete;
+
+    const uint8_t* data() const { return base_; }
+    int fd() const { return fd_; }
+    size_t capacity() const { return capacity_; }
+    uint64_t sequence() const { return sequence_; }
+    uint64_t lastWriteMs() const { return last_write_ms_; }
+
+    // 아래 세 메서드는 방 로그의 락 안에서 호출
+    bool fits(size_t length) const;
+    // 레코드를 덧붙이고 세그먼트 안의 페이로드 위치를 반환
+    size_t append(MessageType type, uint8_t flags, const uint8_t* payload, size_t length, uint64_t now_ms);
+    // position의 레코드를 읽고 다음 레코드로 이동 (끝이면 false)
+    bool readRecord(size_t& position, MessageType& type, uint8_t& flags, size_t& payload_offset, size_t& length) const;
+
+    // 보관 정책으로 로그에서 빠질 때 파일 삭제 (매핑은 마지막 참조까지 유지)
+    void unlink();
+
+    // 그룹 커밋: 진행 중인 동기화가 없고 반영할 기록이 있으면 true와 이번 동기화가 덮는 위치 (세그먼트당 하나만 진행)
+    bool beginSync(size_t& target);
+    // 끝난 동기화를 반영하고, 그 사이 더 기록되어 다시 동기화해야 하면 true
+    bool endSync(size_t target, bool ok);
+
+private:
+    HistorySegment(const std::string& path, uint64_t sequence, int fd, uint8_t* base, size_t capacity);
+    static uint8_t* mapFile(int fd, size_t capacity);
+
+    std::string path_;
+    uint64_t sequence_;
+    int fd_;
+    uint8_t* base_;
+    size_t capacity_;
+    size_t tail_ = HEADER_SIZE;    // 다음 레코드를 쓸 위치
+    uint64_t last_write_ms_ = 0;   // 마지막 기록 시각 (시간 보관 기준)
+    std::atomic<size_t> written_{0};    // 기록이 끝난 위치 (여러 세션이 동기화를 확인)
+    std::atomic<size_t> synced_{0};     // 디스크에 반영된 위치
+    std::atomic<bool> syncing_{false};  // 어느 세션 링에서든 fdatasync가 진행 중
+};
+
+// 재생할 레코드 하나 (세그먼트 참조를 쥐고 있어 보관 정책으로 삭제되어도 매핑은 유지)
+struct HistoryRecord {
+    std::shared_ptr<HistorySegment> segment;
+    uint32_t offset;     // 세그먼트 안의 페이로드 위치
+    uint32_t length;     // 페이로드 길이
+    MessageType type;
+    uint8_t flags;
+};
+
+/**
+ * @brief 방별 채팅 히스토리
+ *
+ * 방마다 세그먼트 파일을 순서대로 쌓고 (<dir>/room-<방 번호>-<순번>.log), 재생용으로 최근 레코드 위치만 메모리에 둡니다.
+ * 방 메시지는 보낸 세션이 append()로 한 번만 기록하고, 받은 세그먼트를 배치가 끝날 때 자기 링에서 fdatasync합니다.
+ * 세그먼트가 다 차면 새 파일로 넘어가고, 그때와 재생할 때 방별 바이트/시간 보관 상한을 넘은 오래된 세그먼트를 지웁니다.
+ *
+ * 모든 메서드는 어느 스레드에서나 호출할 수 있습니다 (방 번호로 고른 샤드와 방 로그의 뮤텍스로 보호).
+ */
+class RoomHistory {
+public:
+    static constexpr size_t NUM_SHARDS = 64;
+
+    static RoomHistory& getInstance() {
+        static RoomHistory instance;
+        return instance;
+    }
+
+    // 디렉터리의 기존 세그먼트를 복구하고 기록을 켬 (워커 시작 전에 한 번, 실패 시 std::runtime_error)
+    void open(const std::string& dir, size_t segment_bytes, size_t replay_count, uint64_t retain_bytes,
+              unsigned retain_secs);
+    bool enabled() const { return enabled_; }
+    size_t replayCount() const { return replay_count_; }
+
+    // 방 room_id에 메시지를 덧붙이고 기록한 세그먼트를 반환 (호출한 세션이 그룹 커밋, 실패 시 nullptr)
+    std::shared_ptr<HistorySegment> append(int32_t room_id, MessageType type, uint8_t flags, const uint8_t* payload,
+                                           size_t length);
+    // 방 room_id의 최근 메시지를 오래된 것부터 최대 count개 out에 채움
+    void recent(int32_t room_id, size_t count, std::vector<HistoryRecord>& out);
+
+    RoomHistory(const RoomHistory&) = delete;
+    RoomHistory& operator=(const RoomHistory&) = delete;
+
+private:
+    RoomHistory() = default;
+
+    struct RoomLog {
+        std::mutex mutex;
+        std::deque<std::shared_ptr<HistorySegment>> segments;  // 오래된 것부터, 마지막이 기록 중인 세그먼트
+        std::deque<HistoryRecord> recent;                       // 재생할 최근 레코드 (replay_count_개까지)
+        uint64_t bytes = 0;                                     // 세그먼트 파일 크기 합
+        uint64_t next_sequence = 0;
+    };
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int32_t, std::shared_ptr<RoomLog>> rooms;
+    };
+    Shard& shardOf(int32_t room_id) {
+        return shards_[static_cast<uint32_t>(room_id) * 2654435761u % NUM_SHARDS];
+    }
+
+    std::shared_ptr<RoomLog> logOf(int32_t room_id, bool create);
+    std::string segmentPath(int32_t room_id, uint64_t sequence) const;
+    void remember(RoomLog& log, const std::shared_ptr<HistorySegment>& segment, size_t offset, size_t length,
+                  MessageType type, uint8_t flags);
+    // 보관 상한을 넘은 오래된 세그먼트 삭제 (log.mutex 안에서 호출)
+    void expire(int32_t room_id, RoomLog& log, uint64_t now_ms);
+
+    bool enabled_ = false;
+    std::string dir_;
+    size_t segment_bytes_ = 0;
+    size_t replay_count_ = 0;
+    uint64_t retain_bytes_ = 0;
+    uint64_t retain_ms_ = 0;
+    Shard shards_[NUM_SHARDS];
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "Context.h"
+
+/**
+ * @brief 세션 스레드와 분리된 채팅방 목록
+ *
+ * 방 번호는 세션(스레드) 번호와 관계없는 임의의 정수이고, 한 방의 멤버는 여러 세션에 흩어질 수 있습니다.
+ * 멤버 목록 자체는 각 세션이 갖고, 레지스트리는 방마다 "멤버가 한 명 이상 있는 세션"만 기록합니다.
+ * 세션은 자기 방의 첫 멤버가 들어오거나 마지막 멤버가 나갈 때만 join()/leave()를 호출하므로
+ * 메시지마다 일어나는 일은 sessionsOf()의 샤드 락 하나뿐입니다.
+ *
+ * 모든 메서드는 어느 스레드에서나 호출할 수 있습니다 (방 번호로 고른 샤드의 뮤텍스로 보호).
+ */
+class RoomRegistry {
+public:
+    static constexpr size_t NUM_SHARDS = 64;  // 방 번호 해시로 나눈 샤드 수 (2의 거듭제곱)
+
+    static RoomRegistry& getInstance() {
+        static RoomRegistry instance;
+        return instance;
+    }
+
+    // 세션 session_id에 방 room_id의 첫 멤버가 생김
+    void join(int32_t room_id, int32_t session_id);
+    // 세션 session_id에서 방 room_id의 마지막 멤버가 나감
+    void leave(int32_t room_id, int32_t session_id);
+    // 방 room_id에 멤버가 있는 세션을 out에 채움 (out은 호출자가 재사용)
+    void sessionsOf(int32_t room_id, std::vector<int32_t>& out);
+    // 멤버가 있는 방 수 (통계용)
+    size_t roomCount();
+    // 브로드캐스트 번호 (로그에서 세션들의 팬아웃을 묶어 보기 위한 것)
+    uint64_t nextBroadcastId() { return next_broadcast_id_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+    RoomRegistry(const RoomRegistry&) = delete;
+    RoomRegistry& operator=(const RoomRegistry&) = delete;
+
+private:
+    RoomRegistry() = default;
+
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<int32_t, std::vector<int32_t>> rooms;  // 방 번호 -> 멤버가 있는 세션들
+    };
+    Shard& shardOf(int32_t room_id) {
+        return shards_[static_cast<uint32_t>(room_id) * 2654435761u % NUM_SHARDS];
+    }
+
+    Shard shards_[NUM_SHARDS];
+    std::atomic<uint64_t> next_broadcast_id_{0};
+};
+
+// 방 번호 대신 쓰면 세션의 모든 연결에게 보내는 공지
+static constexpr int32_t ANNOUNCE_ROOM = -1;
+
+/**
+ * @brief 브로드캐스트 한 건의 완료 추적
+ *
+ * 팬아웃에 참여하는 세션들이 함께 참조합니다. holds는 아직 수신자를 다 돌지 않은 세션 작업 수와
+ * 전송이 끝나지 않은 공유 프레임 수의 합이고, 마지막으로 0을 만든 스레드가 완료 시간을 기록합니다.
+ * 보내는 세션은 자기 작업분 1로 시작하고, 다른 세션에 넘길 때마다 1씩 더해 받는 세션의 작업에 넘깁니다.
+ */
+struct BroadcastTracker {
+    uint64_t id = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::atomic<uint32_t> holds{1};
+    std::atomic<uint64_t> recipients{0};  // 모든 세션에서 공유 프레임을 넣은 수신자 수
+    std::atomic<uint32_t> sessions{0};    // 팬아웃에 참여한 세션 수
+};
+
+// 다른 세션 스레드로 넘기는 방 메시지의 본문 (받는 세션들이 함께 참조, 각자 자기 송신 풀에 한 번씩 복사)
+struct RoomPayload {
+    MessageType type;
+    uint8_t flags;
+    std::vector<uint8_t> data;
+};
+
+// 세션 수신함 항목
+struct RoomMessage {
+    RoomMessage* next = nullptr;
+    int32_t room_id = 0;                // ANNOUNCE_ROOM이면 받는 세션의 모든 연결
+    std::shared_ptr<const RoomPayload> payload;
+    std::shared_ptr<BroadcastTracker> tracker;  // 보낸 쪽이 이 메시지 몫으로 holds를 하나 올려 둠
+};
+
+/**
+ * @brief 세션별 방 메시지 수신함 (lock-free MPSC)
+ *
+ * 여러 세션 스레드가 push()하고 소유 세션 스레드만 drain()합니다.
+ * 생산자는 CAS로 스택에 넣기만 하고, 소비자는 목록 전체를 한 번에 떼어 내 뒤집어서 넣은 순서대로 처리합니다.
+ * push()는 비어 있던 수신함에 넣었을 때만 true를 반환하므로 호출자는 그때만 소유 세션을 깨우면 됩니다
+ * (비어 있지 않았다면 앞선 push가 보낸 알림이 아직 처리되지 않은 것).
+ */
+class RoomInbox {
+public:
+    ~RoomInbox();
+
+    bool push(RoomMessage* message);
+    // 쌓인 메시지를 도착 순서대로 떼어 냄 (없으면 nullptr, 호출자가 delete)
+    RoomMessage* drain();
+    bool empty() const { return head_.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    std::atomic<RoomMessage*> head_{nullptr};
+};
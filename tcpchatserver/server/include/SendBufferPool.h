@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <liburing.h>
+
+/**
+ * @brief 서버 발신 메시지 전용 등록 버퍼 풀
+ *
+ * recv용 provided buffer ring과 분리된 송신 버퍼를 io_uring_register_buffers로 등록합니다.
+ * 슬롯 번호가 곧 등록 버퍼 인덱스이므로 io_uring_prep_write_fixed에 그대로 넘길 수 있고,
+ * 전송이 끝날 때까지 recv 버퍼를 붙잡아 둘 필요가 없습니다.
+ *
+ * 모든 메서드는 링을 소유한 세션 스레드에서만 호출합니다.
+ */
+class SendBufferPool {
+public:
+    static constexpr unsigned SLOT_SIZE = 1024;   // ChatMessage 한 개 크기
+    static constexpr unsigned MAX_SLOTS = 16384;  // 커널 등록 버퍼 상한 (IORING_MAX_REG_BUFFERS)
+
+    SendBufferPool(io_uring* ring, unsigned num_slots);
+    ~SendBufferPool();
+
+    // 빈 슬롯 하나를 가져옴 (풀이 비어 있으면 -1)
+    int acquire();
+    void release(uint16_t slot);
+
+    uint8_t* getSlotAddr(uint16_t slot) const { return base_addr_ + static_cast<size_t>(slot) * SLOT_SIZE; }
+    unsigned capacity() const { return num_slots_; }
+    unsigned available() const { return static_cast<unsigned>(free_slots_.size()); }
+
+    SendBufferPool(const SendBufferPool&) = delete;
+    SendBufferPool& operator=(const SendBufferPool&) = delete;
+
+private:
+    io_uring* ring_;                    // io_uring 인스턴스 (소유권 없음)
+    const unsigned num_slots_;          // 등록된 슬롯 수
+    const size_t region_size_;          // 전체 버퍼 메모리 크기
+    uint8_t* base_addr_;                // 버퍼 메모리 시작 주소
+    std::vector<uint16_t> free_slots_;  // 사용 가능한 슬롯 스택
+    std::vector<uint8_t> in_use_;       // 슬롯별 사용 여부 (이중 반환 감지)
+};
@@ -0,0 +1,121 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+// 세션 링 프로파일
+enum class RingProfile : uint8_t {
+    DEFAULT = 0,        // 플래그 없는 일반 링
+    SINGLE_ISSUER = 1   // SINGLE_ISSUER | DEFER_TASKRUN | COOP_TASKRUN + 링 fd 등록
+};
+
+// 느린 수신자 정책: 연결의 송신 큐가 상한에 닿았을 때 새 브로드캐스트 프레임을 어떻게 처리할지
+// (자기 요청에 대한 응답은 버리지 않고 recv를 멈춰 흐름 제어)
+enum class SlowConsumerPolicy : uint8_t {
+    DROP_OLDEST = 0,    // 아직 보내지 않은 가장 오래된 브로드캐스트부터 버려 자리를 만듦
+    DROP_NEWEST = 1,    // 새 브로드캐스트를 버림
+    COALESCE = 2,       // 보내지 않은 브로드캐스트를 모두 버리고 최신 것만 남김 (최신 상태만 의미 있는 채널)
+    DISCONNECT = 3      // 연결을 닫음
+};
+
+/**
+ * @brief 서버 런타임 설정을 담당하는 싱글톤
+ *
+ * main()에서 "--key=value" 형식의 선택 인수를 파싱하여 채우며,
+ * SessionManager가 세션별 IOUring을 생성할 때 참조합니다.
+ * 모든 옵션은 기본값이 기존 동작과 동일하도록 설정되어 있습니다.
+ */
+class ServerConfig {
+public:
+    static ServerConfig& getInstance() {
+        static ServerConfig instance;
+        return instance;
+    }
+
+    // "--key" 또는 "--key=value" 형식의 인수 하나를 적용 (알 수 없는 옵션이면 false)
+    bool parseOption(const std::string& arg);
+
+    // 사용 가능한 옵션 목록 출력
+    static void printOptions();
+
+    // SQPOLL 제출 모드 (IORING_SETUP_SQPOLL)
+    bool sqpoll = false;               // 커널 폴러 스레드로 SQ 제출
+    unsigned sqpoll_idle_ms = 1000;    // 폴러가 잠들기 전 유휴 대기 시간 (sq_thread_idle)
+    int sqpoll_cpu = -1;               // 폴러 고정 시작 CPU (-1: 고정 안 함, 세션 i는 base + i)
+    bool sqpoll_shared = false;        // 모든 세션 링이 하나의 폴러 스레드를 공유 (IORING_SETUP_ATTACH_WQ)
+
+    // 커널 io-wq 워커 풀 (io_uring_register_iowq_max_workers, 0은 커널 기본값 유지)
+    bool shared_wq = false;            // 모든 세션 링을 첫 세션 링에 IORING_SETUP_ATTACH_WQ로 연결
+    unsigned iowq_max_bounded = 0;     // 세션 스레드별 bounded 워커 상한 (파일 I/O 등)
+    unsigned iowq_max_unbounded = 0;   // 세션 스레드별 unbounded 워커 상한 (소켓 등)
+    int session_cpu = -1;              // 세션 i의 워커 스레드와 io-wq를 CPU (base + i)에 고정 (-1: 고정 안 함)
+
+    // 링 크기 (IORING_SETUP_CQSIZE, IORING_REGISTER_RESIZE_RINGS)
+    unsigned expected_connections = 0; // 세션별 예상 연결 수로 SQ/CQ 크기 산정 (0: SQ 8192, CQ 16384 고정)
+    bool ring_autoresize = true;       // 연결 수가 CQ 용량을 넘으면 런타임에 CQ 확장 (single-issuer 링, 6.13+)
+
+    // 세션 이벤트 루프 대기 전략
+    unsigned busy_poll_us = 0;         // CQE가 없을 때 블로킹 전 최대 스핀 시간 (0: 스핀 안 함, 실제 예산은 유휴 간격에 맞춰 조정)
+    unsigned wait_timeout_ms = 0;      // 블로킹 대기 시간 제한 (0: 무제한, io_uring_submit_and_wait_timeout)
+
+    // 제로 카피 전송 (IORING_OP_SEND_ZC, 커널 6.0 이상)
+    unsigned send_zc_threshold = 0;    // 이 크기(헤더 포함 바이트) 이상의 응답을 SEND_ZC로 전송 (0: 사용 안 함)
+
+    // 송신 전용 등록 버퍼 풀 (io_uring_register_buffers + write_fixed)
+    unsigned send_pool_slots = 0;      // 세션별 송신 버퍼 슬롯 수 (풀은 항상 생성, 0: 기본 1024)
+    bool send_skip_success = false;    // 풀 전송에 IOSQE_CQE_SKIP_SUCCESS 적용 (실험적, 송신 버퍼가 가득 차면 완료를 받는 전송으로 이어 보냄)
+
+    // 번들 recv (IORING_RECVSEND_BUNDLE, 커널 6.10 이상): CQE 하나가 연속 버퍼 여러 개를 덮고, 응답은 송신 풀에 모아 전송
+    bool recv_bundle = false;
+
+    // 기본 recv 버퍼 그룹(1 KB)의 탄력적 확장: 남은 버퍼가 적으면 상한까지 덩어리 단위로 추가하고,
+    // 상한에서 ENOBUFS가 나면 버퍼가 돌아올 때까지 해당 연결의 recv 재등록을 미룸
+    unsigned recv_buffers = 0;         // 처음 링에 올릴 버퍼 수 (0: 상한 전부)
+    unsigned recv_buffer_cap = 0;      // 버퍼 상한, 2의 거듭제곱 (0: 4096)
+    bool buffer_debug = false;         // 배치마다 recv 버퍼 소유 장부를 검사해 누수를 보고하고 회수 (이중 반환은 항상 거부)
+
+    // 증분 소비 버퍼 (IOU_PBUF_RING_INC, 커널 6.12 이상): 큰 버퍼 하나를 여러 recv가 이어서 채워 작은 메시지의 버퍼 낭비를 줄임
+    bool recv_incremental = false;
+    unsigned inc_buffer_size = 65536;  // 증분 버퍼 크기 (2의 거듭제곱)
+    unsigned inc_buffers = 64;         // 증분 버퍼 개수 (2의 거듭제곱)
+
+    // 크기별 recv 버퍼 그룹 (128 B / 1 KB / 16 KB): 연결마다 최근 수신 크기에 맞는 그룹에서 recv
+    bool recv_size_classes = false;
+
+    // 링 프로파일 (--ring-profile=default|single-issuer)
+    RingProfile ring_profile = RingProfile::DEFAULT;
+
+    // 세션별 SO_REUSEPORT 리스닝 소켓: 각 세션 링이 자기 소켓에 멀티샷 accept를 걸고 커널이 연결을 분배 (Listener 미사용)
+    bool reuseport_accept = false;
+    bool reuseport_cpu_steer = false;  // classic BPF로 SYN을 처리한 CPU에 고정된 세션의 소켓을 고름 (--session-cpu와 함께 사용)
+
+    // 고정 파일(direct descriptor) 모드: accept부터 close까지 fd 대신 링별 고정 파일 슬롯 사용
+    bool direct_fds = false;
+    unsigned direct_fd_slots = 16384;  // 세션 링별 고정 파일 테이블 크기 (RLIMIT_NOFILE로 제한)
+
+    // 채팅방: 기본은 연결이 받은 세션에 남고 방 메시지를 세션 간 수신함으로 전달,
+    // 켜면 CLIENT_JOIN한 연결을 방의 홈 세션(방 번호 % 세션 수)으로 옮겨 작은 방의 멤버를 한 스레드에 모음
+    bool room_affinity = false;
+    // 팬아웃: 수신자가 많은 방/공지는 배치마다 fanout_slice명씩 나눠 CQE 처리 사이에 끼워 보냄 (0: 한 번에 모두)
+    unsigned fanout_slice = 1024;
+    unsigned fanout_budget_ms = 0;     // 모든 수신자에게 전송이 끝나기까지의 목표 시간 (넘으면 경고, 0: 검사 안 함)
+    // 서버 전체 공지: 모든 연결로 증폭되므로 운영자 토큰을 보낸 연결만 허용 (비어 있으면 공지 명령 거부)
+    std::string announce_token;
+    unsigned announce_interval_ms = 1000;  // 연결별 공지 최소 간격 (0: 제한 없음)
+
+    // 느린 수신자: 연결별 송신 큐 상한 (0: 제한 없음). 상한에 닿으면 그 연결의 recv를 멈추고 절반 아래로 줄면 재개
+    unsigned send_queue_bytes = 256 * 1024;
+    unsigned send_queue_frames = 1024;
+    SlowConsumerPolicy slow_consumer = SlowConsumerPolicy::DROP_OLDEST;
+
+    // 방 히스토리: 방마다 mmap한 세그먼트 파일에 채팅을 덧붙이고, CLIENT_JOIN 시 최근 메시지를 재생 (디렉터리가 비면 끔)
+    std::string history_dir;
+    unsigned history_replay = 50;                      // JOIN 시 재생할 최근 메시지 수
+    unsigned history_segment_bytes = 4 * 1024 * 1024;  // 세그먼트 파일 크기 (다 차면 새 세그먼트로 넘어감)
+    unsigned long long history_retain_bytes = 64ULL * 1024 * 1024;  // 방별 보관 상한 (0: 무제한)
+    unsigned history_retain_secs = 0;                  // 마지막 기록 후 이 시간이 지난 세그먼트 삭제 (0: 무제한)
+
+private:
+    ServerConfig() = default;
+    ServerConfig(const ServerConfig&) = delete;
+    ServerConfig& operator=(const ServerConfig&) = delete;
+};
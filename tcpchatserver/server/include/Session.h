@@ -1,15 +1,106 @@
 #pragma once
 #include <set>
+#include <deque>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <mutex>
+#include <chrono>
 #include "IOUring.h"
 #include "Socket.h"
 #include "Context.h"
+#include "RoomRegistry.h"
+#include "RoomHistory.h"
+#include "ServerConfig.h"
 
 // 전방 선언
 struct io_uring_cqe;
-class ChatMessage;
+
+// 세션 링 상태 통계 (워커 스레드에서만 갱신, 종료 시 SessionManager가 출력)
+struct SessionStats {
+    uint64_t cq_overflow_batches = 0;  // IORING_SQ_CQ_OVERFLOW가 관측된 이벤트 배치 수
+    uint64_t cq_dropped = 0;           // 커널이 버린 CQE 수 (cq.koverflow 증가분)
+    uint64_t ring_resizes = 0;         // 런타임 CQ 확장 횟수
+    size_t peak_clients = 0;           // 동시에 등록된 최대 클라이언트 수
+    uint64_t ready_batches = 0;        // 첫 peek에서 바로 CQE가 있었던 배치 수
+    uint64_t spin_hits = 0;            // 스핀 예산 안에 CQE가 도착한 횟수
+    uint64_t spin_misses = 0;          // 예산을 다 쓰고도 CQE가 없어 대기로 넘어간 횟수
+    uint64_t sleeps = 0;               // submitAndWait로 블로킹한 횟수
+    uint64_t wait_timeouts = 0;        // 대기 시간 초과(-ETIME) 횟수
+    uint64_t zc_sends = 0;             // 제로 카피로 전송 완료된 응답 수
+    uint64_t zc_notifs = 0;            // 버퍼를 돌려받은 제로 카피 알림 수
+    uint64_t pool_sends = 0;           // 송신 버퍼 풀에서 보낸 메시지 수
+    uint64_t pool_exhausted = 0;       // 풀이 비어 recv 버퍼 경로로 대체한 횟수
+    uint64_t pool_send_errors = 0;     // 실패 CQE가 올라온 풀 전송 수
+    uint64_t skip_send_retries = 0;    // 소켓 버퍼가 차서 남은 부분을 완료를 받는 전송으로 다시 보낸 skip 전송 수
+    uint64_t vector_sends = 0;         // 슬롯 여러 개를 sendmsg 한 번으로 보낸 전송 수
+    uint64_t vector_slots = 0;         // 벡터 전송이 묶은 슬롯 수
+    uint64_t queued_sends = 0;         // 앞선 전송이 끝나기를 기다렸다가 나간 응답 수
+    uint64_t short_sends = 0;          // 일부만 전송되어 나머지를 이어서 보낸 전송 수
+    uint64_t recv_bundles = 0;         // 번들 recv CQE 수
+    uint64_t recv_bundle_buffers = 0;  // 번들 recv CQE가 덮은 버퍼 수
+    uint64_t coalesced_frames = 0;     // 앞선 응답과 같은 send로 묶여 나간 응답 수
+    uint64_t recv_incremental = 0;     // 증분 소비 버퍼에 들어온 recv CQE 수
+    uint64_t recv_incremental_retired = 0;  // 커널이 다 채우고 놓은 증분 버퍼 수
+    uint64_t recv_class_upgrades = 0;  // 버퍼를 가득 채우거나 ENOBUFS로 큰 클래스로 옮긴 횟수
+    uint64_t recv_class_downgrades = 0;  // 최근 수신 크기 이력으로 작은 클래스로 옮긴 횟수
+    uint64_t recv_class_switches = 0;  // 클래스 전환을 위해 취소된 멀티샷 recv 수
+    uint64_t recv_enobufs = 0;         // 버퍼 링이 비어 끝난 recv 수
+    uint64_t recv_deferred = 0;        // 버퍼 상한에 도달해 재등록을 미룬 recv 수
+    uint64_t recv_resumed = 0;         // 버퍼가 돌아와 다시 등록한 recv 수
+    uint64_t recv_buffers_grown = 0;   // 탄력적 확장으로 링에 추가한 버퍼 수
+    uint64_t buffer_leaks = 0;         // 디버그 모드에서 배치 끝까지 주인이 없어 회수한 recv 버퍼 수
+    uint64_t accepts = 0;              // 세션 링에서 직접 accept한 연결 수 (--reuseport-accept)
+    uint64_t accept_errors = 0;        // 실패한 accept CQE 수
+    uint64_t migrations_out = 0;       // CLIENT_JOIN으로 다른 세션에 넘긴 연결 수
+    uint64_t migrations_in = 0;        // 다른 세션에서 넘겨받은 연결 수
+    uint64_t migration_carry_bytes = 0;  // 이동 중 받아 대상 세션으로 넘긴 바이트 수
+    uint64_t migration_fd_failures = 0;  // 고정 파일 슬롯을 대상 링에 넘기지 못해 이 세션에 남긴 연결 수
+    uint64_t v2_frames = 0;            // 프로토콜 v2로 받은 프레임 수
+    uint64_t large_frames = 0;         // recv 버퍼를 고정해 복사 없이 scatter-gather로 보낸 큰 프레임 수
+    uint64_t large_frame_buffers = 0;  // 큰 프레임이 고정한 recv 버퍼 범위 수
+    uint64_t large_frame_copies = 0;   // 고정할 수 없어(예산, 버퍼 그룹) 스필 영역에 복사한 큰 프레임 수
+    uint64_t broadcasts = 0;           // 방 멤버에게 전달한 채팅 메시지 수
+    uint64_t broadcast_deliveries = 0; // 공유 송신 버퍼로 전달한 수신자 수 (송신자 제외)
+    uint64_t broadcast_slots = 0;      // 브로드캐스트용으로 만든 공유 송신 풀 슬롯 수
+    uint64_t broadcast_skipped = 0;    // v1 연결이라 받을 수 없는 큰 메시지를 건너뛴 수신자 수
+    uint64_t broadcast_failures = 0;   // 송신 풀이 바닥나 전달하지 못한 브로드캐스트 수
+    uint64_t room_posts = 0;           // 다른 세션 수신함에 넣은 방 메시지 수 (세션당 하나)
+    uint64_t room_notifies = 0;        // 비어 있던 수신함을 채워 대상 세션을 깨운 알림 수
+    uint64_t room_received = 0;        // 다른 세션에서 받아 이 세션의 멤버에게 전달한 방 메시지 수
+    uint64_t announcements = 0;        // 이 세션에서 시작한 서버 전체 공지 수
+    uint64_t announce_rejected = 0;    // 꺼져 있거나 토큰이 틀렸거나 간격 제한에 걸려 거부한 공지 명령 수
+    uint64_t fanout_deferred = 0;      // 한 조각에 끝나지 않아 다음 배치들로 나눠 보낸 팬아웃 수
+    uint64_t fanout_slices = 0;        // 배치 끝에서 이어 보낸 팬아웃 조각 수
+    uint64_t fanout_completed = 0;     // 이 세션에서 완료를 기록한 브로드캐스트 수 (수신자가 있었던 것만)
+    uint64_t fanout_latency_us_total = 0;  // 시작부터 모든 수신자의 전송 완료까지 걸린 시간 합
+    uint64_t fanout_latency_us_max = 0;
+    uint64_t fanout_over_budget = 0;   // --fanout-budget-ms를 넘긴 브로드캐스트 수
+    uint64_t slow_dropped = 0;         // 송신 큐 상한 때문에 버린 브로드캐스트 프레임 수 (drop-oldest / drop-newest)
+    uint64_t slow_coalesced = 0;       // 새 프레임으로 대체되어 버린 브로드캐스트 프레임 수 (coalesce)
+    uint64_t slow_disconnects = 0;     // 송신 큐 상한 때문에 닫은 연결 수 (disconnect)
+    uint64_t flow_pauses = 0;          // 송신 큐가 상한에 닿아 recv를 멈춘 횟수
+    uint64_t flow_resumes = 0;         // 송신 큐가 줄어 recv를 다시 시작한 횟수
+    uint64_t history_appends = 0;      // 방 히스토리에 기록한 메시지 수
+    uint64_t history_append_failures = 0;  // 세그먼트를 만들지 못해 기록하지 못한 메시지 수
+    uint64_t history_syncs = 0;        // 링에 넣은 세그먼트 fdatasync 수 (그룹 커밋)
+    uint64_t history_sync_errors = 0;  // 실패한 fdatasync 수
+    uint64_t history_replays = 0;      // 히스토리를 재생한 JOIN 수
+    uint64_t history_replayed = 0;     // 재생한 메시지 수
+    uint64_t history_replay_failures = 0;  // 송신 풀이 비어 끝까지 재생하지 못한 JOIN 수
+    uint64_t history_replay_capped = 0;  // 송신 큐 상한에 들어가지 않아 재생하지 않은 메시지 수
+};
+
+// CLIENT_JOIN으로 다른 세션에 넘기는 연결 상태 (소스 워커가 만들고 대상 워커가 등록)
+struct MigratedClient {
+    SocketPtr socket;
+    std::vector<uint8_t> carry;        // JOIN 뒤에 받았지만 처리하지 않은 바이트 (대상 세션이 이어서 파싱)
+    int recv_class = -1;               // 크기 클래스 모드에서 쓰던 recv 클래스 (-1: 대상의 기본 클래스)
+    bool protocol_v2 = false;          // v2 프레임을 보낸 연결 (대상 세션도 v2로 응답)
+    int32_t room = -1;                 // 대상 세션에서 참가할 방 (--room-affinity로 옮겨 온 연결, -1: 없음)
+};
 
 /**
  * @brief 클라이언트 세션 관리를 담당하는 클래스
@@ -20,8 +111,12 @@ class ChatMessage;
 class Session {
 public:
     static constexpr unsigned CQE_BATCH_SIZE = 512;  // 한 번에 처리할 최대 이벤트 수
+    static constexpr unsigned IDLE_GAP_EWMA_SHIFT = 3;   // 유휴 간격 평균의 가중치 (1/8)
+    static constexpr uint16_t NO_RECV_BUFFER = 0xFFFF;   // 응답을 만들 recv 버퍼가 없음 (번들 recv, 송신 풀 사용)
+    static constexpr unsigned RECV_CLASS_WINDOW = 32;    // 작은 크기 클래스로 내려가기 전에 관찰할 recv CQE 수
+    static constexpr size_t LARGE_FRAME_MIN_PAYLOAD = 1024;  // 이 크기 이상의 v2 채팅 프레임은 recv 버퍼를 고정해 조립
     
-    explicit Session(int32_t id);
+    explicit Session(int32_t id, const RingOptions& ring_options = RingOptions{});
     ~Session();
     
     int32_t getSessionId() const { return session_id_; }
@@ -29,15 +124,38 @@ public:
     // 이제 소켓 파일 디스크립터 집합을 반환합니다 (하위 호환성 유지)
     std::set<int32_t> getClientFds() const;
     
-    void addClient(SocketPtr client_socket);
+    // 세션 워커 스레드에서 루프 시작 전 한 번 호출 (링 활성화, 웨이크업 폴링과 accept 등록)
+    void onWorkerStart();
+    
+    // 워커 시작 전에 호출: 이 세션 전용 SO_REUSEPORT 리스닝 소켓 (링에서 멀티샷 accept)
+    void setListeningSocket(SocketPtr listening_socket) { listening_socket_ = std::move(listening_socket); }
+    
+    // 어느 스레드에서나 호출 가능: 이동해 온 연결을 대기열에 넣음 (등록과 recv 준비는 워커 스레드에서 수행)
+    // 호출자는 MSG_RING 알림(RECV_MIGRATION)이나 wakeup()으로 워커를 깨워야 함
+    void addClient(MigratedClient client);
+    // 어느 스레드에서나 호출 가능: 고정 파일 모드에서 슬롯 전달(MSG_RING)을 기다리는 연결을 보관하고 티켓을 돌려줌
+    // 대상 링의 RECV_MIGRATION_FD CQE가 티켓으로 연결을 찾아 새 슬롯으로 등록함
+    uint32_t addDirectClient(MigratedClient client);
+    // 어느 스레드에서나 호출 가능: 티켓으로 보관한 연결을 꺼냄 (슬롯 전달이 실패하면 소스 세션이 되찾음)
+    bool takeDirectClient(uint32_t ticket, MigratedClient& client);
+    // 어느 스레드에서나 호출 가능: 링에서 대기 중인 워커를 eventfd로 깨움
+    void wakeup();
+    // 어느 스레드에서나 호출 가능: 방 메시지를 수신함에 넣음 (비어 있던 수신함이면 true, 호출자가 워커를 깨워야 함)
+    bool postRoomMessage(RoomMessage* message) { return room_inbox_.push(message); }
     void removeClient(SocketPtr client_socket);
     size_t getClientCount() const { return client_sockets_.size(); }
+    bool hasPendingClients() const;
     
     // 이벤트 처리
     bool processEvents();
     
-    // 메시지 전송 헬퍼 메서드
-    void sendMessage(SocketPtr client_socket, MessageType msg_type, const void* data, size_t length, uint16_t buffer_idx);
+    // 링 통계 (워커 스레드 종료 후에 읽어야 함)
+    const SessionStats& getStats() const { return stats_; }
+    void logStats() const;
+    
+    // 메시지 전송 헬퍼 메서드 (연결이 v2면 flags를 실은 v2 헤더로 전송)
+    void sendMessage(SocketPtr client_socket, MessageType msg_type, const void* data, size_t length, uint16_t buffer_idx,
+                     uint8_t flags = FRAME_FLAG_NONE);
 
     // IOUring 직접 접근자 - 클라이언트 코드가 Session을 통해 IOUring에 접근할 수 있도록 함
     IOUring* getIOUring() { return io_ring_.get(); }
@@ -48,25 +166,344 @@ public:
 private:
     // I/O 이벤트 핸들러 (IOUring의 이벤트를 처리)
     void handleRead(io_uring_cqe* cqe, const Operation& ctx);
+    // 번들 recv 처리: 완성된 메시지를 모두 처리하고 남은 조각은 다음 CQE까지 보관 (클라이언트가 남아 있으면 true)
+    bool handleReadBundle(SocketPtr client_socket, uint16_t first_buffer_idx, unsigned bytes);
+    // 증분 소비 recv 처리: 버퍼 안의 이번 CQE 범위만 파싱 (buffer_more: 커널이 같은 버퍼를 계속 채움)
+    bool handleReadIncremental(SocketPtr client_socket, uint16_t buffer_idx, unsigned bytes, bool buffer_more);
+    // 크기 클래스 recv 처리: CQE의 컨텍스트에 기록된 클래스의 버퍼 그룹에서 데이터를 읽음
+    bool handleReadClassed(SocketPtr client_socket, uint16_t recv_class, uint16_t buffer_idx, unsigned bytes);
+    // 수신 크기 이력으로 다음에 쓸 클래스 결정 (가득 찬 버퍼는 즉시 승급, 창 단위로 강등)
+    void updateRecvClass(int32_t client_fd, unsigned recv_class, unsigned bytes, unsigned buffer_size);
+    // 목표 클래스로 멀티샷 recv 등록 / 아직 진행 중이면 클래스가 바뀌었을 때만 취소 요청
+    void armRecv(int32_t client_fd, bool poll_first = false);
+    void continueRecv(int32_t client_fd, bool more);
+    // ENOBUFS로 끝난 recv: 링을 늘릴 수 있으면 바로, 상한이면 버퍼가 돌아올 때까지 미뤄서 재등록
+    void handleRecvStarved(int32_t client_fd, unsigned recv_class);
+    // 배치마다: 남은 버퍼가 적은 그룹을 확장하고 여유가 생긴 그룹의 미뤄 둔 recv를 다시 등록
+    void maintainRecvBuffers();
+    // 수신 바이트를 이전 조각에 이어 메시지 단위로 처리하고 남은 조각만 rx_carry_에 보관 (클라이언트가 남아 있으면 true)
+    // buffer_idx: data가 들어 있는 기본 그룹 recv 버퍼 (큰 v2 프레임은 복사 대신 이 버퍼를 고정, NO_RECV_BUFFER면 복사)
+    bool consumeStream(SocketPtr client_socket, const uint8_t* data, size_t length,
+                       uint16_t buffer_idx = NO_RECV_BUFFER);
+    // 파서가 다 쓴 recv 버퍼 반환 (큰 프레임이 고정한 버퍼는 마지막 전송이 끝날 때 반환)
+    void finishRecvBuffer(uint16_t buffer_idx);
+    // 프레임 하나를 처리한 뒤 스트림이 끊겼는지 확인 (닫힘 또는 세션 이동 시작, 이동이면 남은 바이트를 넘김)
+    bool streamInterrupted(int32_t client_fd, const uint8_t* rest, size_t rest_length);
     void handleWrite(io_uring_cqe* cqe, const Operation& ctx);
+    void handleSendZc(io_uring_cqe* cqe, const Operation& ctx);
+    void handlePoolSend(io_uring_cqe* cqe, const Operation& ctx);
+    // 실패 CQE가 올라온 전송의 연결을 닫음 (이미 닫힌 연결의 흔한 오류는 로그 생략)
+    void closeAfterSendFailure(int32_t client_fd, int32_t res, const char* what);
     void handleClose(SocketPtr client_socket);
+    void handleWakeup(io_uring_cqe* cqe);
+    void handleReceivedFd(io_uring_cqe* cqe);
+    void handleReceivedClient(io_uring_cqe* cqe);
+    void handleAccept(io_uring_cqe* cqe);
+    void handleSendMigrationFailed(io_uring_cqe* cqe, const Operation& ctx);
+    void handleSendFdComplete(io_uring_cqe* cqe, const Operation& ctx);
+    void handleReceivedMigrationFd(io_uring_cqe* cqe, const Operation& ctx);
+    void handleSendRoomFailed(io_uring_cqe* cqe, const Operation& ctx);
+    void handleHistorySync(io_uring_cqe* cqe, const Operation& ctx);
+    void handleCloseComplete(io_uring_cqe* cqe, const Operation& ctx);
+    
+    // 워커 스레드 전용: 대기 중인 클라이언트를 등록하고 recv 준비
+    void drainPendingClients();
+    // 넘겨받은 (또는 넘기지 못해 되찾은) 연결을 등록하고 방 참가와 남은 바이트 처리를 이어 감
+    void adoptClient(MigratedClient& client);
+    // recv_class: 이동해 온 연결이 쓰던 크기 클래스 (-1: 기본 클래스)
+    void registerClient(SocketPtr client_socket, int recv_class = -1);
+    
+    // 세션 이동: 배치 끝에서 recv가 끝나고 송신 큐가 빈 연결을 대상 세션으로 넘김
+    void completeMigrations();
+    void tryCompleteMigration(int32_t client_fd);
+    // 고정 파일 모드: 슬롯을 대상 링으로 전달 (대상 테이블이 가득 차면 이 세션에 다시 등록)
+    void handOffDirectClient(const std::shared_ptr<Session>& target_session, MigratedClient client);
+    
+    // 연결별 송신 큐: 응답을 순서대로 쌓고, 진행 중인 전송이 없을 때만 앞쪽 응답을 모아 하나의 전송으로 제출
+    enum class SendSource : uint8_t {
+        POOL,                           // 송신 풀 슬롯
+        RECV,                           // 응답을 만든 recv 버퍼 (SENDING 상태, 제로 카피 가능)
+        PINNED,                         // 큰 프레임이 고정한 recv 버퍼 범위 (마지막 고정이 풀릴 때 반환)
+        SHARED,                         // 여러 연결이 함께 보내는 송신 풀 슬롯 (마지막 참조가 풀릴 때 반환)
+        HISTORY                         // 방 히스토리 세그먼트 매핑의 레코드 (id = 세그먼트 고정 번호)
+    };
+    struct QueuedSend {
+        SendSource source;
+        uint16_t id;                    // 슬롯 또는 recv 버퍼 ID
+        unsigned len;                   // 보낼 바이트 수
+        unsigned offset = 0;            // 이미 전송된 바이트 수 (짧은 전송이면 여기부터 이어서 보냄)
+        unsigned begin = 0;             // 버퍼 안에서 데이터가 시작하는 위치 (PINNED, SHARED, HISTORY)
+        unsigned frames = 0;            // 이 항목에서 끝나는 프레임 수 (송신 큐 상한 집계)
+        bool broadcast = false;         // 느린 수신자 정책으로 버릴 수 있는 브로드캐스트 프레임의 항목
+    };
+    struct SendQueue {
+        std::deque<QueuedSend> entries; // 앞쪽 in_flight개는 커널이 전송 중
+        unsigned in_flight = 0;         // 진행 중인 전송이 덮는 항목 수 (0: 전송 없음)
+        uint32_t in_flight_tag = 0;     // 진행 중인 전송의 (연산, 슬롯/버퍼/레코드) - 완료 CQE 대조용
+        size_t bytes = 0;               // 큐에 남은 항목의 바이트 수 (전송 중 포함)
+        unsigned frames = 0;            // 큐에 남은 프레임 수
+        bool closing = false;           // disconnect 정책으로 배치 끝에 닫을 연결 (더 넣지 않음)
+        bool mid_frame = false;         // 맨 앞 항목이 앞부분을 이미 보낸 프레임의 나머지
+        bool skip_blocked = false;      // skip 전송이 소켓 버퍼가 차서 돌아옴: 큐가 빌 때까지 완료를 받는 전송만 사용
+    };
+    void enqueueSend(int32_t client_fd, const QueuedSend& entry);
+    void pumpSendQueue(int32_t client_fd, SendQueue& queue);
+    // 전송 완료 CQE 반영: 다 나간 항목을 반환하고 남은 꼬리와 쌓인 응답을 이어서 제출 (연결을 닫아야 하면 false)
+    bool completeQueuedSend(const Operation& ctx, int32_t res);
+    // 연결 제거 시 송신 큐 정리: 진행 중인 항목은 완료 CQE까지 closed_sends_에 보관
+    void dropSendQueue(int32_t client_fd);
+    // 실패 CQE 없이 CQ를 지나간 skip 모드 전송을 성공으로 반영 (항목을 빼고 슬롯을 반환)
+    void reclaimSkipSends();
+    void releaseQueuedSend(const QueuedSend& entry);
+    const uint8_t* queuedSendAddr(const QueuedSend& entry);
+    
+    // 느린 수신자: 송신 큐 바이트/프레임 상한, 브로드캐스트 정책과 recv 흐름 제어
+    void pushQueued(SendQueue& queue, const QueuedSend& entry);
+    void popQueued(SendQueue& queue);
+    bool exceedsSendLimit(const SendQueue& queue, size_t extra_bytes, unsigned extra_frames) const;
+    // 상한을 넘게 하는 브로드캐스트 프레임에 정책 적용 (넣어도 되면 true)
+    bool admitBroadcast(int32_t client_fd, SendQueue& queue, size_t frame_bytes);
+    // 전송 중이 아닌 가장 오래된 브로드캐스트 프레임 하나를 버림 (버릴 것이 없으면 false)
+    bool dropQueuedBroadcast(SendQueue& queue);
+    // 큐가 상한에 닿으면 멀티샷 recv를 취소해 멈추고, 절반 아래로 줄면 다시 등록
+    void updateFlowControl(int32_t client_fd, const SendQueue& queue);
+    void pauseRecv(int32_t client_fd);
+    void resumeRecv(int32_t client_fd);
+    // 배치 끝: disconnect 정책으로 표시한 연결을 닫음 (팬아웃 도중에 방 멤버 목록을 바꾸지 않도록 미룸)
+    void closeSlowConsumers();
+    
+    // 배치 처리 후 CQ 오버플로/드롭을 집계하고 필요하면 링을 확장
+    void checkRingPressure();
     
-    // 메시지 처리 메서드들
-    void processMessage(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx);
-    void handleJoinSession(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx);
-    void handleLeaveSession(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx);
-    void handleChatMessage(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx);
+    // CQE가 없을 때: 적응형 예산만큼 스핀한 뒤 블로킹 대기 (수집한 CQE 수 또는 음수 오류 반환)
+    int waitForEvents();
+    uint64_t spinBudgetNs() const;
+    void recordIdleGap(uint64_t gap_ns);
     
-    // 세션 이동 처리
-    void onClientJoinSession(SocketPtr client_socket, int32_t target_session_id);
+    // 번들 recv 응답을 송신 풀 슬롯에 이어 붙이고, 대상이 바뀌거나 슬롯이 모두 차면 송신 큐로 넘김
+    // (프레임은 슬롯 경계에 걸칠 수 있음, 슬롯들은 순서대로 한 스트림으로 전송됨)
+    void queueOutbound(int32_t client_fd, MessageType msg_type, const void* data, size_t length,
+                       uint8_t flags = FRAME_FLAG_NONE);
+    void appendOutbound(int32_t client_fd, const uint8_t* data, size_t length);
+    void flushOutbound();
+    // 연결의 프로토콜 버전에 맞는 응답 헤더 기록 (바이트 수 반환)
+    size_t encodeResponseHeader(uint8_t* out, int32_t client_fd, MessageType msg_type, uint8_t flags, size_t length) const;
+    
+    // 메시지 처리 메서드들 (payload는 header.length 바이트, 연속된 메모리)
+    void processMessage(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx);
+    void handleJoinSession(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx);
+    void handleLeaveSession(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx);
+    void handleChatMessage(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx);
+    // CLIENT_COMMAND: "announce <토큰> <텍스트>"는 모든 세션의 모든 연결에 SERVER_NOTIFICATION으로 보냄
+    // (--announce-token과 같은 토큰을 보낸 연결만, --announce-interval-ms 간격으로)
+    void handleCommand(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx);
+    
+    // 채팅방: CLIENT_JOIN한 연결은 방 하나의 멤버 (에코만 받는 연결과 구분, 다른 방에 참가하면 이전 방에서 나감)
+    // 이 세션의 첫 멤버가 들어오거나 마지막 멤버가 나가면 RoomRegistry에 반영
+    void joinRoom(int32_t client_fd, int32_t room_id);
+    void leaveRoom(int32_t client_fd);
+    // 공유 송신 프레임: 헤더 + 페이로드를 송신 풀 슬롯에 한 번만 쓰고 수신자마다 참조 카운트를 올려 같은 슬롯을 전송
+    static constexpr unsigned MAX_SHARED_SLOTS =
+        (MAX_V2_MESSAGE_SIZE + MAX_FRAME_HEADER_SIZE + SendBufferPool::SLOT_SIZE - 1) / SendBufferPool::SLOT_SIZE;
+    struct SharedFrame {
+        unsigned count = 0;             // 사용한 슬롯 수 (0: 아직 만들지 않음)
+        uint16_t slots[MAX_SHARED_SLOTS];
+        unsigned lens[MAX_SHARED_SLOTS];
+    };
+    // payload가 nullptr이면 헤더만 씀 (pinned: 헤더 뒤에 이어 보낼 고정 recv 버퍼 범위)
+    bool buildSharedFrame(SharedFrame& frame, MessageType msg_type, uint8_t flags, const uint8_t* payload, size_t length,
+                          bool v2);
+    // 공유 참조 1(만드는 쪽)로 송신 풀 슬롯을 잡음 (풀이 비면 -1)
+    int acquireSharedSlot();
+    // 느린 수신자 정책으로 넣지 않았으면 false
+    bool enqueueShared(int32_t client_fd, const SharedFrame& frame, const std::vector<QueuedSend>* pinned = nullptr);
+    // 만든 쪽의 참조를 놓음 (수신자가 없었으면 슬롯이 바로 풀로 돌아감)
+    void releaseSharedFrame(const SharedFrame& frame);
+    void releaseSharedSlot(uint16_t slot);
+    // 송신자를 뺀 방 멤버에게 SERVER_CHAT으로 전달: 다른 세션에는 수신함으로 넘기고 이 세션의 멤버에게 팬아웃
+    void broadcastChat(int32_t sender_fd, int32_t room_id, const FrameHeader& header, const uint8_t* payload);
+    // 서버 전체 공지: 다른 모든 세션의 수신함에 넣고 이 세션의 모든 연결에 팬아웃 (브로드캐스트 번호 반환)
+    uint64_t announce(const uint8_t* text, size_t length);
+    // 공지 명령의 토큰 확인 (내용에 따라 비교 시간이 달라지지 않도록 끝까지 비교)
+    bool announceTokenMatches(const uint8_t* token, size_t length) const;
+    // 방 멤버가 있는 다른 세션(ANNOUNCE_ROOM이면 모든 세션)마다 수신함에 메시지를 넣고, 비어 있던 수신함이면
+    // MSG_RING으로 대상 워커를 깨움 (make_payload는 실제로 넘길 세션이 있을 때 한 번만 호출, 넘긴 본문 반환)
+    template <typename MakePayload>
+    std::shared_ptr<const RoomPayload> postToRoomSessions(int32_t room_id, const std::shared_ptr<BroadcastTracker>& tracker,
+                                                          MakePayload&& make_payload);
+    // 다른 세션이 넣은 방 메시지를 도착 순서대로 이 세션의 멤버에게 팬아웃
+    void drainRoomInbox();
+    
+    // 팬아웃 작업: 수신자 목록을 커서로 돌며 v1 / v2 수신자별 공유 프레임을 하나씩 만들어 넣음
+    // 배치 하나에서 fanout_slice_명까지만 보내고 남은 수신자는 다음 배치로 미뤄 다른 연결의 CQE 처리를 막지 않음
+    struct FanoutJob {
+        std::shared_ptr<BroadcastTracker> tracker;
+        std::shared_ptr<const RoomPayload> owned;  // 본문 소유자 (대기열에 들어가면 반드시 있음)
+        MessageType type = MessageType::SERVER_CHAT;
+        uint8_t flags = FRAME_FLAG_NONE;
+        const uint8_t* payload = nullptr;
+        size_t length = 0;
+        int32_t room_id = ANNOUNCE_ROOM;
+        int32_t sender_fd = -1;         // 건너뛸 연결 (-1: 없음)
+        std::vector<int32_t> targets;   // 대기열에 들어간 작업의 남은 수신자
+        size_t cursor = 0;
+        uint64_t delivered = 0;
+        SharedFrame frames[2];          // [0]: v1, [1]: v2 (만든 쪽 참조는 작업이 끝날 때 놓음)
+        bool pool_blocked = false;      // 송신 풀이 비어 멈춤: 다음 배치에서 한 번 더 시도하고 그래도 없으면 나머지를 버림
+    };
+    // 앞선 작업이 없으면 이번 배치 몫만큼 바로 보내고, 남으면 수신자와 본문을 복사해 대기열 끝에 넣음
+    void startFanout(FanoutJob&& job, const std::vector<int32_t>& targets);
+    // budget명까지 보냄 (수신자를 다 돌았으면 true)
+    bool runFanout(FanoutJob& job, const std::vector<int32_t>& targets, size_t& budget);
+    void finishFanout(FanoutJob& job);
+    // 배치 끝: 대기 중인 작업들을 순서대로 한 조각만큼 이어 보냄
+    void runFanoutSlices();
+    // 맨 앞 작업이 송신 풀을 기다리는데 슬롯이 돌아오지 않았으면 true (워커가 완료를 기다려도 됨)
+    bool fanoutWaitsForPool();
+    std::shared_ptr<BroadcastTracker> newTracker();
+    // 공유 프레임의 마지막 슬롯에 추적기를 붙여 모든 수신자의 전송이 끝난 시점을 잡음
+    void trackSharedFrame(const SharedFrame& frame, const std::shared_ptr<BroadcastTracker>& tracker);
+    void releaseTracker(const std::shared_ptr<BroadcastTracker>& tracker);
+    // 세션 번호 -> 세션 (처음 찾을 때 peer_sessions_에 채움, 없으면 nullptr)
+    Session* peerSession(int32_t target_id);
+    
+    // 큰 v2 프레임: 페이로드가 든 recv 버퍼 범위를 고정해 모으고, 완성되면 헤더만 새로 써서 같은 범위를 그대로 전송
+    struct LargeFrame;
+    bool beginLargeFrame(int32_t client_fd, const FrameHeader& header, uint16_t buffer_idx);
+    // 진행 중인 큰 프레임에 이번 데이터를 붙임 (소비한 바이트 수 반환, 완성되면 처리)
+    size_t continueLargeFrame(SocketPtr client_socket, const uint8_t* data, size_t length, uint16_t buffer_idx);
+    void dispatchLargeFrame(SocketPtr client_socket, LargeFrame& frame);
+    // 큰 프레임 브로드캐스트: 공유 헤더 슬롯 + 같은 고정 범위를 수신자마다 한 번 더 고정해 전송 (v2 수신자만)
+    void broadcastLargeFrame(int32_t sender_fd, int32_t room_id, const LargeFrame& frame);
+    void pinRecvBuffer(uint16_t buffer_idx);
+    void unpinRecvBuffer(uint16_t buffer_idx);
+    
+    // 방 히스토리: 보낸 세션이 기록하고 배치 끝에 기록한 세그먼트를 링에서 fdatasync (세그먼트마다 하나씩만 진행)
+    void appendHistory(int32_t room_id, uint8_t flags, const uint8_t* payload, size_t length);
+    void commitHistory();
+    // JOIN한 연결에 방의 최근 메시지를 전송: 헤더만 공유 슬롯에 쓰고 페이로드는 세그먼트 매핑을 그대로 가리킴
+    void replayHistory(int32_t client_fd, int32_t room_id);
+    // 재생 전송이 세그먼트 매핑을 쓰는 동안 참조를 쥐고 있음 (고정 번호 반환, 번호가 모자라면 -1)
+    int pinHistory(const std::shared_ptr<HistorySegment>& segment);
+    void unpinHistory(uint16_t pin);
+    
+    // 세션 이동 처리 (room_id: 대상 세션에 등록된 뒤 참가할 방, -1: 없음)
+    void onClientJoinSession(SocketPtr client_socket, int32_t target_session_id, int32_t room_id = -1);
     
     int32_t session_id_;
     // client_fds_ 세트 제거하고 client_sockets_ 맵만 사용
     std::unordered_map<int32_t, SocketPtr> client_sockets_; // 클라이언트 소켓 맵 (file descriptor -> Socket 객체)
     std::unique_ptr<IOUring> io_ring_;  // 세션별 전용 IOUring
     
+    // 다른 세션에서 넘겨받은 클라이언트 대기열 (pending_mutex_로 보호)
+    mutable std::mutex pending_mutex_;
+    std::vector<MigratedClient> pending_clients_;
+    std::unordered_map<uint32_t, MigratedClient> pending_direct_clients_;  // 이동 티켓 -> 슬롯 전달을 기다리는 연결
+    uint32_t next_direct_ticket_ = 0;
+    int wakeup_fd_{-1};                 // 대기열 추가 시 워커를 깨우는 eventfd
+    SocketPtr listening_socket_;        // 세션 전용 리스닝 소켓 (--reuseport-accept가 아니면 null)
+    
     // 통계용 변수
     size_t total_messages_{0};
+    SessionStats stats_;
+    unsigned last_dropped_cqes_{0};     // 직전에 읽은 cq.koverflow 값
+    
+    // 번들/증분 recv 상태
+    std::unordered_map<int32_t, std::vector<uint8_t>> rx_carry_;  // 클라이언트별 아직 완성되지 않은 메시지 조각
+    std::unordered_set<int32_t> v2_clients_;                     // v2 프레임을 보낸 연결 (응답도 v2)
+    struct LargeFrame {
+        FrameHeader header;
+        unsigned received = 0;          // 모은 페이로드 바이트 수
+        unsigned reserved = 0;          // 시작할 때 고정 예산에서 잡아 둔 버퍼 수
+        std::vector<QueuedSend> segments;  // 페이로드가 든 recv 버퍼 범위 (PINNED, 도착 순)
+    };
+    std::unordered_map<int32_t, LargeFrame> large_frames_;       // 조립 중인 큰 프레임
+    std::vector<uint16_t> recv_pins_;   // 기본 그룹 recv 버퍼별 고정 수
+    unsigned pinned_buffers_ = 0;       // 고정 수가 1 이상인 버퍼 수
+    unsigned pin_reserved_ = 0;         // 조립 중인 큰 프레임들이 잡아 둔 버퍼 수 (링이 고정 버퍼로 바닥나지 않도록 제한)
+    // 이 세션에 있는 방 멤버: 팬아웃은 배열을 순회하고, 퇴장은 위치 색인으로 마지막 멤버와 바꿔 지움
+    struct RoomMembers {
+        std::vector<int32_t> members;
+        std::unordered_map<int32_t, size_t> index;
+    };
+    std::unordered_map<int32_t, RoomMembers> rooms_;     // 방 번호 -> 이 세션의 멤버
+    std::unordered_map<int32_t, int32_t> client_rooms_;  // 연결 -> 참가한 방
+    RoomInbox room_inbox_;              // 다른 세션이 보낸 방 메시지
+    std::vector<int32_t> room_sessions_;  // RoomRegistry::sessionsOf 결과 재사용
+    std::vector<std::shared_ptr<Session>> peer_sessions_;  // 세션 번호 -> 세션 (처음 보낼 때 채움)
+    bool room_affinity_{false};         // --room-affinity: JOIN한 연결을 방의 홈 세션으로 옮김
+    std::vector<uint32_t> shared_refs_; // 송신 풀 슬롯별 공유 참조 수 (SHARED 항목 + 만드는 쪽)
+    std::vector<std::shared_ptr<BroadcastTracker>> slot_trackers_;  // 공유 프레임 마지막 슬롯 -> 완료 추적기
+    std::deque<FanoutJob> fanout_jobs_; // 나눠 보내는 중인 팬아웃 (먼저 시작한 것부터)
+    std::vector<int32_t> announce_targets_;  // 공지 수신자 스냅샷 재사용
+    std::string announce_token_;        // --announce-token (비어 있으면 공지 거부)
+    std::chrono::milliseconds announce_interval_{0};  // --announce-interval-ms
+    std::unordered_map<int32_t, std::chrono::steady_clock::time_point> last_announce_;  // 연결 -> 마지막 공지 시각
+    size_t fanout_slice_{0};            // --fanout-slice (0: 나누지 않음)
+    uint64_t fanout_budget_us_{0};      // --fanout-budget-ms (0: 검사 안 함)
+    std::vector<uint16_t> bundle_buffers_;                       // collectBundle 결과 재사용
+    // 크기 클래스 recv 상태 (클래스 번호는 IOUring::RECV_BUFFER_CLASSES 순서)
+    struct RecvClassState {
+        uint8_t current = 0;            // 진행 중인 recv가 쓰는 클래스
+        uint8_t target = 0;             // 다음에 등록할 클래스
+        bool cancelling = false;        // 클래스 전환을 위해 취소를 요청함
+        unsigned window_cqes = 0;       // 현재 관찰 창의 recv CQE 수
+        unsigned window_peak = 0;       // 현재 관찰 창에서 가장 큰 recv 크기
+    };
+    std::unordered_map<int32_t, RecvClassState> recv_class_state_;
+    std::vector<int32_t> starved_recvs_;  // 버퍼가 돌아오기를 기다리는 (recv가 등록되지 않은) 클라이언트
+    // CLIENT_JOIN으로 나가는 중인 연결: 멀티샷 recv를 취소하고 전송이 모두 끝나면 대상 링으로 넘김
+    struct Migration {
+        int32_t target_session = -1;
+        int32_t room = -1;              // 대상 세션에서 참가할 방
+        bool recv_done = false;         // 멀티샷 recv가 끝나 더 이상 이 링으로 데이터가 오지 않음
+        std::vector<uint8_t> carry;     // JOIN 뒤에 받은 바이트
+    };
+    std::unordered_map<int32_t, Migration> migrations_;
+    // 고정 파일 모드에서 대상 링으로 전달 중인 원본 슬롯 (SEND_FD 완료 CQE에서 닫거나 되찾음)
+    struct OutgoingFd {
+        uint32_t ticket = 0;            // 대상 세션이 연결을 보관한 티켓
+        size_t carry_bytes = 0;         // 함께 넘긴 바이트 수 (전달이 성공하면 통계에 반영)
+    };
+    std::unordered_map<int32_t, OutgoingFd> outgoing_fds_;
+    std::unordered_map<int32_t, SendQueue> send_queues_;
+    std::unordered_map<int32_t, bool> paused_recvs_;  // 송신 큐가 차서 recv를 멈춘 연결 -> recv가 실제로 끝났는지
+    std::vector<int32_t> slow_closes_;  // disconnect 정책으로 배치 끝에 닫을 연결
+    size_t send_queue_max_bytes_{0};    // --send-queue-bytes (0: 제한 없음)
+    unsigned send_queue_max_frames_{0}; // --send-queue-frames (0: 제한 없음)
+    SlowConsumerPolicy slow_consumer_{SlowConsumerPolicy::DROP_OLDEST};
+    // 방 히스토리
+    std::vector<std::shared_ptr<HistorySegment>> history_dirty_;  // 이번 배치에 기록한 (동기화할) 세그먼트
+    struct HistorySync {
+        std::shared_ptr<HistorySegment> segment;
+        size_t target;                  // 이 동기화가 덮는 기록 위치
+    };
+    std::unordered_map<uint16_t, HistorySync> history_syncs_;  // 진행 중인 fdatasync (태그 -> 세그먼트)
+    uint16_t next_history_sync_{0};
+    struct HistoryPin {
+        std::shared_ptr<HistorySegment> segment;
+        unsigned refs = 0;              // 이 세그먼트를 가리키는 HISTORY 항목 수
+    };
+    std::vector<HistoryPin> history_pins_;
+    std::vector<uint16_t> free_history_pins_;
+    std::unordered_map<const HistorySegment*, uint16_t> history_pin_ids_;
+    std::unordered_map<uint32_t, std::vector<QueuedSend>> closed_sends_;  // 닫힌 연결의 진행 중 전송 (태그 -> 항목)
+    std::vector<std::pair<int32_t, uint16_t>> confirmed_sends_;            // reclaimSkipSends 작업 목록 (재사용)
+    // 한 recv(또는 연속된 같은 연결의 CQE)에서 만든 응답: 가득 찬 슬롯은 넘어가며 모았다가 송신 큐에 한꺼번에 넣음
+    struct OutboundBatch {
+        int32_t client_fd = -1;
+        int slot = -1;                  // 채우는 중인 마지막 송신 풀 슬롯 (-1: 열린 배치 없음)
+        unsigned used = 0;              // 마지막 슬롯에 채운 바이트 수
+        unsigned frames = 0;            // 배치에 담긴 응답 수
+        unsigned count = 0;             // 가득 차서 넘어간 앞쪽 슬롯 수 (slots/lens에 기록)
+        uint16_t slots[IOUring::MAX_SEND_VECTOR];
+        unsigned lens[IOUring::MAX_SEND_VECTOR];
+    } outbound_;
+    
+    // 대기 전략 (--busy-poll-us, --wait-timeout-ms)
+    uint64_t busy_poll_max_ns_{0};      // 최대 스핀 예산 (0: 스핀 없이 바로 대기)
+    unsigned wait_timeout_ms_{0};       // 블로킹 대기 시간 제한 (0: 무제한)
+    uint64_t avg_idle_gap_ns_{0};       // CQE가 비어 있던 시점부터 다음 CQE 도착까지의 평균 (EWMA)
     
     // 반복적으로 사용되는 변수를 멤버로 이동
     io_uring_cqe* cqes_[CQE_BATCH_SIZE];
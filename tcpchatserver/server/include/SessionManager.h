@@ -8,21 +8,24 @@
 #include <set>
 #include <thread>
 #include <atomic>
+#include <string>
 
 class SessionManager {
 public:
+    static constexpr unsigned DEFAULT_SEND_POOL_SLOTS = 1024;  // --send-pool을 지정하지 않았을 때의 송신 풀 크기
+    
     static SessionManager& getInstance() {
         static SessionManager instance;
         return instance;
     }
 
     void initialize(unsigned int num_threads = 0);
+    // --reuseport-accept: start() 전에 세션마다 SO_REUSEPORT 리스닝 소켓을 세션 순서대로 bind (BPF 인덱스 = 세션 순서)
+    void openListeners(const std::string& host, uint16_t port);
     void start();
     void stop();
     
     int32_t getNextAvailableSession();
-    void removeSession(int32_t client_fd);
-    std::shared_ptr<Session> getSession(int32_t client_fd);
     std::shared_ptr<Session> getSessionByIndex(size_t index);
     const std::set<int32_t>& getSessionClients(int32_t session_id);
     const std::vector<int32_t>& getAvailableSessions() const { return available_sessions_; }
@@ -30,8 +33,11 @@ public:
     // 모든 세션의 이벤트 처리
     bool processEvents();
     
-    // 클라이언트를 라운드 로빈 방식으로 세션에 배정
-    int32_t assignClientToSession(SocketPtr client_socket);
+    // 새 클라이언트를 받을 세션을 라운드 로빈으로 선택 (세션 목록은 initialize 이후 불변이므로 락 없음)
+    std::shared_ptr<Session> pickSession();
+    
+    // 고정 파일 모드: 라운드 로빈으로 고정 파일 테이블에 여유가 있는 세션을 골라 슬롯 하나를 예약
+    std::shared_ptr<Session> reserveDirectSession();
     
 
 private:
@@ -43,12 +49,16 @@ private:
     // 세션별 워커 쓰레드 함수
     void sessionWorker(std::shared_ptr<Session> session);
     
+    // --session-cpu 설정에 따른 세션의 고정 CPU (-1: 고정 안 함)
+    static int sessionCpu(int32_t session_id);
+    
     std::unordered_map<int32_t, std::shared_ptr<Session>> sessions_;  // session_id -> Session
-    std::unordered_map<int32_t, int32_t> client_sessions_;           // client_fd -> session_id
     
     // 세션별 쓰레드 관리
     std::unordered_map<int32_t, std::thread> session_threads_;       // session_id -> thread
     std::atomic<bool> should_terminate_{false};                      // 종료 플래그
+    std::atomic<size_t> workers_ready_{0};                           // 링 활성화를 마친 워커 수
+    std::atomic<size_t> workers_failed_{0};                          // 링 활성화에 실패한 워커 수
     
     std::mutex mutex_;
     size_t next_session_id_{0};
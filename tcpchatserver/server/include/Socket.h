@@ -22,6 +22,9 @@ public:
     // 기존 소켓 FD로부터 생성
     explicit Socket(int existingSocketFd) : mType(TCP), mOwnsFd(true), mSocketFd(existingSocketFd) {}
 
+    // 소유권 지정 생성 - 고정 파일 슬롯처럼 io_uring이 닫는 디스크립터는 ownsFd=false
+    Socket(int existingSocketFd, bool ownsFd) : mSocketFd(existingSocketFd), mType(TCP), mOwnsFd(ownsFd) {}
+
     // 소멸자 - 소켓 자원 정리
     ~Socket() {
         close();
@@ -83,6 +86,12 @@ public:
         return result == 0;
     }
 
+    bool setReusePort(bool reuse) {
+        int optVal = reuse ? 1 : 0;
+        int result = setsockopt(mSocketFd, SOL_SOCKET, SO_REUSEPORT, &optVal, sizeof(optVal));
+        return result == 0;
+    }
+
     // 상태 확인 메서드
     bool isValid() const {
         return mSocketFd >= 0;
@@ -22,7 +22,12 @@ namespace SocketUtils {
     bool setSocketReuseAddr(SocketPtr socket, bool reuseAddr);
     
     // 리스닝 소켓 생성 (주소 바인딩 + 리스닝 시작)
-    SocketPtr createListeningSocket(const std::string& host, uint16_t port);
+    // reusePort가 true면 SO_REUSEPORT로 같은 포트에 여러 소켓을 묶어 커널이 연결을 나눠 줌
+    SocketPtr createListeningSocket(const std::string& host, uint16_t port, bool reusePort = false);
+    
+    // SO_REUSEPORT 그룹에 classic BPF를 붙여 연결을 처리한 CPU 기준으로 소켓을 고름
+    // (그룹 내 인덱스 = (cpu + cpuOffset) % groupSize, 인덱스는 bind 순서)
+    bool attachReuseportCpuSteering(SocketPtr socket, unsigned groupSize, unsigned cpuOffset = 0);
     
     // 클라이언트 소켓 생성 (연결 포함)
     SocketPtr createClientSocket(const std::string& host, uint16_t port);
@@ -6,6 +6,14 @@
 #include <chrono>
 #include <mutex>
 #include <iomanip>
+#include <vector>
+
+// provided buffer 소유 상태 (버퍼 ID별 장부)
+enum class BufferOwner : uint8_t {
+    IN_RING = 0,   // 링에 있어 커널이 recv에 고를 수 있음
+    PARSER = 1,    // recv CQE로 받아 세션이 처리 중
+    SENDING = 2    // 응답 전송(연결별 송신 큐, write/SEND_ZC)에 쓰이는 중, 모두 전송되면 반환
+};
 
 class UringBuffer {
 public:
@@ -14,17 +22,72 @@ public:
     static constexpr unsigned IO_BUFFER_SIZE = 1024;
     // The number of IO buffers to pre-allocate
     static constexpr uint16_t NUM_IO_BUFFERS = 4096;
+    static constexpr uint16_t DEFAULT_BUFFER_GROUP = 1;
+    // 증분 소비 모드 기본값: 64 KB 버퍼 64개 (작은 메시지 여러 개가 한 버퍼에 이어서 채워짐)
+    static constexpr unsigned INCREMENTAL_BUFFER_SIZE = 65536;
+    static constexpr uint16_t NUM_INCREMENTAL_BUFFERS = 64;
+    // 탄력적 확장: 남은 버퍼가 링에 올린 버퍼의 1/LOW_WATER_DIVISOR 아래로 떨어지면 GROW_CHUNK개씩 추가
+    static constexpr unsigned LOW_WATER_DIVISOR = 8;
+    static constexpr uint16_t GROW_CHUNK = 1024;
 
 
-    // 생성자 및 소멸자
-    explicit UringBuffer(io_uring* ring);
+    // 생성자 및 소멸자 (buffer_size, num_buffers는 2의 거듭제곱)
+    // incremental: IOU_PBUF_RING_INC로 등록하여 버퍼 하나를 여러 recv가 이어서 채우도록 함 (커널 6.12 이상)
+    // initial_buffers: 처음 링에 올릴 버퍼 수 (0: 전부), 나머지는 grow()로 num_buffers까지 추가
+    explicit UringBuffer(io_uring* ring, unsigned buffer_size = IO_BUFFER_SIZE, uint16_t num_buffers = NUM_IO_BUFFERS,
+                         bool incremental = false, uint16_t bgid = DEFAULT_BUFFER_GROUP, uint16_t initial_buffers = 0);
     ~UringBuffer();
 
     // 버퍼 관리 메서드
 
+    // 링에 다시 추가 (커널에 보이는 것은 flushReleases 이후, 이미 링에 있는 버퍼면 이중 반환으로 거부)
     void releaseBuffer(uint16_t idx, uint8_t* buf_base_addr);                        // 버퍼 사용 완료 표시
     uint8_t* getBufferAddr(uint16_t idx, uint8_t* buf_base_addr);                   // 버퍼 주소 반환
 
+    // 번들 recv CQE가 덮는 버퍼 ID 목록: 커널은 링에 들어간 순서대로 연속 소비하므로
+    // 첫 버퍼 ID에서 링 순서(successor_)를 따라가며 bytes를 덮는 만큼 수집
+    void collectBundle(uint16_t first_idx, unsigned bytes, std::vector<uint16_t>& out) const;
+
+    // 제로 카피 전송 중인 버퍼 추적: 알림 CQE(IORING_CQE_F_NOTIF) 전에는 커널이 아직 페이지를 참조하므로 재사용 금지
+    void holdForZeroCopy(uint16_t idx);
+    void completeZeroCopy(uint16_t idx);
+    bool isHeldForZeroCopy(uint16_t idx) const { return idx < num_buffers_ && zc_held_[idx] != 0; }
+    unsigned zeroCopyInFlight() const { return zc_in_flight_; }
+
+    // 증분 소비 모드: 커널은 버퍼의 남은 부분을 다음 recv에 이어서 쓰므로 데이터 위치(채움 오프셋)를 직접 추적
+    // consumeIncremental은 이번 CQE 데이터의 시작 주소를 반환하고, buffer_more가 false면 커널이 버퍼를 놓은 것
+    uint8_t* consumeIncremental(uint16_t idx, unsigned bytes, bool buffer_more);
+    // 파서가 처리를 마친 바이트 수를 반환: 커널이 놓았고 채워진 범위가 모두 반환되면 버퍼를 링에 재등록
+    void releaseIncremental(uint16_t idx, unsigned bytes);
+
+    // 소유 장부: recv CQE가 가져간 버퍼(first_idx부터 링 순서로 count개)를 PARSER로 기록
+    void markReceived(uint16_t first_idx, unsigned count = 1);
+    // 응답 전송에 넘긴 버퍼를 SENDING으로 기록 (송신 큐가 모두 전송한 뒤 releaseBuffer)
+    void markSending(uint16_t idx);
+    BufferOwner getOwner(uint16_t idx) const { return idx < num_buffers_ ? owner_[idx] : BufferOwner::IN_RING; }
+    // 이번 배치에 반환한 버퍼를 한 번의 tail 갱신으로 커널에 공개
+    void flushReleases();
+    // 디버그 모드: 배치가 끝났는데 아직 PARSER 상태인 버퍼는 누수이므로 보고하고 회수 (회수한 수 반환)
+    void setDebug(bool enabled) { debug_ = enabled; }
+    unsigned auditParserOwned();
+    uint64_t getDoubleReleases() const { return double_releases_; }
+
+    // 점유율: 링에 남은 (반환 대기 포함) 버퍼 수
+    unsigned available() const { return free_buffers_; }
+    unsigned getMinAvailable() const { return min_free_buffers_; }
+    unsigned getActiveBuffers() const { return active_buffers_; }
+    // 남은 버퍼가 최근 링에 올린 양의 일정 비율 이상인지 (recv 재등록 재개 기준)
+    bool hasHeadroom() const { return free_buffers_ * LOW_WATER_DIVISOR >= active_buffers_; }
+    bool isLow() const { return !hasHeadroom(); }
+    bool canGrow() const { return active_buffers_ < num_buffers_; }
+    // 아직 링에 올리지 않은 버퍼를 최대 count개 추가 (추가한 수 반환, 메모리는 커널이 처음 쓸 때 할당됨)
+    unsigned grow(unsigned count = GROW_CHUNK);
+
+    bool isIncremental() const { return incremental_; }
+    unsigned getBufferSize() const { return buffer_size_; }
+    uint16_t getNumBuffers() const { return num_buffers_; }
+    uint16_t getBufferGroup() const { return bgid_; }
+
     // 버퍼 기본 주소 반환
     uint8_t* getBaseAddr() const { return buffer_base_addr_; }
 
@@ -42,5 +105,25 @@ private:
     io_uring* ring_;                // io_uring 인스턴스 (소유권 없음)
     io_uring_buf_ring* buf_ring_;   // 버퍼 링
     uint8_t* buffer_base_addr_;     // 버퍼 메모리 시작 주소
+    const unsigned buffer_size_;    // 버퍼 하나의 크기
+    const uint16_t num_buffers_;    // 버퍼 개수 (링 엔트리 수)
+    const unsigned buffer_shift_;   // log2(buffer_size_)
+    const uint16_t bgid_;           // 버퍼 그룹 ID
     const unsigned ring_size_;      // 전체 버퍼 링 크기
+    bool incremental_;              // IOU_PBUF_RING_INC 등록 여부
+    unsigned active_buffers_{0};    // 지금까지 링에 올린 버퍼 수 (ID 0..active_buffers_-1)
+    unsigned free_buffers_{0};      // 링에 남아 커널이 고를 수 있는 버퍼 수
+    unsigned min_free_buffers_{0};  // free_buffers_의 최저치 (최대 점유율)
+    unsigned pending_adds_{0};      // 링에 썼지만 아직 tail을 넘기지 않은 버퍼 수
+    std::vector<BufferOwner> owner_;   // 버퍼별 소유 상태
+    bool debug_{false};
+    std::vector<uint16_t> received_this_batch_;  // 디버그 모드: 이번 배치에 PARSER가 된 버퍼
+    uint64_t double_releases_{0};
+    std::vector<unsigned> inc_filled_;    // 증분 모드: 버퍼별 커널이 채운 바이트 수 (다음 데이터 오프셋)
+    std::vector<unsigned> inc_released_;  // 증분 모드: 버퍼별 파서가 반환한 바이트 수
+    std::vector<uint8_t> inc_retired_;    // 증분 모드: 커널이 버퍼를 놓았는지 (IORING_CQE_F_BUF_MORE 없는 CQE)
+    std::vector<uint8_t> zc_held_;  // 버퍼별 제로 카피 알림 대기 여부 (세션 스레드 전용)
+    std::vector<uint16_t> successor_;  // 버퍼별로 링에서 바로 다음에 추가된 버퍼 ID
+    uint16_t last_added_{0};           // 링에 마지막으로 추가한 버퍼 ID
+    unsigned zc_in_flight_{0};      // 알림을 기다리는 버퍼 수
 }; 
\ No newline at end of file
@@ -3,14 +3,16 @@
 #include "Listener.h"
 #include "Utils.h"
 #include "Logger.h"
+#include "ServerConfig.h"
 #include <csignal>
 #include <thread>
 
 std::atomic<bool> running(true);
 
 int main(int argc, char* argv[]) {
-    if (argc < 3 || argc > 4) {
-        LOG_ERROR("Usage: ", argv[0], " <host> <port> [num_threads]");
+    if (argc < 3) {
+        LOG_ERROR("Usage: ", argv[0], " <host> <port> [num_threads] [--option[=value] ...]");
+        ServerConfig::printOptions();
         return 1;
     }
 
@@ -20,12 +22,23 @@ int main(int argc, char* argv[]) {
         
         // 쓰레드 수 인수 처리 (선택적)
         unsigned int num_threads = 0;  // 기본값 0은 CPU 코어 수 사용
-        if (argc == 4) {
+        int next_arg = 3;
+        if (argc > 3 && std::string(argv[3]).compare(0, 2, "--") != 0) {
             num_threads = static_cast<unsigned int>(std::stoi(argv[3]));
             if (num_threads == 0) {
                 LOG_ERROR("Number of threads must be greater than 0");
                 return 1;
             }
+            next_arg = 4;
+        }
+        
+        // 나머지 인수는 --key=value 형식의 서버 옵션
+        auto& config = ServerConfig::getInstance();
+        for (int i = next_arg; i < argc; ++i) {
+            if (!config.parseOption(argv[i])) {
+                ServerConfig::printOptions();
+                return 1;
+            }
         }
 
         // 현재 로그 레벨 출력
@@ -54,11 +67,33 @@ int main(int argc, char* argv[]) {
             LOG_INFO("Using hardware concurrency: ", std::thread::hardware_concurrency(), " cores");
         }
 
+        if (config.reuseport_cpu_steer && !config.reuseport_accept) {
+            LOG_WARN("--reuseport-cpu-steer requires --reuseport-accept, ignoring");
+        }
+
         // 세션 매니저 초기화 및 시작
         auto& session_manager = SessionManager::getInstance();
         session_manager.initialize(num_threads);
+        if (config.reuseport_accept) {
+            // 세션마다 SO_REUSEPORT 소켓을 열어 각 세션 링이 직접 accept (워커 시작 전에 bind)
+            session_manager.openListeners("0.0.0.0", static_cast<uint16_t>(port));
+        }
         session_manager.start();
 
+        if (config.reuseport_accept) {
+            LOG_INFO("Server started successfully with per-session reuseport listeners");
+
+            // accept는 세션 쓰레드가 처리하므로 메인 쓰레드는 종료만 기다림
+            while (running) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+
+            LOG_INFO("Shutting down server...");
+            session_manager.stop();
+            LOG_INFO("Server shutdown complete");
+            return 0;
+        }
+
         // 리스너 생성 및 시작 (클라이언트 연결 수락 담당)
         auto& listener = Listener::getInstance(port);
         listener.start();
@@ -67,12 +102,10 @@ int main(int argc, char* argv[]) {
 
         // 메인 루프
         while (running) {
-            // 소켓 매니저가 새 연결을 수락하고 세션 매니저에 할당
+            // 리스너가 새 연결을 수락하고 세션 링에 전달 (CQE가 없으면 링에서 블로킹 대기하므로 별도 sleep 없음)
             listener.processEvents();
             
             // 각 세션은 이제 자체 쓰레드에서 이벤트를 처리하므로 여기서 호출하지 않음
-            
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
 
         LOG_INFO("Shutting down server...");
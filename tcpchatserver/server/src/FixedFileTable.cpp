@@ -0,0 +1,76 @@
+#include "FixedFileTable.h"
+#include "Logger.h"
+#include <stdexcept>
+#include <cstring>
+#include <sys/resource.h>
+
+FixedFileTable::FixedFileTable(io_uring* ring, unsigned num_slots)
+    : ring_(ring), num_slots_(num_slots), in_use_(num_slots, 0)
+{
+    if (!ring_) {
+        LOG_ERROR("Cannot initialize FixedFileTable with null io_uring pointer");
+        throw std::invalid_argument("Null io_uring pointer");
+    }
+
+    int ret = io_uring_register_files_sparse(ring_, num_slots_);
+    if (ret < 0) {
+        LOG_ERROR("Failed to register sparse file table (", num_slots_, " slots): ", strerror(-ret));
+        throw std::runtime_error("Failed to register fixed file table");
+    }
+
+    LOG_INFO("FixedFileTable registered with ", num_slots_, " slots");
+}
+
+unsigned FixedFileTable::clampToFileLimit(unsigned num_slots) {
+    rlimit nofile{};
+    if (getrlimit(RLIMIT_NOFILE, &nofile) == 0 && nofile.rlim_cur != RLIM_INFINITY && num_slots > nofile.rlim_cur) {
+        LOG_WARN("[FixedFileTable] Clamping fixed file slots from ", num_slots, " to RLIMIT_NOFILE ", nofile.rlim_cur);
+        return static_cast<unsigned>(nofile.rlim_cur);
+    }
+    return num_slots;
+}
+
+FixedFileTable::~FixedFileTable() {
+    if (ring_) {
+        io_uring_unregister_files(ring_);
+    }
+}
+
+bool FixedFileTable::reserve() {
+    unsigned current = used_.load(std::memory_order_relaxed);
+    do {
+        if (current >= num_slots_) {
+            return false;
+        }
+    } while (!used_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+    return true;
+}
+
+void FixedFileTable::unreserve() {
+    used_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool FixedFileTable::commit(unsigned slot, bool reserved) {
+    if (slot >= num_slots_) {
+        LOG_ERROR("[FixedFileTable] Invalid slot commit: ", slot);
+        return false;
+    }
+    if (in_use_[slot]) {
+        LOG_ERROR("[FixedFileTable] Slot ", slot, " committed twice");
+        return false;
+    }
+    if (!reserved) {
+        used_.fetch_add(1, std::memory_order_relaxed);
+    }
+    in_use_[slot] = 1;
+    return true;
+}
+
+void FixedFileTable::release(unsigned slot) {
+    if (slot >= num_slots_ || !in_use_[slot]) {
+        LOG_ERROR("[FixedFileTable] Invalid slot release: ", slot);
+        return;
+    }
+    in_use_[slot] = 0;
+    used_.fetch_sub(1, std::memory_order_relaxed);
+}
@@ -6,16 +6,45 @@
 #include <string.h>
 #include <sstream>
 #include <iomanip>
+#include <poll.h>
+#include <sys/socket.h>
+#include <algorithm>
 
-IOUring::IOUring() : ring_initialized_(false) {
-    initRing();
-    buffer_manager_ = std::make_unique<UringBuffer>(&ring_);
+namespace {
+
+unsigned roundUpPow2(size_t value) {
+    unsigned result = 1;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+IOUring::IOUring(const RingOptions& options) : ring_initialized_(false) {
+    fixed_file_slots_ = options.fixed_file_slots;
+    provided_buffers_ = options.provided_buffers;
+    iowq_max_workers_[0] = options.iowq_max_bounded;
+    iowq_max_workers_[1] = options.iowq_max_unbounded;
+    iowq_cpu_ = options.iowq_cpu;
+    send_pool_slots_ = options.send_pool_slots;
+    send_skip_success_ = options.send_skip_success && options.send_pool_slots > 0;
+    initRing(options);
+    // 비활성 상태로 생성된 링은 소유 스레드의 activate()에서 버퍼 링/파일 테이블을 등록
+    if (!(ring_.flags & IORING_SETUP_R_DISABLED)) {
+        initRegisteredResources();
+    }
 }
 
 IOUring::~IOUring() {
     try {
-        // First release the buffer_manager_ which depends on the ring_
+        // First release the buffer_manager_, file table and send pool which depend on the ring_
+        recv_classes_.clear();
+        extra_buffer_groups_.clear();
         buffer_manager_.reset();
+        file_table_.reset();
+        send_pool_.reset();
         
         // Then clean up the io_uring instance
         if (ring_initialized_) {
@@ -28,17 +57,266 @@ IOUring::~IOUring() {
     }
 }
 
-void IOUring::initRing() {
+void IOUring::initRing(const RingOptions& options) {
     io_uring_params params{};
     memset(&params, 0, sizeof(params));
 
-    int ret = io_uring_queue_init_params(NUM_SUBMISSION_QUEUE_ENTRIES, &ring_, &params);
+    if (options.sqpoll) {
+        params.flags |= IORING_SETUP_SQPOLL;
+        params.sq_thread_idle = options.sq_thread_idle_ms;
+        if (options.sq_thread_cpu >= 0) {
+            params.flags |= IORING_SETUP_SQ_AFF;
+            params.sq_thread_cpu = static_cast<__u32>(options.sq_thread_cpu);
+        }
+    }
+    if (options.attach_wq_fd >= 0) {
+        params.flags |= IORING_SETUP_ATTACH_WQ;
+        params.wq_fd = static_cast<__u32>(options.attach_wq_fd);
+    }
+    if (options.single_issuer) {
+        // 링은 메인 스레드에서 생성되지만 세션 스레드가 구동하므로, 비활성 상태로 만들고
+        // activate()를 호출한 스레드가 유일한 제출자가 되도록 함
+        params.flags |= IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_R_DISABLED;
+        // SQPOLL과는 IPI 관련 플래그를 함께 쓸 수 없음
+        if (!(params.flags & IORING_SETUP_SQPOLL)) {
+            params.flags |= IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_COOP_TASKRUN;
+        }
+    }
+
+    // CQ 크기를 직접 지정 (CLAMP: 커널 상한을 넘으면 오류 대신 상한으로 축소)
+    const unsigned cq_setup_flags = options.cq_entries > 0 ? (IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP) : 0;
+    params.flags |= cq_setup_flags;
+    params.cq_entries = options.cq_entries;
+
+    const unsigned sq_entries = options.sq_entries > 0 ? options.sq_entries : NUM_SUBMISSION_QUEUE_ENTRIES;
+    int ret = io_uring_queue_init_params(sq_entries, &ring_, &params);
+    if (ret < 0 && (params.flags & IORING_SETUP_ATTACH_WQ)) {
+        // 부모 링이 사라졌거나 다른 프로세스 소유이면 독립 링으로 생성
+        LOG_WARN("Attaching to ring ", options.attach_wq_fd, " failed (", strerror(-ret), "), creating standalone ring");
+        params.flags &= ~IORING_SETUP_ATTACH_WQ;
+        params.wq_fd = 0;
+        ret = io_uring_queue_init_params(sq_entries, &ring_, &params);
+    }
+    if (ret == -EINVAL && (params.flags & IORING_SETUP_SINGLE_ISSUER)) {
+        // 6.1 미만 커널은 SINGLE_ISSUER/DEFER_TASKRUN을 지원하지 않음
+        LOG_WARN("Single-issuer ring setup not supported (", strerror(-ret), "), using default profile");
+        params.flags &= ~(IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_R_DISABLED |
+                          IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_COOP_TASKRUN);
+        ret = io_uring_queue_init_params(sq_entries, &ring_, &params);
+    }
+    if (ret < 0 && (params.flags & IORING_SETUP_SQPOLL)) {
+        // 권한 부족(구형 커널의 CAP_SYS_NICE 요구) 또는 미지원 커널에서는 일반 링으로 대체
+        LOG_WARN("SQPOLL ring setup failed (", strerror(-ret), "), falling back to interrupt-driven submission");
+        memset(&params, 0, sizeof(params));
+        params.flags = cq_setup_flags;
+        params.cq_entries = options.cq_entries;
+        ret = io_uring_queue_init_params(sq_entries, &ring_, &params);
+    }
     if (ret < 0) {
         LOG_FATAL("Failed to initialize io_uring: ", ret);
         throw std::runtime_error("Failed to initialize io_uring");
     }
-    LOG_INFO("io_uring initialized successfully");
+
+    sqpoll_ = (params.flags & IORING_SETUP_SQPOLL) != 0;
+    single_issuer_ = (params.flags & IORING_SETUP_SINGLE_ISSUER) != 0;
+    defer_taskrun_ = (params.flags & IORING_SETUP_DEFER_TASKRUN) != 0;
+    register_ring_fd_ = options.register_ring_fd;
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+    // 커널은 DEFER_TASKRUN 링만 크기 변경을 허용함
+    auto_resize_ = options.auto_resize && defer_taskrun_;
+    if (options.auto_resize && !auto_resize_) {
+        LOG_INFO("Runtime ring resizing requires the single-issuer profile, CQ stays at ", cq_entries_);
+    }
+    if (sqpoll_) {
+        LOG_INFO("io_uring initialized with SQPOLL (idle ", params.sq_thread_idle, "ms, cpu ",
+                 options.sq_thread_cpu, ", attached ", options.attach_wq_fd >= 0 ? "yes" : "no", ")");
+    } else {
+        LOG_INFO("io_uring initialized successfully");
+    }
+    LOG_INFO("io_uring ring sizes: SQ ", sq_entries_, ", CQ ", cq_entries_);
     ring_initialized_ = true;
+
+    if (options.recv_bundle && provided_buffers_) {
+#ifdef IORING_RECVSEND_BUNDLE
+        recv_bundle_ = (params.features & IORING_FEAT_RECVSEND_BUNDLE) != 0;
+#endif
+        if (recv_bundle_) {
+            LOG_INFO("Bundled multishot recv enabled");
+        } else {
+            LOG_WARN("IORING_RECVSEND_BUNDLE not supported (kernel 6.10+ required), using single-buffer recv");
+        }
+    }
+
+    if (options.recv_incremental && provided_buffers_) {
+        recv_incremental_ = true;
+        recv_buffer_size_ = options.recv_buffer_size ? options.recv_buffer_size : UringBuffer::INCREMENTAL_BUFFER_SIZE;
+        recv_buffer_count_ = options.recv_buffer_count ? options.recv_buffer_count : UringBuffer::NUM_INCREMENTAL_BUFFERS;
+        // 번들 수집은 버퍼가 가득 채워진다는 가정(collectBundle)에 의존하므로 증분 버퍼와 함께 쓰지 않음
+        if (recv_bundle_) {
+            LOG_WARN("Bundled recv disabled in favour of incremental buffer consumption");
+            recv_bundle_ = false;
+        }
+    }
+
+    buffer_debug_ = options.buffer_debug;
+    recv_buffer_cap_ = options.recv_buffer_cap ? options.recv_buffer_cap : UringBuffer::NUM_IO_BUFFERS;
+    recv_buffers_initial_ = options.recv_buffers ? std::min(options.recv_buffers, recv_buffer_cap_) : recv_buffer_cap_;
+
+    if (options.recv_size_classes && provided_buffers_) {
+        if (recv_incremental_) {
+            // 증분 버퍼가 이미 작은 메시지의 버퍼 낭비를 해결하므로 둘을 겹쳐 쓰지 않음
+            LOG_WARN("Recv size classes ignored in favour of incremental buffer consumption");
+        } else {
+            recv_size_classes_ = true;
+            // collectBundle은 한 그룹 안의 링 순서를 따라가므로 그룹을 바꿔 가며 쓰는 클래스 모드와 함께 쓰지 않음
+            if (recv_bundle_) {
+                LOG_WARN("Bundled recv disabled in favour of recv size classes");
+                recv_bundle_ = false;
+            }
+        }
+    }
+
+    // 제로 카피 전송은 6.0 이상에서만 가능하며, 실패한 전송은 메시지 유실이므로 미리 확인
+    if (options.send_zc_threshold > 0 && provided_buffers_) {
+        if (isOpcodeSupported(IORING_OP_SEND_ZC)) {
+            send_zc_threshold_ = options.send_zc_threshold;
+            LOG_INFO("Zero-copy send enabled for payloads of ", send_zc_threshold_, " bytes or more");
+        } else {
+            LOG_WARN("IORING_OP_SEND_ZC not supported by this kernel, using copying writes");
+        }
+    }
+}
+
+bool IOUring::isOpcodeSupported(int opcode) {
+    io_uring_probe* probe = io_uring_get_probe_ring(&ring_);
+    if (!probe) {
+        return false;
+    }
+    const bool supported = io_uring_opcode_supported(probe, opcode) != 0;
+    io_uring_free_probe(probe);
+    return supported;
+}
+
+void IOUring::initRegisteredResources() {
+    if (fixed_file_slots_ > 0 && !file_table_) {
+        file_table_ = std::make_unique<FixedFileTable>(&ring_, fixed_file_slots_);
+    }
+    if (send_pool_slots_ > 0 && !send_pool_) {
+        // 합쳐지거나 recv 경계에 걸친 프레임의 응답은 송신 풀이 있어야 보낼 수 있으므로 등록하지 못하면 (RLIMIT_MEMLOCK 등) 시작을 중단
+        try {
+            send_pool_ = std::make_unique<SendBufferPool>(&ring_, send_pool_slots_);
+        } catch (const std::exception& e) {
+            LOG_ERROR("Failed to create send buffer pool: ", e.what());
+            throw std::runtime_error(std::string("Failed to create send buffer pool: ") + e.what());
+        }
+    }
+    if (provided_buffers_ && !buffer_manager_) {
+        if (recv_incremental_) {
+            // IOU_PBUF_RING_INC는 6.12 이상에서만 등록되므로 실패하면 기본 버퍼 링으로 대체
+            try {
+                buffer_manager_ = std::make_unique<UringBuffer>(&ring_, recv_buffer_size_,
+                                                                static_cast<uint16_t>(recv_buffer_count_), true);
+                LOG_INFO("Incremental recv buffers enabled (", recv_buffer_count_, " x ", recv_buffer_size_, " bytes)");
+            } catch (const std::exception& e) {
+                LOG_WARN("Incremental recv buffers unavailable (", e.what(), "), using default buffer ring");
+                recv_incremental_ = false;
+            }
+        }
+        if (!buffer_manager_) {
+            buffer_manager_ = std::make_unique<UringBuffer>(&ring_, UringBuffer::IO_BUFFER_SIZE,
+                                                            static_cast<uint16_t>(recv_buffer_cap_), false,
+                                                            UringBuffer::DEFAULT_BUFFER_GROUP,
+                                                            static_cast<uint16_t>(recv_buffers_initial_));
+            if (buffer_manager_->canGrow()) {
+                LOG_INFO("Recv buffers start at ", recv_buffers_initial_, " and grow up to ", recv_buffer_cap_);
+            }
+        }
+        initRecvClasses();
+    }
+}
+
+void IOUring::initRecvClasses() {
+    recv_classes_.clear();
+    extra_buffer_groups_.clear();
+    default_recv_class_ = 0;
+    if (recv_size_classes_) {
+        // 기본 그룹(bgid 1)은 그대로 두고 나머지 클래스는 bgid 2부터 등록
+        try {
+            uint16_t next_bgid = UringBuffer::DEFAULT_BUFFER_GROUP + 1;
+            for (const RecvBufferClass& cls : RECV_BUFFER_CLASSES) {
+                if (cls.buffer_size == buffer_manager_->getBufferSize()) {
+                    default_recv_class_ = static_cast<unsigned>(recv_classes_.size());
+                    recv_classes_.push_back(buffer_manager_.get());
+                    continue;
+                }
+                extra_buffer_groups_.push_back(
+                    std::make_unique<UringBuffer>(&ring_, cls.buffer_size, cls.num_buffers, false, next_bgid++));
+                recv_classes_.push_back(extra_buffer_groups_.back().get());
+            }
+            LOG_INFO("Recv size classes enabled (", recv_classes_.size(), " buffer groups)");
+            return;
+        } catch (const std::exception& e) {
+            LOG_WARN("Recv size classes disabled: ", e.what());
+            recv_size_classes_ = false;
+            recv_classes_.clear();
+            extra_buffer_groups_.clear();
+            default_recv_class_ = 0;
+        }
+    }
+    recv_classes_.push_back(buffer_manager_.get());
+}
+
+void IOUring::activate() {
+    if (activated_) {
+        return;
+    }
+
+    if (ring_.flags & IORING_SETUP_R_DISABLED) {
+        int ret = io_uring_enable_rings(&ring_);
+        if (ret < 0) {
+            LOG_FATAL("Failed to enable io_uring: ", strerror(-ret));
+            throw std::runtime_error("Failed to enable io_uring");
+        }
+    }
+
+    // 등록된 링 fd는 호출한 스레드에서만 유효하므로 반드시 소유 스레드에서 등록
+    if (register_ring_fd_) {
+        int ret = io_uring_register_ring_fd(&ring_);
+        if (ret < 0) {
+            LOG_WARN("io_uring_register_ring_fd failed: ", strerror(-ret), ", using plain ring fd");
+        }
+    }
+
+    initRegisteredResources();
+    applyIoWqLimits();
+
+    activated_ = true;
+    LOG_INFO("io_uring activated (single issuer: ", single_issuer_ ? "yes" : "no", ")");
+}
+
+void IOUring::applyIoWqLimits() {
+    // io-wq는 제출한 태스크(스레드) 단위로 생성되므로 소유 스레드에서 호출해야 그 스레드의 풀에 적용됨
+    if (iowq_max_workers_[0] > 0 || iowq_max_workers_[1] > 0) {
+        unsigned values[2] = {iowq_max_workers_[0], iowq_max_workers_[1]};  // 0은 해당 항목 변경 안 함
+        int ret = io_uring_register_iowq_max_workers(&ring_, values);
+        if (ret < 0) {
+            LOG_WARN("io_uring_register_iowq_max_workers failed: ", strerror(-ret));
+        } else {
+            LOG_INFO("io-wq max workers set to bounded ", iowq_max_workers_[0], ", unbounded ", iowq_max_workers_[1],
+                     " (previous ", values[0], "/", values[1], ")");
+        }
+    }
+
+    if (iowq_cpu_ >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(iowq_cpu_, &cpu_set);
+        int ret = io_uring_register_iowq_aff(&ring_, sizeof(cpu_set), &cpu_set);
+        if (ret < 0) {
+            LOG_WARN("io_uring_register_iowq_aff(", iowq_cpu_, ") failed: ", strerror(-ret));
+        }
+    }
 }
 
 io_uring_sqe* IOUring::getSQE() {
@@ -49,7 +327,11 @@ io_uring_sqe* IOUring::getSQE() {
 
     io_uring_sqe* sqe = io_uring_get_sqe(&ring_);
     if (!sqe) {
-        io_uring_submit(&ring_);
+        submit();
+        // SQPOLL에서는 submit이 SQ 슬롯을 즉시 비우지 않으므로 폴러가 소비할 때까지 대기
+        if (sqpoll_) {
+            io_uring_sqring_wait(&ring_);
+        }
         sqe = io_uring_get_sqe(&ring_);
         if (!sqe) {
             LOG_ERROR("Failed to get SQE after submit");
@@ -59,10 +341,44 @@ io_uring_sqe* IOUring::getSQE() {
     return sqe;
 }
 
-int IOUring::submitAndWait() {
-    int ret = io_uring_submit_and_wait(&ring_, NUM_WAIT_ENTRIES);
+int IOUring::submit() {
+    flushBufferReleases();
+    if (!sqpoll_) {
+        const int ret = io_uring_submit(&ring_);
+        reclaimIssuedSends();
+        return ret;
+    }
+
+    // SQPOLL: 폴러가 깨어 있으면 tail 갱신만으로 제출이 끝나고 시스템 콜이 발생하지 않음.
+    // 폴러가 잠든 경우(IORING_SQ_NEED_WAKEUP)에만 io_uring_submit이 IORING_ENTER_SQ_WAKEUP으로 깨움
+    if (io_uring_sq_ready(&ring_) == 0) {
+        reclaimIssuedSends();
+        return 0;
+    }
+    if (IO_URING_READ_ONCE(*ring_.sq.kflags) & IORING_SQ_NEED_WAKEUP) {
+        ++sqpoll_wakeups_;
+    }
+    // SQPOLL에서는 폴러가 나중에 실행하므로 회수는 다음 submit/대기 이후로 미뤄짐
+    const int ret = io_uring_submit(&ring_);
+    reclaimIssuedSends();
+    return ret;
+}
+
+int IOUring::submitAndWait(unsigned timeout_ms) {
+    flushBufferReleases();
+    int ret;
+    if (timeout_ms == 0) {
+        ret = io_uring_submit_and_wait(&ring_, NUM_WAIT_ENTRIES);
+    } else {
+        __kernel_timespec ts{};
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+        io_uring_cqe* cqe = nullptr;
+        ret = io_uring_submit_and_wait_timeout(&ring_, &cqe, NUM_WAIT_ENTRIES, &ts, nullptr);
+    }
+    reclaimIssuedSends();
     if (ret < 0) {
-        if (ret != -EINTR) {
+        if (ret != -EINTR && ret != -ETIME) {
             LOG_ERROR("io_uring_submit_and_wait failed: ", ret);
         }
         return ret;
@@ -70,6 +386,64 @@ int IOUring::submitAndWait() {
     return 0;
 }
 
+unsigned IOUring::submissionEntriesFor(size_t connections) {
+    return std::clamp(roundUpPow2(connections), MIN_SUBMISSION_QUEUE_ENTRIES, NUM_SUBMISSION_QUEUE_ENTRIES);
+}
+
+unsigned IOUring::completionEntriesFor(size_t connections, unsigned sq_entries) {
+    // 멀티샷 recv는 연결마다 여러 CQE를 연달아 올릴 수 있으므로 연결당 여유분을 둠
+    const unsigned wanted = roundUpPow2(connections * CQES_PER_CONNECTION);
+    return std::clamp(wanted, std::min(2 * sq_entries, MAX_COMPLETION_QUEUE_ENTRIES), MAX_COMPLETION_QUEUE_ENTRIES);
+}
+
+bool IOUring::growForConnections(size_t connections, bool overflowed) {
+    if (!auto_resize_ || cq_entries_ >= MAX_COMPLETION_QUEUE_ENTRIES) {
+        return false;
+    }
+
+    unsigned target = cq_entries_;
+    if (connections * CQES_PER_CONNECTION > cq_entries_) {
+        target = completionEntriesFor(connections, sq_entries_);
+    }
+    if (overflowed) {
+        target = std::max(target, cq_entries_ * 2);
+    }
+    target = std::min(target, MAX_COMPLETION_QUEUE_ENTRIES);
+    if (target <= cq_entries_) {
+        return false;
+    }
+
+#if defined(IO_URING_CHECK_VERSION) && !IO_URING_CHECK_VERSION(2, 9)
+    // 아직 커널에 넘기지 않은 SQE가 새 링으로 옮겨지도록 먼저 제출
+    if (io_uring_sq_ready(&ring_) > 0) {
+        submit();
+    }
+
+    io_uring_params params{};
+    params.sq_entries = sq_entries_;
+    params.cq_entries = target;
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP;
+    int ret = io_uring_resize_rings(&ring_, &params);
+    if (ret < 0) {
+        // 6.13 미만 커널(-EINVAL) 등에서는 한 번 실패하면 더 시도하지 않음
+        LOG_WARN("io_uring_resize_rings to CQ ", target, " failed (", strerror(-ret), "), disabling runtime resizing");
+        auto_resize_ = false;
+        return false;
+    }
+
+    LOG_INFO("io_uring CQ resized from ", cq_entries_, " to ", params.cq_entries, " (", connections,
+             " connections", overflowed ? ", after overflow" : "", ")");
+    sq_entries_ = params.sq_entries;
+    cq_entries_ = params.cq_entries;
+    return true;
+#else
+    // liburing 2.9 미만에는 io_uring_resize_rings가 없음
+    LOG_INFO("Runtime ring resizing needs liburing 2.9 or newer, CQ stays at ", cq_entries_);
+    auto_resize_ = false;
+    return false;
+#endif
+}
+
 void IOUring::setContext(io_uring_sqe* sqe, OperationType type, int client_fd, uint16_t buffer_idx) {
     static_assert(8 == sizeof(__u64));  // user_data 크기 확인
     
@@ -84,31 +458,98 @@ void IOUring::setContext(io_uring_sqe* sqe, OperationType type, int client_fd, u
         return;
     }
     
-    // user_data 메모리 접근 전 포인터 유효성 검사
-    try {
-        auto* buffer = reinterpret_cast<uint8_t*>(&sqe->user_data);
-
-        // client_fd 쓰기 (4 bytes)
-        *(reinterpret_cast<int32_t*>(buffer)) = client_fd;
-        buffer += 4;
-        // type 쓰기 (1 byte)
-        *buffer = static_cast<uint8_t>(type);
-        buffer += 1;
-        // buffer_idx 쓰기 (2 bytes)
-        *(reinterpret_cast<uint16_t*>(buffer)) = buffer_idx;
-    } catch (const std::exception& e) {
-        LOG_ERROR("Exception in IOUring::setContext: ", e.what());
-    }
+    sqe->user_data = makeContext(type, client_fd, buffer_idx);
 }
 
 void IOUring::prepareAccept(int socket_fd) {
     io_uring_sqe* sqe = getSQE();
     setContext(sqe, OperationType::ACCEPT, -1, 0);
     const int flags = 0;
-    io_uring_prep_multishot_accept(sqe, socket_fd, nullptr, 0, flags);
+    if (file_table_) {
+        // 커널이 고정 파일 테이블의 빈 슬롯을 골라 설치하고 CQE res로 슬롯 번호를 반환
+        io_uring_prep_multishot_accept_direct(sqe, socket_fd, nullptr, 0, flags);
+    } else {
+        io_uring_prep_multishot_accept(sqe, socket_fd, nullptr, 0, flags);
+    }
 }
 
-void IOUring::prepareRead(int client_fd) {
+void IOUring::prepareWakeup(int event_fd) {
+    io_uring_sqe* sqe = getSQE();
+    io_uring_prep_poll_multishot(sqe, event_fd, POLLIN);
+    setContext(sqe, OperationType::WAKEUP, event_fd, 0);
+}
+
+void IOUring::noteRecvBuffers(unsigned recv_class, uint16_t buffer_idx, unsigned bytes, uint32_t cqe_flags) {
+    if (!(cqe_flags & IORING_CQE_F_BUFFER) || recv_class >= recv_classes_.size()) {
+        return;
+    }
+    UringBuffer& group = *recv_classes_[recv_class];
+    if (group.isIncremental()) {
+        return;  // 증분 버퍼는 커널이 버퍼를 놓는 시점(consumeIncremental)에 기록
+    }
+    unsigned consumed = 1;
+    if (recv_bundle_ && bytes > 0) {
+        consumed = (bytes + group.getBufferSize() - 1) / group.getBufferSize();
+    }
+    group.markReceived(buffer_idx, consumed);
+}
+
+void IOUring::discardRecvBuffers(unsigned recv_class, uint16_t buffer_idx, unsigned bytes, uint32_t cqe_flags) {
+    if (!(cqe_flags & IORING_CQE_F_BUFFER) || recv_class >= recv_classes_.size()) {
+        return;
+    }
+    UringBuffer& group = *recv_classes_[recv_class];
+    if (group.isIncremental()) {
+#ifdef IORING_CQE_F_BUF_MORE
+        const bool buffer_more = (cqe_flags & IORING_CQE_F_BUF_MORE) != 0;
+#else
+        const bool buffer_more = false;
+#endif
+        if (group.consumeIncremental(buffer_idx, bytes, buffer_more)) {
+            group.releaseIncremental(buffer_idx, bytes);
+        }
+        return;
+    }
+    // 번들이면 링 순서를 따라 bytes가 덮는 버퍼를 먼저 모두 모은 뒤 반환 (반환하면 순서 정보가 바뀜)
+    std::vector<uint16_t> span{buffer_idx};
+    if (recv_bundle_ && bytes > 0) {
+        group.collectBundle(buffer_idx, bytes, span);
+    }
+    for (uint16_t idx : span) {
+        if (group.getOwner(idx) == BufferOwner::PARSER) {
+            group.releaseBuffer(idx, group.getBaseAddr());
+        }
+    }
+}
+
+unsigned IOUring::auditRecvBuffers() {
+    if (!buffer_debug_) {
+        return 0;
+    }
+    unsigned leaked = 0;
+    for (UringBuffer* group : recv_classes_) {
+        leaked += group->auditParserOwned();
+    }
+    return leaked;
+}
+
+void IOUring::flushBufferReleases() {
+    for (UringBuffer* group : recv_classes_) {
+        group->flushReleases();
+    }
+}
+
+unsigned IOUring::growRecvBuffers() {
+    unsigned added = 0;
+    for (UringBuffer* group : recv_classes_) {
+        if (group->canGrow() && group->isLow()) {
+            added += group->grow();
+        }
+    }
+    return added;
+}
+
+void IOUring::prepareRead(int client_fd, bool poll_first, unsigned recv_class) {
     if (client_fd < 0) {
         LOG_ERROR("IOUring::prepareRead called with invalid client_fd: ", client_fd);
         return;
@@ -121,15 +562,42 @@ void IOUring::prepareRead(int client_fd) {
             return;
         }
         
-        setContext(sqe, OperationType::READ, client_fd, 0);
+        if (recv_class >= recv_classes_.size()) {
+            recv_class = default_recv_class_;
+        }
+        setContext(sqe, OperationType::READ, client_fd, static_cast<uint16_t>(recv_class));
         io_uring_prep_recv_multishot(sqe, client_fd, nullptr, 0, 0);
+#ifdef IORING_RECVSEND_BUNDLE
+        if (recv_bundle_) {
+            sqe->ioprio |= IORING_RECVSEND_BUNDLE;
+        }
+#endif
+        if (poll_first) {
+            sqe->ioprio |= IORING_RECVSEND_POLL_FIRST;
+        }
         sqe->flags |= IOSQE_BUFFER_SELECT;
-        sqe->buf_group = 1;  // Buffer group ID
+        if (file_table_) {
+            sqe->flags |= IOSQE_FIXED_FILE;
+        }
+        sqe->buf_group = recv_classes_.empty() ? UringBuffer::DEFAULT_BUFFER_GROUP
+                                               : recv_classes_[recv_class]->getBufferGroup();
     } catch (const std::exception& e) {
         LOG_ERROR("Exception in prepareRead for client_fd ", client_fd, ": ", e.what());
     }
 }
 
+void IOUring::prepareCancelRead(int client_fd, unsigned recv_class) {
+    io_uring_sqe* sqe = getSQE();
+    if (!sqe) {
+        LOG_ERROR("Failed to get SQE for prepareCancelRead, client_fd: ", client_fd);
+        return;
+    }
+    // recv의 user_data(READ, fd, 클래스)로 대상을 찾음, 성공 CQE는 필요 없으므로 생략
+    io_uring_prep_cancel64(sqe, makeContext(OperationType::READ, client_fd, static_cast<uint16_t>(recv_class)), 0);
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+    setContext(sqe, OperationType::CANCEL, client_fd, static_cast<uint16_t>(recv_class));
+}
+
 void IOUring::prepareWrite(int client_fd, const void* buf, unsigned len, uint16_t bid) {
     io_uring_sqe* sqe = getSQE();
     if (!sqe) {
@@ -143,23 +611,186 @@ void IOUring::prepareWrite(int client_fd, const void* buf, unsigned len, uint16_
         return;
     }
 
-    io_uring_prep_write(sqe, client_fd, buf, len, 0);
-    setContext(sqe, OperationType::WRITE, client_fd, bid);
+    // 큰 응답은 소켓 버퍼로 복사하지 않고 페이지를 직접 전송 (버퍼는 알림 CQE까지 보류)
+    // MSG_WAITALL: 알림 전에 버퍼를 돌려받으므로 나머지를 다시 보낼 수 없어 커널이 끝까지 이어서 전송
+    if (wantsZeroCopy(len)) {
+        io_uring_prep_send_zc(sqe, client_fd, buf, len, MSG_NOSIGNAL | MSG_WAITALL, 0);
+        buffer_manager_->holdForZeroCopy(bid);
+        setContext(sqe, OperationType::SEND_ZC, client_fd, bid);
+    } else {
+        io_uring_prep_write(sqe, client_fd, buf, len, 0);
+        setContext(sqe, OperationType::WRITE, client_fd, bid);
+    }
+    if (file_table_) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
 }
 
 void IOUring::prepareClose(int client_fd) {
     io_uring_sqe* sqe = getSQE();
     setContext(sqe, OperationType::CLOSE, client_fd);
-    io_uring_prep_close(sqe, client_fd);
+    if (file_table_) {
+        io_uring_prep_close_direct(sqe, static_cast<unsigned>(client_fd));
+    } else {
+        io_uring_prep_close(sqe, client_fd);
+    }
+}
+
+void IOUring::prepareSendClient(int target_ring_fd, int client_fd, uint16_t tag) {
+    io_uring_sqe* sqe = getSQE();
+    // fd 번호는 프로세스 전체에서 유효하므로 값만 대상 링의 CQE(res)로 넘기면 됨
+    io_uring_prep_msg_ring(sqe, target_ring_fd, static_cast<unsigned>(client_fd),
+                           makeContext(OperationType::RECV_CLIENT, client_fd, 0), 0);
+    setContext(sqe, OperationType::SEND_CLIENT, client_fd, tag);
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+}
+
+void IOUring::prepareSendMigration(int target_ring_fd, int client_fd, uint16_t tag) {
+    io_uring_sqe* sqe = getSQE();
+    // 연결 상태는 대상 세션의 대기열로 이미 넘겼으므로 CQE는 대상 워커를 깨우는 알림 역할만 함
+    io_uring_prep_msg_ring(sqe, target_ring_fd, static_cast<unsigned>(client_fd),
+                           makeContext(OperationType::RECV_MIGRATION, client_fd, 0), 0);
+    setContext(sqe, OperationType::SEND_MIGRATION, client_fd, tag);
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
 }
 
-void IOUring::handleWriteComplete(int32_t client_fd, uint16_t buffer_idx, int32_t bytes_written) {
-    if (bytes_written < 0) {
-        LOG_ERROR("Write failed for client ", client_fd, ": ", bytes_written);
+void IOUring::prepareRoomNotify(int target_ring_fd, uint16_t tag) {
+    io_uring_sqe* sqe = getSQE();
+    // 메시지는 대상 세션의 수신함에 이미 들어 있으므로 CQE는 대상 워커를 깨우는 알림 역할만 함
+    io_uring_prep_msg_ring(sqe, target_ring_fd, 0, makeContext(OperationType::RECV_ROOM, -1, 0), 0);
+    setContext(sqe, OperationType::SEND_ROOM, -1, tag);
+    sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+}
+
+bool IOUring::prepareHistorySync(int file_fd, uint16_t tag) {
+    io_uring_sqe* sqe = getSQE();
+    if (!sqe) {
+        LOG_ERROR("Failed to get SQE for prepareHistorySync, fd: ", file_fd);
+        return false;
     }
+    // 세그먼트는 미리 할당해 크기가 바뀌지 않으므로 데이터만 반영 (일반 fd, 고정 파일 테이블과 무관)
+    io_uring_prep_fsync(sqe, file_fd, IORING_FSYNC_DATASYNC);
+    setContext(sqe, OperationType::HISTORY_SYNC, -1, tag);
+    return true;
+}
 
-    // 버퍼 재사용을 위해 io_uring_buf_ring에 다시 추가
-    releaseBuffer(buffer_idx);
+void IOUring::prepareSendFd(int target_ring_fd, unsigned slot, uint64_t target_user_data, uint16_t tag) {
+    io_uring_sqe* sqe = getSQE();
+    // 대상 링의 빈 슬롯에 설치 (대상 CQE의 res가 새 슬롯 번호), 원본 슬롯은 송신 완료 후 닫아야 함
+    io_uring_prep_msg_ring_fd_alloc(sqe, target_ring_fd, static_cast<int>(slot), target_user_data, 0);
+    setContext(sqe, OperationType::SEND_FD, static_cast<int>(slot), tag);
+}
+
+void IOUring::prepareSendFromPool(int client_fd, uint16_t slot, unsigned len, bool skip_success) {
+    io_uring_sqe* sqe = getSQE();
+    if (!sqe) {
+        LOG_ERROR("Failed to get SQE for prepareSendFromPool, client_fd: ", client_fd);
+        return;
+    }
+
+    const uint8_t* addr = send_pool_->getSlotAddr(slot);
+    if (skip_success && send_skip_success_) {
+        // MSG_DONTWAIT: poll 재시도 없이 커널이 SQE를 가져가는 시점에 한 번만 실행 (소켓이 가득 차면 -EAGAIN CQE)
+        // MSG_WAITALL: 일부만 전송된 경우도 실패로 처리되어 (res는 보낸 바이트 수) CQE가 생략되지 않음
+        io_uring_prep_send(sqe, client_fd, addr, len, MSG_DONTWAIT | MSG_WAITALL | MSG_NOSIGNAL);
+        sqe->ioprio |= IORING_RECVSEND_FIXED_BUF;
+        sqe->buf_index = slot;
+        sqe->flags |= IOSQE_CQE_SKIP_SUCCESS;
+        setContext(sqe, OperationType::SEND_SKIP, client_fd, slot);
+        skip_pending_.push_back(SkipSend{ring_.sq.sqe_tail - 1, client_fd, slot});
+    } else {
+        io_uring_prep_write_fixed(sqe, client_fd, addr, len, 0, slot);
+        setContext(sqe, OperationType::WRITE_FIXED, client_fd, slot);
+    }
+    if (file_table_) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+}
+
+uint16_t IOUring::prepareSendVector(int client_fd, const iovec* iov, unsigned count) {
+    io_uring_sqe* sqe = getSQE();
+    
+    uint16_t record;
+    if (!free_send_vectors_.empty()) {
+        record = free_send_vectors_.back();
+        free_send_vectors_.pop_back();
+    } else {
+        record = static_cast<uint16_t>(send_vectors_.size());
+        send_vectors_.emplace_back();
+    }
+    
+    SendVector& vec = send_vectors_[record];
+    std::copy(iov, iov + count, vec.iov);
+    vec.msg = msghdr{};
+    vec.msg.msg_iov = vec.iov;
+    vec.msg.msg_iovlen = count;
+    
+    // MSG_WAITALL: 소켓 버퍼가 모자라 일부만 나가면 커널이 나머지를 이어서 전송
+    io_uring_prep_sendmsg(sqe, client_fd, &vec.msg, MSG_NOSIGNAL | MSG_WAITALL);
+    setContext(sqe, OperationType::SEND_VECTOR, client_fd, record);
+    if (file_table_) {
+        sqe->flags |= IOSQE_FIXED_FILE;
+    }
+    return record;
+}
+
+void IOUring::releaseSendVector(uint16_t record) {
+    if (record >= send_vectors_.size()) {
+        LOG_ERROR("Invalid send vector record: ", record);
+        return;
+    }
+    free_send_vectors_.push_back(record);
+}
+
+void IOUring::reclaimIssuedSends() {
+    if (skip_pending_.empty()) {
+        return;
+    }
+
+    // 커널은 제출한 SQE의 완료 CQE를 올린 뒤에 SQ head를 갱신하므로, head가 지나간 MSG_DONTWAIT 전송은
+    // 이미 소켓 버퍼로 복사되었거나 실패 CQE가 지금의 CQ tail 앞에 있음
+    const unsigned head = io_uring_smp_load_acquire(ring_.sq.khead);
+    const unsigned cq_tail = io_uring_smp_load_acquire(ring_.cq.ktail);
+    while (!skip_pending_.empty() && static_cast<int>(head - skip_pending_.front().position) > 0) {
+        SkipSend issued = skip_pending_.front();
+        issued.position = cq_tail;
+        skip_issued_.push_back(issued);
+        skip_pending_.pop_front();
+    }
+}
+
+void IOUring::discardSkipSend(uint16_t slot) {
+    // 슬롯은 송신 큐 항목 하나가 소유하므로 진행 중인 skip 전송 사이에서 유일함
+    for (auto* list : {&skip_issued_, &skip_pending_}) {
+        auto it = std::find_if(list->begin(), list->end(), [slot](const SkipSend& send) { return send.slot == slot; });
+        if (it != list->end()) {
+            list->erase(it);
+            return;
+        }
+    }
+}
+
+void IOUring::takeConfirmedSends(std::vector<std::pair<int32_t, uint16_t>>& out) {
+    reclaimIssuedSends();
+    // CQ head는 세션이 advanceCQ로 처리를 마친 위치
+    const unsigned consumed = *ring_.cq.khead;
+    while (!skip_issued_.empty() && static_cast<int>(consumed - skip_issued_.front().position) >= 0) {
+        out.emplace_back(skip_issued_.front().client_fd, skip_issued_.front().slot);
+        skip_issued_.pop_front();
+    }
+}
+
+bool IOUring::handleSendZcComplete(io_uring_cqe* cqe, uint16_t buffer_idx) {
+    // SEND_ZC는 전송 결과 CQE(F_MORE면 알림이 뒤따름)와 커널이 페이지를 놓았음을 알리는 F_NOTIF CQE를 올림
+    if (cqe->flags & IORING_CQE_F_NOTIF) {
+        buffer_manager_->completeZeroCopy(buffer_idx);
+        return true;
+    }
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        // 알림이 오지 않는 경우(전송 자체가 실패 등)에는 결과 CQE에서 바로 반환
+        buffer_manager_->completeZeroCopy(buffer_idx);
+    }
+    return false;
 }
 
 unsigned IOUring::peekCQE(io_uring_cqe** cqes) {
@@ -176,6 +807,15 @@ unsigned IOUring::peekCQE(io_uring_cqe** cqes) {
     return io_uring_peek_batch_cqe(&ring_, cqes, CQE_BATCH_SIZE);
 }
 
+unsigned IOUring::pollCQE(io_uring_cqe** cqes) {
+    // DEFER_TASKRUN 링은 io_uring_enter(GETEVENTS) 없이는 recv 완료가 CQ에 올라오지 않으므로
+    // 스핀 중에도 대기 없는 get_events로 task work를 실행해야 함
+    if (defer_taskrun_) {
+        io_uring_get_events(&ring_);
+    }
+    return peekCQE(cqes);
+}
+
 void IOUring::advanceCQ(unsigned count) {
     io_uring_cq_advance(&ring_, count);
 }
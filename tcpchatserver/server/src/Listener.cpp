@@ -2,6 +2,7 @@
 #include "SessionManager.h"
 #include "SocketManager.h"
 #include "Logger.h"
+#include "ServerConfig.h"
 #include <stdexcept>
 #include "Context.h"
 #include <string>
@@ -21,7 +22,15 @@ Listener& Listener::getInstance(int port) {
 
 Listener::Listener(int port)
     : port_(port), running_(false), session_manager_(SessionManager::getInstance()) {
-    io_ring_ = std::make_unique<IOUring>();
+    // Listener는 recv를 하지 않으므로 provided buffer ring 없이 작은 링만 생성
+    RingOptions ring_options;
+    ring_options.sq_entries = NUM_SUBMISSION_QUEUE_ENTRIES;
+    ring_options.provided_buffers = false;
+    if (ServerConfig::getInstance().direct_fds) {
+        // 세션 테이블과 마찬가지로 RLIMIT_NOFILE을 넘으면 등록이 실패하므로 같은 상한을 적용
+        ring_options.fixed_file_slots = FixedFileTable::clampToFileLimit(NUM_FIXED_FILE_SLOTS);
+    }
+    io_ring_ = std::make_unique<IOUring>(ring_options);
     LOG_INFO("[Listener] Created with dedicated IOUring");
 }
 
@@ -48,6 +57,8 @@ void Listener::start() {
     LOG_INFO("[Listener] Server listening on port ", port_, ", socket: ", listening_socket_->getSocketFd());
 
     running_ = true;
+    // Listener 링은 메인 스레드가 구동
+    io_ring_->activate();
     io_ring_->prepareAccept(listening_socket_->getSocketFd());
 }
 
@@ -81,31 +92,24 @@ void Listener::processEvents() {
 
         Operation ctx = getContext(cqe);
 
-        if (ctx.op_type == OperationType::ACCEPT) {
-            if (cqe->res < 0) {
-                LOG_ERROR("[Listener] Accept failed: ", -cqe->res);
-            } else {
-                int client_fd = cqe->res;
-                
-                // 클라이언트 소켓을 Socket 클래스로 래핑
-                SocketPtr clientSocket = std::make_shared<Socket>(client_fd);
-                
-                // 논블로킹 모드 설정
-                if (!clientSocket->setNonBlocking(true)) {
-                    LOG_ERROR("[Listener] Failed to set non-blocking mode for client ", client_fd);
-                    clientSocket.reset(); // 소켓 닫기
-                    continue;
+        switch (ctx.op_type) {
+            case OperationType::ACCEPT:
+                handleAccept(cqe);
+                break;
+            case OperationType::SEND_FD:
+                handleSendFdComplete(cqe, ctx);
+                break;
+            case OperationType::SEND_CLIENT:
+                handleSendClientFailed(cqe, ctx);
+                break;
+            case OperationType::CLOSE:
+                if (FixedFileTable* file_table = io_ring_->getFileTable()) {
+                    file_table->release(static_cast<unsigned>(ctx.client_fd));
                 }
-                
-                LOG_INFO("[Listener] New client connected: ", client_fd);
-                
-                // SessionManager를 통해 세션에 클라이언트 할당
-                auto& sessionManager = SessionManager::getInstance();
-                sessionManager.assignClientToSession(clientSocket);
-                
-                // 새로운 ACCEPT 작업 등록
-                io_ring_->prepareAccept(listening_socket_->getSocketFd());
-            }
+                break;
+            default:
+                LOG_ERROR("[Listener] Unknown operation type: ", static_cast<int>(ctx.op_type));
+                break;
         }
     }
 
@@ -113,6 +117,85 @@ void Listener::processEvents() {
     io_ring_->submit();
 }
 
+void Listener::handleAccept(io_uring_cqe* cqe) {
+    if (cqe->res < 0) {
+        LOG_ERROR("[Listener] Accept failed: ", -cqe->res);
+    } else if (io_ring_->usesFixedFiles()) {
+        dispatchDirectClient(static_cast<unsigned>(cqe->res));
+    } else {
+        dispatchClient(cqe->res);
+    }
+    
+    // 멀티샷 accept가 종료된 경우에만 새로운 ACCEPT 작업 등록
+    if (!(cqe->flags & IORING_CQE_F_MORE) && listening_socket_ && listening_socket_->isValid()) {
+        io_ring_->prepareAccept(listening_socket_->getSocketFd());
+    }
+}
+
+void Listener::dispatchClient(int client_fd) {
+    // fd는 세션 링이 close로 닫으므로 여기서는 소유권 없이 논블로킹 설정만 수행
+    Socket client_socket(client_fd, false);
+    if (!client_socket.setNonBlocking(true)) {
+        LOG_ERROR("[Listener] Failed to set non-blocking mode for client ", client_fd);
+        io_ring_->prepareClose(client_fd);
+        return;
+    }
+    
+    auto session = session_manager_.pickSession();
+    if (!session) {
+        LOG_ERROR("[Listener] No available sessions to assign client ", client_fd);
+        io_ring_->prepareClose(client_fd);
+        return;
+    }
+    
+    // 락이나 eventfd 없이 세션 링에 RECV_CLIENT CQE로 전달 (세션 워커가 자기 스레드에서 등록)
+    const int32_t session_id = session->getSessionId();
+    io_ring_->prepareSendClient(session->getIOUring()->getRingFd(), client_fd,
+                                static_cast<uint16_t>(session_id));
+    LOG_INFO("[Listener] New client ", client_fd, " dispatched to session ", session_id);
+}
+
+void Listener::handleSendClientFailed(io_uring_cqe* cqe, const Operation& ctx) {
+    // 성공 CQE는 생략되므로 여기에는 전달 실패만 옴 (대상 링이 닫혔거나 CQ가 가득 참)
+    LOG_ERROR("[Listener] Failed to pass client ", ctx.client_fd, " to session ", ctx.buffer_idx, ": ", -cqe->res);
+    io_ring_->prepareClose(ctx.client_fd);
+}
+
+void Listener::dispatchDirectClient(unsigned slot) {
+    FixedFileTable* file_table = io_ring_->getFileTable();
+    file_table->commit(slot, false);
+    
+    auto session = session_manager_.reserveDirectSession();
+    if (!session) {
+        LOG_ERROR("[Listener] Rejecting client in slot ", slot, ": all session file tables are full");
+        io_ring_->prepareClose(static_cast<int>(slot));
+        return;
+    }
+    
+    // 세션 링의 고정 파일 테이블로 복사하고, 세션은 RECV_FD CQE로 새 슬롯을 받음
+    const int32_t session_id = session->getSessionId();
+    io_ring_->prepareSendFd(session->getIOUring()->getRingFd(), slot,
+                            makeContext(OperationType::RECV_FD, -1, 0),
+                            static_cast<uint16_t>(session_id));
+    LOG_INFO("[Listener] New client in slot ", slot, " dispatched to session ", session_id);
+}
+
+void Listener::handleSendFdComplete(io_uring_cqe* cqe, const Operation& ctx) {
+    const unsigned slot = static_cast<unsigned>(ctx.client_fd);
+    
+    if (cqe->res < 0) {
+        LOG_ERROR("[Listener] Failed to pass slot ", slot, " to session ", ctx.buffer_idx, ": ", -cqe->res);
+        // 세션에 예약해 둔 용량을 되돌림
+        auto session = session_manager_.getSessionByIndex(ctx.buffer_idx);
+        if (session && session->getIOUring()->getFileTable()) {
+            session->getIOUring()->getFileTable()->unreserve();
+        }
+    }
+    
+    // 세션 링이 자체 참조를 가지므로 Listener 쪽 슬롯은 닫음
+    io_ring_->prepareClose(static_cast<int>(slot));
+}
+
 void Listener::stop() {
     running_ = false;
     if (listening_socket_ && listening_socket_->isValid()) {
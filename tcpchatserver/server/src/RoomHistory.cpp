@@ -0,0 +1,405 @@
+#include "RoomHistory.h"
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// 세그먼트 레코드 헤더 (파일에 그대로 기록)
+struct RecordHeader {
+    uint32_t length;    // 페이로드 길이 (0: 레코드 끝)
+    uint32_t checksum;  // checksum을 0으로 둔 헤더 + 페이로드의 CRC32C
+    uint64_t time_ms;   // 기록 시각 (유닉스 ms)
+    uint8_t type;
+    uint8_t flags;
+    uint8_t reserved[6];
+};
+static_assert(sizeof(RecordHeader) == HistorySegment::RECORD_HEADER_SIZE, "record header layout");
+
+// CRC32C (Castagnoli, 반사 다항식 0x82F63B78) 바이트 단위 테이블
+struct Crc32cTable {
+    uint32_t entries[256];
+    Crc32cTable() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+uint32_t crc32c(uint32_t crc, const uint8_t* data, size_t length) {
+    static const Crc32cTable table;
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+uint32_t recordChecksum(RecordHeader record, const uint8_t* payload) {
+    record.checksum = 0;
+    const uint32_t crc = crc32c(0, reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    return crc32c(crc, payload, record.length);
+}
+
+// 재시작 뒤에도 보관 기간을 이어서 재야 하므로 벽시계 시간 사용
+uint64_t nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+size_t alignRecord(size_t position) {
+    return (position + HistorySegment::RECORD_ALIGN - 1) & ~(HistorySegment::RECORD_ALIGN - 1);
+}
+
+bool isHistoryType(uint8_t type) {
+    return type == static_cast<uint8_t>(MessageType::SERVER_CHAT) ||
+           type == static_cast<uint8_t>(MessageType::SERVER_NOTIFICATION);
+}
+
+} // namespace
+
+HistorySegment::HistorySegment(const std::string& path, uint64_t sequence, int fd, uint8_t* base, size_t capacity)
+    : path_(path), sequence_(sequence), fd_(fd), base_(base), capacity_(capacity) {
+}
+
+HistorySegment::~HistorySegment() {
+    if (base_) {
+        munmap(base_, capacity_);
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+uint8_t* HistorySegment::mapFile(int fd, size_t capacity) {
+    void* addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return addr == MAP_FAILED ? nullptr : static_cast<uint8_t*>(addr);
+}
+
+std::shared_ptr<HistorySegment> HistorySegment::create(const std::string& path, uint64_t sequence, size_t capacity) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("[RoomHistory] Failed to create segment ", path, ": ", strerror(errno));
+        throw std::runtime_error("Failed to create history segment");
+    }
+
+    // 블록을 미리 할당해 두어야 매핑에 쓰다가 디스크가 차서 SIGBUS를 받지 않음 (지원하지 않는 파일 시스템은 크기만 맞춤)
+    int err = posix_fallocate(fd, 0, static_cast<off_t>(capacity));
+    if (err == EOPNOTSUPP || err == EINVAL) {
+        err = ftruncate(fd, static_cast<off_t>(capacity)) == 0 ? 0 : errno;
+    }
+    uint8_t* base = err == 0 ? mapFile(fd, capacity) : nullptr;
+    if (!base) {
+        LOG_ERROR("[RoomHistory] Failed to allocate segment ", path, ": ", strerror(err != 0 ? err : errno));
+        close(fd);
+        ::unlink(path.c_str());
+        throw std::runtime_error("Failed to allocate history segment");
+    }
+
+    std::shared_ptr<HistorySegment> segment(new HistorySegment(path, sequence, fd, base, capacity));
+    const uint32_t header[2] = {MAGIC, VERSION};
+    const uint64_t created_ms = nowMs();
+    memcpy(base, header, sizeof(header));
+    memcpy(base + sizeof(header), &created_ms, sizeof(created_ms));
+    segment->last_write_ms_ = created_ms;
+    segment->written_.store(HEADER_SIZE, std::memory_order_release);
+    return segment;
+}
+
+std::shared_ptr<HistorySegment> HistorySegment::open(const std::string& path, uint64_t sequence) {
+    int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open history segment " + path + ": " + strerror(errno));
+    }
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE + RECORD_HEADER_SIZE) {
+        close(fd);
+        throw std::runtime_error("History segment too small: " + path);
+    }
+    const size_t capacity = static_cast<size_t>(st.st_size);
+    uint8_t* base = mapFile(fd, capacity);
+    if (!base) {
+        close(fd);
+        throw std::runtime_error("Failed to map history segment " + path + ": " + strerror(errno));
+    }
+    std::shared_ptr<HistorySegment> segment(new HistorySegment(path, sequence, fd, base, capacity));
+
+    uint32_t header[2];
+    memcpy(header, base, sizeof(header));
+    if (header[0] != MAGIC || header[1] != VERSION) {
+        throw std::runtime_error("Not a history segment: " + path);
+    }
+    memcpy(&segment->last_write_ms_, base + sizeof(header), sizeof(uint64_t));
+
+    // 길이가 0인 헤더까지 훑음. 검증이나 체크섬에 실패한 레코드는 크래시 때 일부만 디스크에 남은 꼬리이므로 이후를 지움
+    // (끝 뒤에 먼저 반영된 레코드가 남아 있으면 새 기록 사이로 되살아나지 않도록 함께 지움)
+    size_t position = HEADER_SIZE;
+    while (position + RECORD_HEADER_SIZE <= capacity) {
+        RecordHeader record;
+        memcpy(&record, base + position, sizeof(record));
+        const bool end = record.length == 0;
+        const bool valid = !end && isHistoryType(record.type) && record.length <= MAX_V2_MESSAGE_SIZE &&
+                           position + RECORD_HEADER_SIZE + record.length <= capacity &&
+                           recordChecksum(record, base + position + RECORD_HEADER_SIZE) == record.checksum;
+        if (!valid) {
+            const uint8_t* rest = base + position;
+            const size_t rest_length = capacity - position;
+            if (!end || std::any_of(rest, rest + rest_length, [](uint8_t byte) { return byte != 0; })) {
+                LOG_WARN("[RoomHistory] Truncating torn record at offset ", position, " in ", path);
+                memset(base + position, 0, rest_length);
+            }
+            break;
+        }
+        segment->last_write_ms_ = record.time_ms;
+        position = alignRecord(position + RECORD_HEADER_SIZE + record.length);
+    }
+    segment->tail_ = std::min(position, capacity);
+    segment->written_.store(segment->tail_, std::memory_order_release);
+    segment->synced_.store(segment->tail_, std::memory_order_release);
+    return segment;
+}
+
+bool HistorySegment::fits(size_t length) const {
+    return tail_ + RECORD_HEADER_SIZE + length <= capacity_;
+}
+
+size_t HistorySegment::append(MessageType type, uint8_t flags, const uint8_t* payload, size_t length, uint64_t now_ms) {
+    RecordHeader record{};
+    record.length = static_cast<uint32_t>(length);
+    record.time_ms = now_ms;
+    record.type = static_cast<uint8_t>(type);
+    record.flags = flags;
+    record.checksum = recordChecksum(record, payload);
+    const size_t payload_offset = tail_ + RECORD_HEADER_SIZE;
+    // 페이로드를 먼저 쓰고 길이를 담은 헤더를 나중에 씀 (정렬 패딩은 미리 할당한 0 영역)
+    // 디스크에는 순서 없이 반영될 수 있으므로 크래시 복구는 체크섬으로 판단
+    memcpy(base_ + payload_offset, payload, length);
+    memcpy(base_ + tail_, &record, sizeof(record));
+    tail_ = std::min(alignRecord(payload_offset + length), capacity_);
+    last_write_ms_ = now_ms;
+    written_.store(tail_, std::memory_order_release);
+    return payload_offset;
+}
+
+bool HistorySegment::readRecord(size_t& position, MessageType& type, uint8_t& flags, size_t& payload_offset,
+                                size_t& length) const {
+    if (position + RECORD_HEADER_SIZE > tail_) {
+        return false;
+    }
+    RecordHeader record;
+    memcpy(&record, base_ + position, sizeof(record));
+    if (record.length == 0) {
+        return false;
+    }
+    type = static_cast<MessageType>(record.type);
+    flags = record.flags;
+    payload_offset = position + RECORD_HEADER_SIZE;
+    length = record.length;
+    position = alignRecord(payload_offset + length);
+    return true;
+}
+
+void HistorySegment::unlink() {
+    if (::unlink(path_.c_str()) != 0) {
+        LOG_WARN("[RoomHistory] Failed to remove segment ", path_, ": ", strerror(errno));
+    }
+}
+
+bool HistorySegment::beginSync(size_t& target) {
+    if (synced_.load(std::memory_order_acquire) >= written_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    if (syncing_.exchange(true, std::memory_order_acq_rel)) {
+        return false;
+    }
+    target = written_.load(std::memory_order_acquire);
+    return true;
+}
+
+bool HistorySegment::endSync(size_t target, bool ok) {
+    if (ok) {
+        synced_.store(target, std::memory_order_release);
+    }
+    syncing_.store(false, std::memory_order_release);
+    // 실패했으면 다음 기록이 다시 동기화를 요청할 때까지 재시도하지 않음
+    return ok && written_.load(std::memory_order_acquire) > target;
+}
+
+void RoomHistory::open(const std::string& dir, size_t segment_bytes, size_t replay_count, uint64_t retain_bytes,
+                       unsigned retain_secs) {
+    if (enabled_) {
+        return;
+    }
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        LOG_ERROR("[RoomHistory] Failed to create directory ", dir, ": ", strerror(errno));
+        throw std::runtime_error("Failed to create history directory");
+    }
+    dir_ = dir;
+    segment_bytes_ = segment_bytes;
+    replay_count_ = replay_count;
+    retain_bytes_ = retain_bytes;
+    retain_ms_ = static_cast<uint64_t>(retain_secs) * 1000;
+
+    // 기존 세그먼트 찾기 (방별로 순번 순서대로 복구)
+    DIR* directory = opendir(dir.c_str());
+    if (!directory) {
+        LOG_ERROR("[RoomHistory] Failed to open directory ", dir, ": ", strerror(errno));
+        throw std::runtime_error("Failed to open history directory");
+    }
+    std::unordered_map<int32_t, std::vector<uint64_t>> found;
+    while (dirent* entry = readdir(directory)) {
+        int room_id = -1;
+        unsigned long long sequence = 0;
+        int consumed = 0;
+        if (sscanf(entry->d_name, "room-%d-%llu.log%n", &room_id, &sequence, &consumed) == 2 && consumed > 0 &&
+            entry->d_name[consumed] == '\0' && room_id >= 0) {
+            found[room_id].push_back(sequence);
+        }
+    }
+    closedir(directory);
+
+    const uint64_t now_ms = nowMs();
+    size_t segments = 0;
+    size_t records = 0;
+    for (auto& [room_id, sequences] : found) {
+        std::sort(sequences.begin(), sequences.end());
+        auto log = logOf(room_id, true);
+        std::lock_guard<std::mutex> lock(log->mutex);
+        for (const uint64_t sequence : sequences) {
+            std::shared_ptr<HistorySegment> segment;
+            try {
+                segment = HistorySegment::open(segmentPath(room_id, sequence), sequence);
+            } catch (const std::exception& e) {
+                LOG_WARN("[RoomHistory] Skipping segment: ", e.what());
+                continue;
+            }
+            size_t position = HistorySegment::HEADER_SIZE;
+            MessageType type;
+            uint8_t flags;
+            size_t offset;
+            size_t length;
+            while (segment->readRecord(position, type, flags, offset, length)) {
+                remember(*log, segment, offset, length, type, flags);
+                ++records;
+            }
+            log->bytes += segment->capacity();
+            log->segments.push_back(std::move(segment));
+            ++segments;
+        }
+        log->next_sequence = sequences.back() + 1;
+        expire(room_id, *log, now_ms);
+    }
+
+    enabled_ = true;
+    LOG_INFO("[RoomHistory] Opened ", dir, ": recovered ", segments, " segments with ", records, " messages in ",
+             found.size(), " rooms");
+}
+
+std::shared_ptr<HistorySegment> RoomHistory::append(int32_t room_id, MessageType type, uint8_t flags,
+                                                    const uint8_t* payload, size_t length) {
+    if (!enabled_ || length == 0 || length > MAX_V2_MESSAGE_SIZE) {
+        return nullptr;
+    }
+    auto log = logOf(room_id, true);
+    std::lock_guard<std::mutex> lock(log->mutex);
+    const uint64_t now_ms = nowMs();
+
+    // 기록 중인 세그먼트가 다 차면 새 세그먼트로 넘어가고 보관 상한을 넘은 오래된 세그먼트를 지움
+    if (log->segments.empty() || !log->segments.back()->fits(length)) {
+        std::shared_ptr<HistorySegment> segment;
+        try {
+            segment = HistorySegment::create(segmentPath(room_id, log->next_sequence), log->next_sequence, segment_bytes_);
+        } catch (const std::exception&) {
+            return nullptr;
+        }
+        ++log->next_sequence;
+        log->bytes += segment->capacity();
+        log->segments.push_back(std::move(segment));
+        expire(room_id, *log, now_ms);
+    }
+
+    std::shared_ptr<HistorySegment> segment = log->segments.back();
+    const size_t offset = segment->append(type, flags, payload, length, now_ms);
+    remember(*log, segment, offset, length, type, flags);
+    return segment;
+}
+
+void RoomHistory::recent(int32_t room_id, size_t count, std::vector<HistoryRecord>& out) {
+    out.clear();
+    if (!enabled_ || count == 0) {
+        return;
+    }
+    auto log = logOf(room_id, false);
+    if (!log) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(log->mutex);
+    expire(room_id, *log, nowMs());
+    const size_t n = std::min(count, log->recent.size());
+    out.assign(log->recent.end() - static_cast<std::ptrdiff_t>(n), log->recent.end());
+}
+
+std::shared_ptr<RoomHistory::RoomLog> RoomHistory::logOf(int32_t room_id, bool create) {
+    Shard& shard = shardOf(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.rooms.find(room_id);
+    if (it != shard.rooms.end()) {
+        return it->second;
+    }
+    if (!create) {
+        return nullptr;
+    }
+    auto log = std::make_shared<RoomLog>();
+    shard.rooms.emplace(room_id, log);
+    return log;
+}
+
+std::string RoomHistory::segmentPath(int32_t room_id, uint64_t sequence) const {
+    char name[64];
+    snprintf(name, sizeof(name), "room-%d-%010llu.log", room_id, static_cast<unsigned long long>(sequence));
+    return dir_ + "/" + name;
+}
+
+void RoomHistory::remember(RoomLog& log, const std::shared_ptr<HistorySegment>& segment, size_t offset, size_t length,
+                           MessageType type, uint8_t flags) {
+    if (replay_count_ == 0) {
+        return;
+    }
+    log.recent.push_back(HistoryRecord{segment, static_cast<uint32_t>(offset), static_cast<uint32_t>(length), type, flags});
+    while (log.recent.size() > replay_count_) {
+        log.recent.pop_front();
+    }
+}
+
+void RoomHistory::expire(int32_t room_id, RoomLog& log, uint64_t now_ms) {
+    while (!log.segments.empty()) {
+        const HistorySegment& oldest = *log.segments.front();
+        // 바이트 상한은 기록 중인 세그먼트를 남기고, 시간 상한은 조용한 방이면 기록 중인 세그먼트도 지움
+        const bool over_bytes = retain_bytes_ > 0 && log.bytes > retain_bytes_ && log.segments.size() > 1;
+        const bool too_old = retain_ms_ > 0 && now_ms > oldest.lastWriteMs() + retain_ms_;
+        if (!over_bytes && !too_old) {
+            break;
+        }
+        std::shared_ptr<HistorySegment> dropped = std::move(log.segments.front());
+        log.segments.pop_front();
+        log.bytes -= dropped->capacity();
+        while (!log.recent.empty() && log.recent.front().segment == dropped) {
+            log.recent.pop_front();
+        }
+        dropped->unlink();
+        LOG_INFO("[RoomHistory] Room ", room_id, " dropped segment ", dropped->sequence(),
+                 over_bytes ? " (size limit)" : " (age limit)");
+    }
+}
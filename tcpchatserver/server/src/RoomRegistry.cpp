@@ -0,0 +1,74 @@
+#include "RoomRegistry.h"
+#include <algorithm>
+
+void RoomRegistry::join(int32_t room_id, int32_t session_id) {
+    Shard& shard = shardOf(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto& sessions = shard.rooms[room_id];
+    if (std::find(sessions.begin(), sessions.end(), session_id) == sessions.end()) {
+        sessions.push_back(session_id);
+    }
+}
+
+void RoomRegistry::leave(int32_t room_id, int32_t session_id) {
+    Shard& shard = shardOf(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto room_it = shard.rooms.find(room_id);
+    if (room_it == shard.rooms.end()) {
+        return;
+    }
+    auto& sessions = room_it->second;
+    sessions.erase(std::remove(sessions.begin(), sessions.end(), session_id), sessions.end());
+    if (sessions.empty()) {
+        shard.rooms.erase(room_it);
+    }
+}
+
+void RoomRegistry::sessionsOf(int32_t room_id, std::vector<int32_t>& out) {
+    out.clear();
+    Shard& shard = shardOf(room_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto room_it = shard.rooms.find(room_id);
+    if (room_it != shard.rooms.end()) {
+        out = room_it->second;
+    }
+}
+
+size_t RoomRegistry::roomCount() {
+    size_t count = 0;
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        count += shard.rooms.size();
+    }
+    return count;
+}
+
+RoomInbox::~RoomInbox() {
+    RoomMessage* message = head_.exchange(nullptr, std::memory_order_acquire);
+    while (message) {
+        RoomMessage* next = message->next;
+        delete message;
+        message = next;
+    }
+}
+
+bool RoomInbox::push(RoomMessage* message) {
+    RoomMessage* head = head_.load(std::memory_order_relaxed);
+    do {
+        message->next = head;
+    } while (!head_.compare_exchange_weak(head, message, std::memory_order_release, std::memory_order_relaxed));
+    return head == nullptr;
+}
+
+RoomMessage* RoomInbox::drain() {
+    // 스택은 최근 것이 앞이므로 뒤집어서 넣은 순서로 돌려줌
+    RoomMessage* message = head_.exchange(nullptr, std::memory_order_acquire);
+    RoomMessage* ordered = nullptr;
+    while (message) {
+        RoomMessage* next = message->next;
+        message->next = ordered;
+        ordered = message;
+        message = next;
+    }
+    return ordered;
+}
@@ -0,0 +1,79 @@
+#include "SendBufferPool.h"
+#include "Logger.h"
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <stdexcept>
+#include <cstring>
+
+SendBufferPool::SendBufferPool(io_uring* ring, unsigned num_slots)
+    : ring_(ring), num_slots_(num_slots),
+      region_size_(static_cast<size_t>(num_slots) * SLOT_SIZE),
+      base_addr_(nullptr), in_use_(num_slots, 0)
+{
+    if (!ring_) {
+        LOG_ERROR("Cannot initialize SendBufferPool with null io_uring pointer");
+        throw std::invalid_argument("Null io_uring pointer");
+    }
+    if (num_slots_ == 0 || num_slots_ > MAX_SLOTS) {
+        LOG_ERROR("Invalid send buffer pool size: ", num_slots_);
+        throw std::invalid_argument("Invalid send buffer pool size");
+    }
+
+    void* addr = mmap(nullptr, region_size_, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("Failed to mmap send buffer pool: ", strerror(errno));
+        throw std::runtime_error("Failed to allocate memory for send buffer pool");
+    }
+    base_addr_ = static_cast<uint8_t*>(addr);
+
+    // 슬롯마다 iovec 하나씩 등록하여 슬롯 번호 = 등록 버퍼 인덱스가 되도록 함
+    std::vector<iovec> iovecs(num_slots_);
+    for (unsigned i = 0; i < num_slots_; ++i) {
+        iovecs[i].iov_base = getSlotAddr(static_cast<uint16_t>(i));
+        iovecs[i].iov_len = SLOT_SIZE;
+    }
+
+    int ret = io_uring_register_buffers(ring_, iovecs.data(), num_slots_);
+    if (ret < 0) {
+        // 구형 커널은 RLIMIT_MEMLOCK 한도 안에서만 페이지 고정을 허용함
+        LOG_ERROR("Failed to register send buffer pool (", num_slots_, " slots): ", strerror(-ret));
+        munmap(base_addr_, region_size_);
+        base_addr_ = nullptr;
+        throw std::runtime_error("Failed to register send buffer pool");
+    }
+
+    free_slots_.reserve(num_slots_);
+    for (unsigned i = num_slots_; i > 0; --i) {
+        free_slots_.push_back(static_cast<uint16_t>(i - 1));
+    }
+
+    LOG_INFO("SendBufferPool registered with ", num_slots_, " slots of ", SLOT_SIZE, " bytes");
+}
+
+SendBufferPool::~SendBufferPool() {
+    if (ring_) {
+        io_uring_unregister_buffers(ring_);
+    }
+    if (base_addr_ && munmap(base_addr_, region_size_) != 0) {
+        LOG_ERROR("Error unmapping send buffer pool memory: ", strerror(errno));
+    }
+}
+
+int SendBufferPool::acquire() {
+    if (free_slots_.empty()) {
+        return -1;
+    }
+    const uint16_t slot = free_slots_.back();
+    free_slots_.pop_back();
+    in_use_[slot] = 1;
+    return slot;
+}
+
+void SendBufferPool::release(uint16_t slot) {
+    if (slot >= num_slots_ || !in_use_[slot]) {
+        LOG_ERROR("[SendBufferPool] Invalid slot release: ", slot);
+        return;
+    }
+    in_use_[slot] = 0;
+    free_slots_.push_back(slot);
+}
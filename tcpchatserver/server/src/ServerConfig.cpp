@@ -0,0 +1,228 @@
+#include "ServerConfig.h"
+#include "Logger.h"
+#include "SendBufferPool.h"
+#include <iostream>
+#include <stdexcept>
+
+namespace {
+
+// "--key=value" 를 key / value 로 분리 (값이 없으면 value는 빈 문자열)
+void splitOption(const std::string& arg, std::string& key, std::string& value) {
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos) {
+        key = arg.substr(2);
+        value.clear();
+    } else {
+        key = arg.substr(2, eq - 2);
+        value = arg.substr(eq + 1);
+    }
+}
+
+// 값이 생략된 플래그는 true, 그 외에는 1/0, true/false, on/off 허용
+bool parseBool(const std::string& value) {
+    if (value.empty() || value == "1" || value == "true" || value == "on") {
+        return true;
+    }
+    if (value == "0" || value == "false" || value == "off") {
+        return false;
+    }
+    throw std::invalid_argument("invalid boolean value: " + value);
+}
+
+// provided buffer ring의 버퍼 크기/개수는 2의 거듭제곱이어야 함
+unsigned parsePowerOfTwo(const std::string& value, unsigned max_value) {
+    const unsigned long n = std::stoul(value);
+    if (n == 0 || (n & (n - 1)) != 0 || n > max_value) {
+        throw std::invalid_argument("must be a power of two no greater than " + std::to_string(max_value));
+    }
+    return static_cast<unsigned>(n);
+}
+
+constexpr unsigned MAX_INC_BUFFER_SIZE = 1U << 24;  // 16 MB
+constexpr unsigned MAX_INC_BUFFERS = 32768;         // 커널 버퍼 링 최대 엔트리 (모든 버퍼 그룹 공통)
+
+} // namespace
+
+bool ServerConfig::parseOption(const std::string& arg) {
+    if (arg.size() < 3 || arg.compare(0, 2, "--") != 0) {
+        return false;
+    }
+
+    std::string key;
+    std::string value;
+    splitOption(arg, key, value);
+
+    try {
+        if (key == "sqpoll") {
+            sqpoll = parseBool(value);
+        } else if (key == "sqpoll-idle") {
+            sqpoll_idle_ms = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "sqpoll-cpu") {
+            sqpoll_cpu = std::stoi(value);
+        } else if (key == "sqpoll-shared") {
+            sqpoll_shared = parseBool(value);
+        } else if (key == "shared-wq") {
+            shared_wq = parseBool(value);
+        } else if (key == "iowq-max-bounded") {
+            iowq_max_bounded = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "iowq-max-unbounded") {
+            iowq_max_unbounded = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "session-cpu") {
+            session_cpu = std::stoi(value);
+        } else if (key == "expected-connections") {
+            expected_connections = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "ring-autoresize") {
+            ring_autoresize = parseBool(value);
+        } else if (key == "busy-poll-us") {
+            busy_poll_us = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "wait-timeout-ms") {
+            wait_timeout_ms = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "send-zc-threshold") {
+            send_zc_threshold = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "send-pool") {
+            send_pool_slots = static_cast<unsigned>(std::stoul(value));
+            if (send_pool_slots > SendBufferPool::MAX_SLOTS) {
+                throw std::invalid_argument("slot count must not exceed " + std::to_string(SendBufferPool::MAX_SLOTS));
+            }
+        } else if (key == "send-skip-success") {
+            send_skip_success = parseBool(value);
+        } else if (key == "recv-bundle") {
+            recv_bundle = parseBool(value);
+        } else if (key == "recv-buffers") {
+            recv_buffers = static_cast<unsigned>(std::stoul(value));
+            if (recv_buffers == 0 || recv_buffers > MAX_INC_BUFFERS) {
+                throw std::invalid_argument("buffer count must be between 1 and " + std::to_string(MAX_INC_BUFFERS));
+            }
+        } else if (key == "recv-buffer-cap") {
+            recv_buffer_cap = parsePowerOfTwo(value, MAX_INC_BUFFERS);
+        } else if (key == "buffer-debug") {
+            buffer_debug = parseBool(value);
+        } else if (key == "recv-size-classes") {
+            recv_size_classes = parseBool(value);
+        } else if (key == "recv-incremental") {
+            recv_incremental = parseBool(value);
+        } else if (key == "inc-buffer-size") {
+            inc_buffer_size = parsePowerOfTwo(value, MAX_INC_BUFFER_SIZE);
+        } else if (key == "inc-buffers") {
+            inc_buffers = parsePowerOfTwo(value, MAX_INC_BUFFERS);
+        } else if (key == "ring-profile") {
+            if (value == "default") {
+                ring_profile = RingProfile::DEFAULT;
+            } else if (value == "single-issuer") {
+                ring_profile = RingProfile::SINGLE_ISSUER;
+            } else {
+                throw std::invalid_argument("unknown ring profile: " + value);
+            }
+        } else if (key == "reuseport-accept") {
+            reuseport_accept = parseBool(value);
+        } else if (key == "reuseport-cpu-steer") {
+            reuseport_cpu_steer = parseBool(value);
+        } else if (key == "room-affinity") {
+            room_affinity = parseBool(value);
+        } else if (key == "fanout-slice") {
+            fanout_slice = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "fanout-budget-ms") {
+            fanout_budget_ms = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "announce-token") {
+            if (value.find(' ') != std::string::npos) {
+                throw std::invalid_argument("announce token must not contain spaces");
+            }
+            announce_token = value;
+        } else if (key == "announce-interval-ms") {
+            announce_interval_ms = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "send-queue-bytes") {
+            send_queue_bytes = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "send-queue-frames") {
+            send_queue_frames = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "slow-consumer") {
+            if (value == "drop-oldest") {
+                slow_consumer = SlowConsumerPolicy::DROP_OLDEST;
+            } else if (value == "drop-newest") {
+                slow_consumer = SlowConsumerPolicy::DROP_NEWEST;
+            } else if (value == "coalesce") {
+                slow_consumer = SlowConsumerPolicy::COALESCE;
+            } else if (value == "disconnect") {
+                slow_consumer = SlowConsumerPolicy::DISCONNECT;
+            } else {
+                throw std::invalid_argument("unknown slow consumer policy: " + value);
+            }
+        } else if (key == "history-dir") {
+            history_dir = value;
+        } else if (key == "history-replay") {
+            history_replay = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "history-segment-bytes") {
+            const unsigned long n = std::stoul(value);
+            // 세그먼트 하나에 최대 크기(v2 64 KB) 메시지가 여러 개 들어가야 함
+            if (n < 1024 * 1024 || n > 1024UL * 1024 * 1024) {
+                throw std::invalid_argument("history segment must be between 1 MB and 1 GB");
+            }
+            history_segment_bytes = static_cast<unsigned>(n);
+        } else if (key == "history-retain-bytes") {
+            history_retain_bytes = std::stoull(value);
+        } else if (key == "history-retain-secs") {
+            history_retain_secs = static_cast<unsigned>(std::stoul(value));
+        } else if (key == "direct-fds") {
+            direct_fds = parseBool(value);
+        } else if (key == "direct-fd-slots") {
+            direct_fd_slots = static_cast<unsigned>(std::stoul(value));
+            if (direct_fd_slots == 0) {
+                throw std::invalid_argument("slot count must be greater than 0");
+            }
+        } else {
+            LOG_ERROR("[ServerConfig] Unknown option: ", arg);
+            return false;
+        }
+    } catch (const std::exception& e) {
+        LOG_ERROR("[ServerConfig] Invalid value for option ", arg, ": ", e.what());
+        return false;
+    }
+
+    LOG_INFO("[ServerConfig] Applied option ", arg);
+    return true;
+}
+
+void ServerConfig::printOptions() {
+    std::cout << "Options:\n"
+              << "  --sqpoll[=on|off]        커널 폴러 스레드로 SQ 제출 (IORING_SETUP_SQPOLL)\n"
+              << "  --sqpoll-idle=<ms>       폴러 유휴 대기 시간 (기본값: 1000)\n"
+              << "  --sqpoll-cpu=<cpu>       세션 i의 폴러를 CPU (cpu + i)에 고정\n"
+              << "  --sqpoll-shared[=on|off] 모든 세션 링이 하나의 폴러를 공유\n"
+              << "  --shared-wq[=on|off]     모든 세션 링을 하나의 부모 링에 연결 (IORING_SETUP_ATTACH_WQ)\n"
+              << "  --iowq-max-bounded=<n>   세션 스레드별 bounded io-wq 워커 상한 (0: 커널 기본값)\n"
+              << "  --iowq-max-unbounded=<n> 세션 스레드별 unbounded io-wq 워커 상한 (0: 커널 기본값)\n"
+              << "  --session-cpu=<cpu>      세션 i의 워커 스레드와 io-wq를 CPU (cpu + i)에 고정\n"
+              << "  --expected-connections=<n> 세션별 예상 연결 수로 SQ/CQ 크기 산정 (IORING_SETUP_CQSIZE)\n"
+              << "  --ring-autoresize[=on|off] 연결 수에 맞춰 CQ를 런타임에 확장 (기본값: on, single-issuer 링)\n"
+              << "  --busy-poll-us=<us>      대기 전 최대 스핀 시간, 최근 유휴 간격에 맞춰 자동 조정 (0: 끔)\n"
+              << "  --wait-timeout-ms=<ms>   블로킹 대기 시간 제한 (0: 무제한)\n"
+              << "  --send-zc-threshold=<n>  n바이트 이상의 응답을 제로 카피(SEND_ZC)로 전송 (0: 끔)\n"
+              << "  --send-pool=<n>          세션별 송신 전용 등록 버퍼 슬롯 수 (풀은 항상 사용, 기본값: 1024)\n"
+              << "  --send-skip-success[=on|off] 풀 전송의 성공 CQE 생략 (IOSQE_CQE_SKIP_SUCCESS, 실험적)\n"
+              << "  --recv-bundle[=on|off]   멀티샷 recv 번들 (CQE 하나에 여러 버퍼)\n"
+              << "  --recv-buffers=<n>       기본 recv 버퍼 그룹에 처음 올릴 버퍼 수 (기본값: 상한 전부)\n"
+              << "  --recv-buffer-cap=<n>    기본 recv 버퍼 상한, 남은 버퍼가 1/8 미만이면 1024개씩 확장 (기본값: 4096)\n"
+              << "  --buffer-debug[=on|off]  배치마다 recv 버퍼 누수를 검사하고 회수 (디버그용)\n"
+              << "  --recv-size-classes[=on|off] 128 B/1 KB/16 KB recv 버퍼 그룹을 연결별 수신 크기에 맞춰 선택\n"
+              << "  --recv-incremental[=on|off] 큰 recv 버퍼를 여러 recv가 이어서 채움 (IOU_PBUF_RING_INC)\n"
+              << "  --inc-buffer-size=<n>    증분 recv 버퍼 크기 (2의 거듭제곱, 기본값: 65536)\n"
+              << "  --inc-buffers=<n>        증분 recv 버퍼 개수 (2의 거듭제곱, 기본값: 64)\n"
+              << "  --ring-profile=<name>    default | single-issuer (SINGLE_ISSUER + DEFER_TASKRUN)\n"
+              << "  --reuseport-accept[=on|off] 세션마다 SO_REUSEPORT 소켓을 열고 세션 링에서 직접 accept\n"
+              << "  --reuseport-cpu-steer[=on|off] 연결을 처리한 CPU에 고정된 세션으로 보냄 (classic BPF, --reuseport-accept 필요)\n"
+              << "  --direct-fds[=on|off]    accept/recv/write/close를 고정 파일 슬롯으로 수행\n"
+              << "  --direct-fd-slots=<n>    세션별 고정 파일 테이블 크기 (기본값: 16384)\n"
+              << "  --room-affinity[=on|off] CLIENT_JOIN한 연결을 방의 홈 세션(방 번호 % 세션 수)으로 옮김\n"
+              << "  --fanout-slice=<n>       배치마다 보낼 최대 팬아웃 수신자 수 (기본값: 1024, 0: 나누지 않음)\n"
+              << "  --fanout-budget-ms=<ms>  팬아웃 완료 목표 시간, 넘은 브로드캐스트를 경고 (기본값: 0, 끔)\n"
+              << "  --announce-token=<token> 서버 전체 공지 명령에 필요한 운영자 토큰 (기본값: 없음, 공지 거부)\n"
+              << "  --announce-interval-ms=<ms> 연결별 공지 최소 간격 (기본값: 1000, 0: 제한 없음)\n"
+              << "  --send-queue-bytes=<n>   연결별 송신 큐 바이트 상한, 닿으면 recv 중지 (기본값: 262144, 0: 무제한)\n"
+              << "  --send-queue-frames=<n>  연결별 송신 큐 프레임 상한 (기본값: 1024, 0: 무제한)\n"
+              << "  --slow-consumer=<policy> drop-oldest | drop-newest | coalesce | disconnect (기본값: drop-oldest)\n"
+              << "  --history-dir=<path>     방 히스토리 세그먼트 디렉터리 (기본값: 없음, 끔)\n"
+              << "  --history-replay=<n>     CLIENT_JOIN 시 재생할 최근 메시지 수 (기본값: 50, 0: 기록만)\n"
+              << "  --history-segment-bytes=<n> 히스토리 세그먼트 파일 크기 (기본값: 4194304)\n"
+              << "  --history-retain-bytes=<n> 방별 히스토리 보관 상한 (기본값: 67108864, 0: 무제한)\n"
+              << "  --history-retain-secs=<n>  마지막 기록 후 세그먼트 보관 시간 (기본값: 0, 무제한)\n"
+              << std::flush;
+}
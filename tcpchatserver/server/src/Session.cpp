@@ -5,14 +5,74 @@
 #include "Logger.h"
 #include "SessionManager.h"
 #include "SocketManager.h"
+#include "ServerConfig.h"
 #include <sstream>
 #include <string.h>
 #include <functional>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <chrono>
+#include <algorithm>
 
-Session::Session(int32_t id) : session_id_(id) {
+namespace {
+
+using SpinClock = std::chrono::steady_clock;
+
+inline uint64_t elapsedNs(SpinClock::time_point since) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(SpinClock::now() - since).count());
+}
+
+// 스핀 루프에서 하이퍼스레드 형제에게 실행 자원을 양보
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// 클라이언트 프레임 헤더 해석 (v1/v2): 완성되면 1, 바이트가 더 필요하면 0, 클라이언트 메시지가 아니면 -1
+inline int parseClientHeader(const uint8_t* data, size_t available, FrameHeader& header) {
+    const int parsed = parseFrameHeader(data, available, header);
+    if (parsed <= 0) {
+        return parsed;
+    }
+    const uint8_t msg_type = static_cast<uint8_t>(header.type);
+    if (msg_type < static_cast<uint8_t>(MessageType::CLIENT_JOIN) ||
+        msg_type > static_cast<uint8_t>(MessageType::CLIENT_COMMAND) || header.length == 0) {
+        return -1;
+    }
+    return 1;
+}
+
+// 진행 중인 전송 식별자: 슬롯/버퍼/벡터 레코드 번호는 전송이 끝날 때까지 재사용되지 않으므로 연산과 묶으면 유일함
+inline uint32_t sendTag(OperationType op_type, uint16_t id) {
+    return (static_cast<uint32_t>(op_type) << 16) | id;
+}
+
+} // namespace
+
+Session::Session(int32_t id, const RingOptions& ring_options) : session_id_(id) {
+    const auto& config = ServerConfig::getInstance();
+    busy_poll_max_ns_ = static_cast<uint64_t>(config.busy_poll_us) * 1000;
+    wait_timeout_ms_ = config.wait_timeout_ms;
+    room_affinity_ = config.room_affinity;
+    fanout_slice_ = config.fanout_slice;
+    fanout_budget_us_ = static_cast<uint64_t>(config.fanout_budget_ms) * 1000;
+    announce_token_ = config.announce_token;
+    announce_interval_ = std::chrono::milliseconds(config.announce_interval_ms);
+    send_queue_max_bytes_ = config.send_queue_bytes;
+    send_queue_max_frames_ = config.send_queue_frames;
+    slow_consumer_ = config.slow_consumer;
+    
     // 세션별 전용 IOUring 생성 (내부적으로 초기화 수행)
     try {
-        io_ring_ = std::make_unique<IOUring>();
+        io_ring_ = std::make_unique<IOUring>(ring_options);
+        wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (wakeup_fd_ < 0) {
+            throw std::runtime_error(std::string("eventfd failed: ") + strerror(errno));
+        }
         LOG_INFO("[Session ", id, "] Created with dedicated IOUring");
     } catch (const std::exception& e) {
         LOG_ERROR("[Session ", id, "] Failed to create IOUring: ", e.what());
@@ -40,10 +100,20 @@ Session::~Session() {
         
         // Clear client collections
         client_sockets_.clear();
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex_);
+            pending_clients_.clear();
+            pending_direct_clients_.clear();
+        }
         
         // Release IOUring (will call IOUring's destructor which handles its own cleanup)
         io_ring_.reset();
         
+        if (wakeup_fd_ >= 0) {
+            close(wakeup_fd_);
+            wakeup_fd_ = -1;
+        }
+        
         LOG_INFO("[Session ", session_id_, "] Destroyed successfully");
     } catch (const std::exception& e) {
         LOG_ERROR("[Session ", session_id_, "] Error during destruction: ", e.what());
@@ -59,7 +129,97 @@ std::set<int32_t> Session::getClientFds() const {
     return result;
 }
 
-void Session::addClient(SocketPtr client_socket) {
+void Session::onWorkerStart() {
+    if (!io_ring_) {
+        LOG_ERROR("[Session ", session_id_, "] IOUring is null in onWorkerStart");
+        return;
+    }
+    
+    // SINGLE_ISSUER 링은 여기서 활성화되어 이 스레드만 제출할 수 있게 됨
+    io_ring_->activate();
+    io_ring_->prepareWakeup(wakeup_fd_);
+    if (listening_socket_) {
+        io_ring_->prepareAccept(listening_socket_->getSocketFd());
+    }
+    io_ring_->submit();
+    LOG_INFO("[Session ", session_id_, "] Worker attached to IOUring");
+}
+
+void Session::addClient(MigratedClient client) {
+    if (!client.socket || !client.socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to add invalid client socket");
+        return;
+    }
+    
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_clients_.push_back(std::move(client));
+}
+
+uint32_t Session::addDirectClient(MigratedClient client) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    const uint32_t ticket = next_direct_ticket_++;
+    pending_direct_clients_[ticket] = std::move(client);
+    return ticket;
+}
+
+bool Session::takeDirectClient(uint32_t ticket, MigratedClient& client) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    auto pending_it = pending_direct_clients_.find(ticket);
+    if (pending_it == pending_direct_clients_.end()) {
+        return false;
+    }
+    client = std::move(pending_it->second);
+    pending_direct_clients_.erase(pending_it);
+    return true;
+}
+
+void Session::wakeup() {
+    const uint64_t one = 1;
+    if (write(wakeup_fd_, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("[Session ", session_id_, "] Failed to signal wakeup eventfd: ", strerror(errno));
+    }
+}
+
+bool Session::hasPendingClients() const {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    return !pending_clients_.empty();
+}
+
+void Session::drainPendingClients() {
+    std::vector<MigratedClient> pending;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_clients_.empty()) {
+            return;
+        }
+        pending.swap(pending_clients_);
+    }
+    
+    for (auto& client : pending) {
+        adoptClient(client);
+        ++stats_.migrations_in;
+    }
+}
+
+void Session::adoptClient(MigratedClient& client) {
+    const int32_t client_fd = client.socket->getSocketFd();
+    registerClient(client.socket, client.recv_class);
+    if (client.protocol_v2) {
+        v2_clients_.insert(client_fd);
+    }
+    if (client.room >= 0 && client_sockets_.find(client_fd) != client_sockets_.end()) {
+        joinRoom(client_fd, client.room);
+        replayHistory(client_fd, client.room);
+    }
+    
+    // 소스 세션이 이동 중에 받은 바이트를 이어서 처리 (recv는 이미 이 링에 등록되어 이후 데이터는 뒤에 옴)
+    if (!client.carry.empty() && client_sockets_.find(client_fd) != client_sockets_.end()) {
+        consumeStream(client.socket, client.carry.data(), client.carry.size());
+        flushOutbound();
+    }
+}
+
+void Session::registerClient(SocketPtr client_socket, int recv_class) {
     if (!client_socket || !client_socket->isValid()) {
         LOG_ERROR("[Session ", session_id_, "] Attempted to add invalid client socket");
         return;
@@ -75,13 +235,22 @@ void Session::addClient(SocketPtr client_socket) {
         client_sockets_[client_fd] = client_socket;
         LOG_INFO("[Session ", session_id_, "] Added client ", client_fd);
         
-        // 클라이언트가 추가되면 즉시 읽기 작업 준비
-        // 직접 IOUring의 prepareRead 호출
+        // 클라이언트가 추가되면 즉시 읽기 작업 준비 (소유 스레드에서만 SQE를 준비)
         if (io_ring_) {
             LOG_TRACE("[Session ", session_id_, "] Preparing read for client ", client_fd);
-            io_ring_->prepareRead(client_fd);
+            // 크기 클래스 모드에서는 기본(1 KB) 클래스에서 시작해 수신 크기 이력에 따라 옮겨 감
+            // 다른 세션에서 옮겨 온 연결은 쓰던 클래스를 이어서 사용
+            if (io_ring_->usesRecvSizeClasses()) {
+                uint8_t initial_class = static_cast<uint8_t>(io_ring_->getDefaultRecvClass());
+                if (recv_class >= 0 && static_cast<unsigned>(recv_class) < io_ring_->getRecvClassCount()) {
+                    initial_class = static_cast<uint8_t>(recv_class);
+                }
+                recv_class_state_[client_fd] = RecvClassState{initial_class, initial_class};
+            }
+            // 막 연결되었거나 옮겨 온 소켓은 대개 비어 있으므로 recv 시도 없이 poll부터 등록
+            armRecv(client_fd, true);
         } else {
-            LOG_ERROR("[Session ", session_id_, "] IOUring is null in addClient");
+            LOG_ERROR("[Session ", session_id_, "] IOUring is null in registerClient");
         }
     } catch (const std::exception& e) {
         LOG_ERROR("[Session ", session_id_, "] Exception adding client ", client_fd, ": ", e.what());
@@ -102,6 +271,23 @@ void Session::removeClient(SocketPtr client_socket) {
     
     try {
         client_sockets_.erase(client_fd);
+        rx_carry_.erase(client_fd);
+        recv_class_state_.erase(client_fd);
+        starved_recvs_.erase(std::remove(starved_recvs_.begin(), starved_recvs_.end(), client_fd), starved_recvs_.end());
+        paused_recvs_.erase(client_fd);
+        migrations_.erase(client_fd);
+        v2_clients_.erase(client_fd);
+        last_announce_.erase(client_fd);
+        leaveRoom(client_fd);
+        auto large_it = large_frames_.find(client_fd);
+        if (large_it != large_frames_.end()) {
+            for (const QueuedSend& segment : large_it->second.segments) {
+                unpinRecvBuffer(segment.id);
+            }
+            pin_reserved_ -= large_it->second.reserved;
+            large_frames_.erase(large_it);
+        }
+        dropSendQueue(client_fd);
         LOG_INFO("[Session ", session_id_, "] Removed client ", client_fd);
     } catch (const std::exception& e) {
         LOG_ERROR("[Session ", session_id_, "] Exception removing client ", client_fd, ": ", e.what());
@@ -109,22 +295,28 @@ void Session::removeClient(SocketPtr client_socket) {
 }
 
 bool Session::processEvents() {
-    if (client_sockets_.empty() || !io_ring_) {
+    drainPendingClients();
+    
+    // 클라이언트가 없어도 링에서 대기 (새 연결은 RECV_CLIENT/RECV_FD CQE로 도착)
+    if (!io_ring_) {
         return false;
     }
     
     unsigned num_cqes = io_ring_->peekCQE(cqes_);
     
-    if (num_cqes == 0) {
-        const int result = io_ring_->submitAndWait();
-        if (result == -EINTR) {
-            return true; // 인터럽트는 오류가 아님
+    // 나눠 보내는 팬아웃이 남아 있으면 블로킹하지 않고 배치 끝에서 다음 조각을 보냄 (송신 풀을 기다리는 중이면 대기)
+    if (num_cqes == 0 && (fanout_jobs_.empty() || fanoutWaitsForPool())) {
+        const int result = waitForEvents();
+        if (result == -EINTR || result == -ETIME) {
+            return true; // 인터럽트와 대기 시간 초과는 오류가 아님
         }
         if (result < 0) {
             LOG_ERROR("[Session ", session_id_, "] io_uring_submit_and_wait failed: ", result);
             return false;
         }
-        num_cqes = io_ring_->peekCQE(cqes_);
+        num_cqes = static_cast<unsigned>(result);
+    } else if (num_cqes > 0) {
+        ++stats_.ready_batches;
     }
     
     // CQE 배치 크기 제한 확인
@@ -142,6 +334,66 @@ bool Session::processEvents() {
         
         Operation ctx = getContext(cqe);
         
+        // close 완료는 결과와 관계없이 고정 파일 슬롯을 반환해야 하므로 먼저 처리
+        if (ctx.op_type == OperationType::CLOSE) {
+            handleCloseComplete(cqe, ctx);
+            continue;
+        }
+        // 제로 카피 전송은 오류가 나도 알림 여부에 따라 버퍼를 반환해야 하므로 먼저 처리
+        if (ctx.op_type == OperationType::SEND_ZC) {
+            handleSendZc(cqe, ctx);
+            continue;
+        }
+        // 송신 풀 전송도 실패 시 슬롯 반환과 연결 종료를 직접 처리
+        if (ctx.op_type == OperationType::WRITE_FIXED || ctx.op_type == OperationType::SEND_SKIP ||
+            ctx.op_type == OperationType::SEND_VECTOR) {
+            handlePoolSend(cqe, ctx);
+            continue;
+        }
+        // recv 버퍼로 보낸 응답은 실패해도 버퍼를 링에 돌려줘야 함
+        if (ctx.op_type == OperationType::WRITE) {
+            handleWrite(cqe, ctx);
+            continue;
+        }
+        
+        // accept 실패도 멀티샷을 끝내므로 오류 필터보다 먼저 처리해 다시 등록
+        if (ctx.op_type == OperationType::ACCEPT) {
+            handleAccept(cqe);
+            continue;
+        }
+        // 고정 파일 슬롯 전달은 결과와 관계없이 원본 슬롯을 닫거나 연결을 되찾아야 하므로 먼저 처리
+        if (ctx.op_type == OperationType::SEND_FD) {
+            handleSendFdComplete(cqe, ctx);
+            continue;
+        }
+        // 세션 이동 알림은 실패했을 때만 CQE가 옴
+        if (ctx.op_type == OperationType::SEND_MIGRATION) {
+            handleSendMigrationFailed(cqe, ctx);
+            continue;
+        }
+        // 방 수신함 알림도 실패했을 때만 CQE가 옴
+        if (ctx.op_type == OperationType::SEND_ROOM) {
+            handleSendRoomFailed(cqe, ctx);
+            continue;
+        }
+        
+        // 히스토리 fdatasync는 실패해도 세그먼트의 진행 중 표시를 풀어야 함
+        if (ctx.op_type == OperationType::HISTORY_SYNC) {
+            handleHistorySync(cqe, ctx);
+            continue;
+        }
+        
+        // 취소 SQE는 실패했을 때만 CQE가 옴 (recv가 이미 끝났으면 그 CQE에서 새 클래스로 다시 등록됨)
+        if (ctx.op_type == OperationType::CANCEL) {
+            LOG_DEBUG("[Session ", session_id_, "] Recv cancel for client ", ctx.client_fd, " finished: ", cqe->res);
+            continue;
+        }
+        // 클래스 전환(-ECANCELED)과 버퍼 부족(-ENOBUFS)은 멀티샷 recv를 끝내므로 handleRead에서 다시 등록
+        if (ctx.op_type == OperationType::READ && (cqe->res == -ECANCELED || cqe->res == -ENOBUFS)) {
+            handleRead(cqe, ctx);
+            continue;
+        }
+        
         // 허용 가능한 오류인 경우 계속 진행
         const bool isFatalError = (cqe->res < 0 && 
                                   cqe->res != -EAGAIN && 
@@ -160,10 +412,23 @@ bool Session::processEvents() {
             case OperationType::READ:
                 handleRead(cqe, ctx);
                 break;
-            case OperationType::WRITE:
-                handleWrite(cqe, ctx);
+            case OperationType::WAKEUP:
+                handleWakeup(cqe);
+                break;
+            case OperationType::RECV_FD:
+                handleReceivedFd(cqe);
+                break;
+            case OperationType::RECV_CLIENT:
+                handleReceivedClient(cqe);
                 break;
-            case OperationType::CLOSE:
+            case OperationType::RECV_MIGRATION:
+                drainPendingClients();
+                break;
+            case OperationType::RECV_MIGRATION_FD:
+                handleReceivedMigrationFd(cqe, ctx);
+                break;
+            case OperationType::RECV_ROOM:
+                drainRoomInbox();
                 break;
             default:
                 LOG_ERROR("[Session ", session_id_, "] Unknown operation type: ", static_cast<int>(ctx.op_type));
@@ -173,16 +438,244 @@ bool Session::processEvents() {
     
     io_ring_->advanceCQ(num_cqes);
     
+    // 이번 배치까지의 CQE에 실패가 없었던 skip 모드 전송을 성공으로 반영
+    reclaimSkipSends();
+    
+    // 디버그 모드: 이번 배치에서 받은 버퍼 중 아무도 소유하지 않은 것(누수)을 회수
+    stats_.buffer_leaks += io_ring_->auditRecvBuffers();
+    
+    // 배치에서 반환된 버퍼를 반영해 recv 버퍼를 늘리고 미뤄 둔 recv를 다시 등록
+    maintainRecvBuffers();
+    
+    // recv 종료와 전송 완료를 모두 확인한 이동 중 연결을 대상 세션으로 넘김
+    completeMigrations();
+    
+    // 이번 배치의 CQE를 처리한 뒤 대기 중인 팬아웃을 한 조각만큼 이어 보냄
+    runFanoutSlices();
+    closeSlowConsumers();
+    
+    // 이번 배치에 기록한 히스토리 세그먼트를 묶어서 fdatasync (그룹 커밋)
+    commitHistory();
+    
     // 모든 작업 처리 후 한 번만 submit 호출
     io_ring_->submit();
+    
+    // 링 확장은 CQE를 모두 반환한 뒤에만 안전함
+    checkRingPressure();
     return true;
 }
 
+int Session::waitForEvents() {
+    const auto wait_start = SpinClock::now();
+    const uint64_t budget_ns = spinBudgetNs();
+    
+    if (budget_ns > 0) {
+        // 스핀하는 동안에도 앞선 배치의 응답이 나가도록 먼저 제출
+        io_ring_->submit();
+        do {
+            cpuRelax();
+            const unsigned num_cqes = io_ring_->pollCQE(cqes_);
+            if (num_cqes > 0) {
+                ++stats_.spin_hits;
+                recordIdleGap(elapsedNs(wait_start));
+                return static_cast<int>(num_cqes);
+            }
+        } while (elapsedNs(wait_start) < budget_ns);
+        ++stats_.spin_misses;
+    }
+    
+    ++stats_.sleeps;
+    const int result = io_ring_->submitAndWait(wait_timeout_ms_);
+    if (result == -ETIME) {
+        ++stats_.wait_timeouts;
+    }
+    if (result < 0) {
+        return result;
+    }
+    if (busy_poll_max_ns_ > 0) {
+        recordIdleGap(elapsedNs(wait_start));
+    }
+    return static_cast<int>(io_ring_->peekCQE(cqes_));
+}
+
+uint64_t Session::spinBudgetNs() const {
+    if (busy_poll_max_ns_ == 0) {
+        return 0;
+    }
+    if (avg_idle_gap_ns_ == 0) {
+        return busy_poll_max_ns_;  // 표본이 없으면 최대 예산으로 시작
+    }
+    // 평균 유휴 간격이 예산보다 길면 스핀해도 대부분 놓치므로 바로 잠듦
+    if (avg_idle_gap_ns_ > busy_poll_max_ns_) {
+        return 0;
+    }
+    // 평균의 두 배면 지터가 있어도 대부분의 도착을 스핀 중에 잡을 수 있음
+    return std::min(busy_poll_max_ns_, avg_idle_gap_ns_ * 2);
+}
+
+void Session::recordIdleGap(uint64_t gap_ns) {
+    // 긴 유휴 구간 하나가 평균을 오래 지배하지 않도록 "스핀 불가" 판정에 충분한 값으로 자름
+    gap_ns = std::min(gap_ns, busy_poll_max_ns_ * 2);
+    if (avg_idle_gap_ns_ == 0) {
+        avg_idle_gap_ns_ = std::max<uint64_t>(gap_ns, 1);
+        return;
+    }
+    const int64_t delta = static_cast<int64_t>(gap_ns) - static_cast<int64_t>(avg_idle_gap_ns_);
+    avg_idle_gap_ns_ = std::max<int64_t>(1, static_cast<int64_t>(avg_idle_gap_ns_) + (delta >> IDLE_GAP_EWMA_SHIFT));
+}
+
+void Session::checkRingPressure() {
+    if (client_sockets_.size() > stats_.peak_clients) {
+        stats_.peak_clients = client_sockets_.size();
+    }
+    
+    // 오버플로된 CQE는 커널 백로그에 보관되고 다음 peek에서 CQ로 옮겨짐 (유실은 아니지만 CQ가 작다는 신호)
+    const bool overflowed = io_ring_->hasCQOverflow();
+    if (overflowed) {
+        ++stats_.cq_overflow_batches;
+        if (stats_.cq_overflow_batches == 1 || stats_.cq_overflow_batches % 1024 == 0) {
+            LOG_WARN("[Session ", session_id_, "] CQ overflow (CQ ", io_ring_->getCQEntries(), " entries, ",
+                     client_sockets_.size(), " clients, ", stats_.cq_overflow_batches, " batches so far)");
+        }
+    }
+    
+    // 백로그 할당마저 실패하면 CQE가 버려짐: 해당 연결의 recv/write 완료가 사라진 것
+    const unsigned dropped = io_ring_->getDroppedCQEs();
+    if (dropped != last_dropped_cqes_) {
+        const unsigned delta = dropped - last_dropped_cqes_;
+        stats_.cq_dropped += delta;
+        last_dropped_cqes_ = dropped;
+        LOG_ERROR("[Session ", session_id_, "] Kernel dropped ", delta, " CQEs (total ", stats_.cq_dropped, ")");
+    }
+    
+    if (io_ring_->growForConnections(client_sockets_.size(), overflowed)) {
+        ++stats_.ring_resizes;
+    }
+}
+
+void Session::logStats() const {
+    LOG_INFO("[Session ", session_id_, "] Ring stats: CQ ", io_ring_ ? io_ring_->getCQEntries() : 0,
+             " entries, peak clients ", stats_.peak_clients,
+             ", overflow batches ", stats_.cq_overflow_batches,
+             ", dropped CQEs ", stats_.cq_dropped,
+             ", resizes ", stats_.ring_resizes);
+    LOG_INFO("[Session ", session_id_, "] Wait stats: ready ", stats_.ready_batches,
+             ", spin hits ", stats_.spin_hits,
+             ", spin misses ", stats_.spin_misses,
+             ", sleeps ", stats_.sleeps,
+             ", timeouts ", stats_.wait_timeouts,
+             ", avg idle gap ", avg_idle_gap_ns_ / 1000, "us");
+    if (listening_socket_) {
+        LOG_INFO("[Session ", session_id_, "] Accept stats: accepted ", stats_.accepts,
+                 ", errors ", stats_.accept_errors);
+    }
+    if (io_ring_ && io_ring_->usesZeroCopy()) {
+        LOG_INFO("[Session ", session_id_, "] Zero-copy stats: sends ", stats_.zc_sends,
+                 ", notifications ", stats_.zc_notifs,
+                 ", buffers still held ", io_ring_->getBufferManager().zeroCopyInFlight());
+    }
+    if (SendBufferPool* send_pool = io_ring_ ? io_ring_->getSendPool() : nullptr) {
+        LOG_INFO("[Session ", session_id_, "] Send pool stats: sends ", stats_.pool_sends,
+                 ", exhausted ", stats_.pool_exhausted,
+                 ", errors ", stats_.pool_send_errors,
+                 ", skip send retries ", stats_.skip_send_retries,
+                 ", vector sends ", stats_.vector_sends,
+                 " (", stats_.vector_slots, " slots)",
+                 ", free slots ", send_pool->available(), "/", send_pool->capacity());
+    }
+    if (io_ring_ && io_ring_->usesRecvBundle()) {
+        LOG_INFO("[Session ", session_id_, "] Bundle stats: recv CQEs ", stats_.recv_bundles,
+                 ", buffers ", stats_.recv_bundle_buffers,
+                 ", coalesced responses ", stats_.coalesced_frames);
+    }
+    if (io_ring_ && io_ring_->hasProvidedBuffers()) {
+        LOG_INFO("[Session ", session_id_, "] Recv buffer stats: ENOBUFS ", stats_.recv_enobufs,
+                 ", deferred ", stats_.recv_deferred,
+                 ", resumed ", stats_.recv_resumed,
+                 ", still deferred ", starved_recvs_.size(),
+                 ", buffers grown ", stats_.recv_buffers_grown,
+                 ", leaks reclaimed ", stats_.buffer_leaks);
+        for (unsigned recv_class = 0; recv_class < io_ring_->getRecvClassCount(); ++recv_class) {
+            const UringBuffer& group = io_ring_->getRecvClass(recv_class);
+            LOG_INFO("[Session ", session_id_, "] Recv buffer group ", group.getBufferGroup(),
+                     " (", group.getBufferSize(), " B): free ", group.available(),
+                     "/", group.getActiveBuffers(), ", cap ", group.getNumBuffers(),
+                     ", peak in use ", group.getActiveBuffers() - group.getMinAvailable(),
+                     ", double releases ", group.getDoubleReleases());
+        }
+    }
+    if (io_ring_ && io_ring_->usesRecvSizeClasses()) {
+        LOG_INFO("[Session ", session_id_, "] Recv class stats: upgrades ", stats_.recv_class_upgrades,
+                 ", downgrades ", stats_.recv_class_downgrades,
+                 ", switches ", stats_.recv_class_switches);
+    }
+    if (stats_.v2_frames > 0 || stats_.large_frame_copies > 0) {
+        LOG_INFO("[Session ", session_id_, "] Protocol v2 stats: frames ", stats_.v2_frames,
+                 ", large frames ", stats_.large_frames,
+                 " (", stats_.large_frame_buffers, " pinned buffers)",
+                 ", copied large frames ", stats_.large_frame_copies,
+                 ", still pinned ", pinned_buffers_);
+    }
+    if (stats_.broadcasts > 0 || stats_.broadcast_failures > 0) {
+        LOG_INFO("[Session ", session_id_, "] Broadcast stats: messages ", stats_.broadcasts,
+                 ", deliveries ", stats_.broadcast_deliveries,
+                 ", shared slots ", stats_.broadcast_slots,
+                 ", skipped v1 recipients ", stats_.broadcast_skipped,
+                 ", failures ", stats_.broadcast_failures,
+                 ", local rooms ", rooms_.size());
+    }
+    if (stats_.fanout_completed > 0 || stats_.fanout_deferred > 0) {
+        LOG_INFO("[Session ", session_id_, "] Fan-out stats: completed ", stats_.fanout_completed,
+                 ", avg ", stats_.fanout_completed ? stats_.fanout_latency_us_total / stats_.fanout_completed : 0, " us",
+                 ", max ", stats_.fanout_latency_us_max, " us",
+                 ", over budget ", stats_.fanout_over_budget,
+                 ", deferred ", stats_.fanout_deferred, " (", stats_.fanout_slices, " slices)",
+                 ", announcements ", stats_.announcements,
+                 " (", stats_.announce_rejected, " rejected)");
+    }
+    if (stats_.flow_pauses > 0 || stats_.slow_dropped > 0 || stats_.slow_coalesced > 0 || stats_.slow_disconnects > 0) {
+        LOG_INFO("[Session ", session_id_, "] Slow consumer stats: recv paused ", stats_.flow_pauses,
+                 " (resumed ", stats_.flow_resumes, ")",
+                 ", dropped frames ", stats_.slow_dropped,
+                 ", coalesced frames ", stats_.slow_coalesced,
+                 ", disconnects ", stats_.slow_disconnects);
+    }
+    if (stats_.history_appends > 0 || stats_.history_replays > 0 || stats_.history_append_failures > 0) {
+        LOG_INFO("[Session ", session_id_, "] History stats: appended ", stats_.history_appends,
+                 " (", stats_.history_append_failures, " failed)",
+                 ", syncs ", stats_.history_syncs, " (", stats_.history_sync_errors, " failed)",
+                 ", replays ", stats_.history_replays, " with ", stats_.history_replayed, " messages",
+                 " (", stats_.history_replay_failures, " cut short, ", stats_.history_replay_capped,
+                 " over the send queue limit)");
+    }
+    if (stats_.room_posts > 0 || stats_.room_received > 0) {
+        LOG_INFO("[Session ", session_id_, "] Cross-session room stats: posted ", stats_.room_posts,
+                 " (", stats_.room_notifies, " wakeups)",
+                 ", received ", stats_.room_received);
+    }
+    if (stats_.migrations_out > 0 || stats_.migrations_in > 0) {
+        LOG_INFO("[Session ", session_id_, "] Migration stats: out ", stats_.migrations_out,
+                 ", in ", stats_.migrations_in,
+                 ", carried bytes ", stats_.migration_carry_bytes,
+                 ", fixed file hand-offs kept ", stats_.migration_fd_failures);
+    }
+    if (io_ring_ && io_ring_->usesIncrementalRecv()) {
+        LOG_INFO("[Session ", session_id_, "] Incremental recv stats: CQEs ", stats_.recv_incremental,
+                 ", buffers retired ", stats_.recv_incremental_retired,
+                 ", coalesced responses ", stats_.coalesced_frames);
+    }
+}
+
 void Session::handleRead(io_uring_cqe* cqe, const Operation& ctx) {
     const int result = cqe->res;
     int client_fd = ctx.client_fd;
-    const uint16_t buffer_idx = ctx.buffer_idx;
+    // 커널이 provided buffer ring에서 고른 버퍼 ID는 user_data가 아니라 CQE 플래그에 들어 있음
+    const uint16_t buffer_idx = static_cast<uint16_t>(cqe->flags >> IORING_CQE_BUFFER_SHIFT);
     bool closed = false;
+    
+    // 버퍼를 가져간 CQE는 처리 결과와 관계없이 장부에 기록 (READ 컨텍스트의 buffer_idx는 크기 클래스)
+    const unsigned bytes = result > 0 ? static_cast<unsigned>(result) : 0;
+    io_ring_->noteRecvBuffers(ctx.buffer_idx, buffer_idx, bytes, cqe->flags);
 
     LOG_TRACE("[Session ", session_id_, "] Read result for client ", client_fd, ": ", result);
     
@@ -190,6 +683,7 @@ void Session::handleRead(io_uring_cqe* cqe, const Operation& ctx) {
     auto it = client_sockets_.find(client_fd);
     if (it == client_sockets_.end()) {
         LOG_ERROR("[Session ", session_id_, "] Cannot find socket for client_fd ", client_fd);
+        io_ring_->discardRecvBuffers(ctx.buffer_idx, buffer_idx, bytes, cqe->flags);
         return;
     }
     SocketPtr client_socket = it->second;
@@ -200,18 +694,26 @@ void Session::handleRead(io_uring_cqe* cqe, const Operation& ctx) {
         handleClose(client_socket);
         closed = true;
         return;
+    } else if ((result == -ECANCELED || result == -ENOBUFS) && migrations_.count(client_fd)) {
+        // 세션 이동을 위해 취소했거나 버퍼 부족으로 끝난 recv: 다시 등록하지 않고 대상 세션에 맡김
+        migrations_[client_fd].recv_done = true;
+        return;
+    } else if (result == -ECANCELED) {
+        // 크기 클래스 전환을 위해 취소한 멀티샷 recv: 새 클래스로 다시 등록 (흐름 제어로 멈춘 연결은 재개할 때 등록)
+        if (!paused_recvs_.count(client_fd)) {
+            ++stats_.recv_class_switches;
+        }
+        armRecv(client_fd);
+        return;
+    } else if (result == -ENOBUFS) {
+        // 링이 비어 멀티샷 recv가 끝남: 버퍼를 늘리거나 반환될 때까지 재등록을 미룸
+        handleRecvStarved(client_fd, ctx.buffer_idx);
+        return;
     } else if (result < 0) {
-        // 기타 오류
+        // 기타 오류는 연결 종료로 처리
         LOG_ERROR("[Session ", session_id_, "] Read error for client ", client_fd, ": ", -result);
-        
-        if (result == -ENOBUFS) {
-            // 버퍼 부족 - 이 경우 일반적으로 재시도 가능
-            LOG_WARN("[Session ", session_id_, "] No buffer available for client ", client_fd);
-        } else {
-            // 다른 오류는 연결 종료로 처리
-            handleClose(client_socket);
-            closed = true;
-        }
+        handleClose(client_socket);
+        closed = true;
         return;
     }
 
@@ -226,6 +728,36 @@ void Session::handleRead(io_uring_cqe* cqe, const Operation& ctx) {
         return;
     }
     
+    if (io_ring_->usesRecvBundle()) {
+        const bool registered = handleReadBundle(client_socket, buffer_idx, static_cast<unsigned>(result));
+        if (registered && !(cqe->flags & IORING_CQE_F_MORE)) {
+            armRecv(client_fd);
+        }
+        return;
+    }
+    
+    if (io_ring_->usesRecvSizeClasses()) {
+        const bool registered = handleReadClassed(client_socket, ctx.buffer_idx, buffer_idx,
+                                                  static_cast<unsigned>(result));
+        if (registered) {
+            continueRecv(client_fd, (cqe->flags & IORING_CQE_F_MORE) != 0);
+        }
+        return;
+    }
+    
+    if (io_ring_->usesIncrementalRecv()) {
+#ifdef IORING_CQE_F_BUF_MORE
+        const bool buffer_more = (cqe->flags & IORING_CQE_F_BUF_MORE) != 0;
+#else
+        const bool buffer_more = false;
+#endif
+        const bool registered = handleReadIncremental(client_socket, buffer_idx, static_cast<unsigned>(result),
+                                                      buffer_more);
+        if (registered && !(cqe->flags & IORING_CQE_F_MORE)) {
+            armRecv(client_fd);
+        }
+        return;
+    }
     
     // 버퍼 매니저에서 데이터 주소 가져오기
     auto& buffer_manager = io_ring_->getBufferManager();
@@ -233,194 +765,1473 @@ void Session::handleRead(io_uring_cqe* cqe, const Operation& ctx) {
     
     if (!addr) {
         LOG_ERROR("[Session ", session_id_, "] Failed to get buffer address for index ", buffer_idx);
+        io_ring_->releaseBuffer(buffer_idx);
         handleClose(client_socket);
-        closed = true;
-        return;
-    }
-
-    // 최소한 헤더는 읽었는지 확인
-    if (result < CHAT_MESSAGE_HEADER_SIZE) {
-        LOG_ERROR("[Session ", session_id_, "] Incomplete message header from client ", client_fd, 
-                ": received only ", result, " bytes");
-        handleClose(client_socket);
-        closed = true;
         return;
     }
     
-    auto* message = reinterpret_cast<ChatMessage*>(addr);
-    
-    // 메시지 검증
-    uint8_t msg_type = static_cast<uint8_t>(message->header.type);
-    uint8_t client_min_type = static_cast<uint8_t>(MessageType::CLIENT_JOIN);
-    uint8_t client_max_type = static_cast<uint8_t>(MessageType::CLIENT_COMMAND);
-    
-    if (msg_type < client_min_type || msg_type > client_max_type) {
-        LOG_ERROR("[Session ", session_id_, "] Invalid message type from client ", client_fd, 
-                ": 0x", std::hex, static_cast<int>(msg_type), std::dec);
-        handleClose(client_socket);
-        closed = true;
-    } else if (message->header.length > MAX_MESSAGE_SIZE) {
-        LOG_ERROR("[Session ", session_id_, "] Message too long from client ", client_fd, 
-                ": ", message->header.length, " bytes (max: ", MAX_MESSAGE_SIZE, ")");
-        handleClose(client_socket);
-        closed = true;
-    } else if (message->header.length == 0) {
-        LOG_ERROR("[Session ", session_id_, "] Empty message from client ", client_fd);
-        handleClose(client_socket);
-        closed = true;
-    // 전체 메시지가 완전히 수신되었는지 확인
-    } else if (result < (CHAT_MESSAGE_HEADER_SIZE + message->header.length)) {
-        LOG_ERROR("[Session ", session_id_, "] Incomplete message body from client ", client_fd, 
-                ": expected ", (CHAT_MESSAGE_HEADER_SIZE + message->header.length),
-                " bytes, received only ", result, " bytes");
-        handleClose(client_socket);
-        closed = true;
+    // 경계에 걸친 조각 없이 버퍼에 프레임이 정확히 하나 있으면 recv 버퍼를 응답에 재활용하는 경로
+    auto carry_it = rx_carry_.find(client_fd);
+    const bool has_carry = (carry_it != rx_carry_.end() && !carry_it->second.empty()) ||
+                           large_frames_.find(client_fd) != large_frames_.end();
+    FrameHeader header{};
+    if (!has_carry && migrations_.find(client_fd) == migrations_.end() &&
+        parseClientHeader(addr, static_cast<size_t>(result), header) > 0 &&
+        header.size + header.length == static_cast<size_t>(result)) {
+        processMessage(client_socket, header, addr + header.size, buffer_idx);
+        
+        // 응답 전송에 넘어가지 않은 버퍼(응답 없는 메시지, 오류 종료)는 여기서 링에 반환
+        if (buffer_manager.getOwner(buffer_idx) == BufferOwner::PARSER) {
+            io_ring_->releaseBuffer(buffer_idx);
+        }
+        closed = client_sockets_.find(client_fd) == client_sockets_.end();
     } else {
-        // 메시지 직접 처리
-        processMessage(client_socket, message, buffer_idx);
+        // 여러 프레임이 합쳐졌거나 프레임이 recv 경계에 걸침: 버퍼 안에서 완성된 프레임을 모두 처리하고
+        // 남은 조각만 연결별 스필 영역에 복사 (응답은 송신 풀 슬롯에 모아 한 번에 전송, 큰 v2 프레임은 버퍼를 고정)
+        closed = !consumeStream(client_socket, addr, static_cast<size_t>(result), buffer_idx);
+        finishRecvBuffer(buffer_idx);
+        flushOutbound();
     }
     
     // 연결이 종료되지 않았고, 더 이상 데이터가 없으면 새 recv 작업 추가
     if (!closed && !(cqe->flags & IORING_CQE_F_MORE)) {
-        if (io_ring_) {
-            io_ring_->prepareRead(client_fd);
-        }
+        armRecv(client_fd);
     }
 }
 
-void Session::handleWrite(io_uring_cqe* cqe, const Operation& ctx) {
-    if (cqe->res < 0 && cqe->res != -EAGAIN && cqe->res != -ECONNRESET) {
-        LOG_ERROR("[Session ", session_id_, "] Write failed for client ", ctx.client_fd, ": ", -cqe->res);
-        // client_fd로 Socket 객체 찾기
-        auto it = client_sockets_.find(ctx.client_fd);
-        if (it != client_sockets_.end()) {
-            handleClose(it->second);
+bool Session::handleReadBundle(SocketPtr client_socket, uint16_t first_buffer_idx, unsigned bytes) {
+    auto& buffer_manager = io_ring_->getBufferManager();
+    buffer_manager.collectBundle(first_buffer_idx, bytes, bundle_buffers_);
+    ++stats_.recv_bundles;
+    stats_.recv_bundle_buffers += bundle_buffers_.size();
+    
+    // 버퍼별로 파싱하고 경계에 걸친 조각만 rx_carry_로 복사한 뒤 버퍼는 바로 링에 반환 (큰 v2 프레임이 고정한 버퍼 제외)
+    bool registered = true;
+    unsigned remaining = bytes;
+    for (uint16_t idx : bundle_buffers_) {
+        const unsigned chunk = std::min(remaining, buffer_manager.getBufferSize());
+        const uint8_t* addr = buffer_manager.getBufferAddr(idx, buffer_manager.getBaseAddr());
+        if (registered && addr) {
+            registered = consumeStream(client_socket, addr, chunk, idx);
         }
-        return;
+        remaining -= chunk;
+        finishRecvBuffer(idx);
     }
     
-    // 버퍼 사용 완료 처리
-    io_ring_->handleWriteComplete(ctx.client_fd, ctx.buffer_idx, cqe->res);
+    flushOutbound();
+    return registered;
 }
 
-void Session::handleClose(SocketPtr client_socket) {
-    if (!client_socket || !client_socket->isValid()) {
-        LOG_ERROR("[Session ", session_id_, "] Attempted to close invalid client socket");
-        return;
+bool Session::handleReadClassed(SocketPtr client_socket, uint16_t recv_class, uint16_t buffer_idx, unsigned bytes) {
+    if (recv_class >= io_ring_->getRecvClassCount()) {
+        LOG_ERROR("[Session ", session_id_, "] Invalid recv class ", recv_class,
+                 " for client ", client_socket->getSocketFd());
+        handleClose(client_socket);
+        return false;
+    }
+    auto& buffer_group = io_ring_->getRecvClass(recv_class);
+    const uint8_t* addr = buffer_group.getBufferAddr(buffer_idx, buffer_group.getBaseAddr());
+    if (!addr) {
+        LOG_ERROR("[Session ", session_id_, "] Failed to get buffer address for index ", buffer_idx,
+                 " in recv class ", recv_class);
+        handleClose(client_socket);
+        return false;
     }
     
-    int32_t client_fd = client_socket->getSocketFd();
-    LOG_INFO("[Session ", session_id_, "] Closing connection for client ", client_fd);
-    
-    // 세션에서 클라이언트 제거
-    removeClient(client_socket);
-    
-    // SessionManager에서도 클라이언트-세션 매핑 제거
-    SessionManager::getInstance().removeSession(client_fd);
-    
-    // 소켓 닫기 작업 예약
-    if (io_ring_) {
-        io_ring_->prepareClose(client_fd);
+    // 작은 클래스에서는 메시지가 여러 버퍼로 나뉘어 도착하므로 스트림 파서로 이어 붙임
+    const bool registered = consumeStream(client_socket, addr, bytes);
+    io_ring_->releaseBuffer(recv_class, buffer_idx);
+    flushOutbound();
+    if (registered) {
+        updateRecvClass(client_socket->getSocketFd(), recv_class, bytes, buffer_group.getBufferSize());
     }
+    return registered;
 }
 
-void Session::onClientJoinSession(SocketPtr client_socket, int32_t target_session_id) {
-    if (!client_socket || !client_socket->isValid()) {
-        LOG_ERROR("[Session ", session_id_, "] Attempted to move invalid client socket");
-        throw std::runtime_error("Invalid client socket");
+void Session::updateRecvClass(int32_t client_fd, unsigned recv_class, unsigned bytes, unsigned buffer_size) {
+    auto it = recv_class_state_.find(client_fd);
+    if (it == recv_class_state_.end()) {
+        return;
     }
+    RecvClassState& state = it->second;
+    const unsigned class_count = io_ring_->getRecvClassCount();
     
-    int32_t client_fd = client_socket->getSocketFd();
-    LOG_DEBUG("[Session ", session_id_, "] Processing session join request from client ", client_fd, 
-             " to session ", target_session_id);
-    
-    try {
-        // 현재 세션에서 제거
-        removeClient(client_socket);
-        
-        // 세션매니저를 통해 새 세션으로 이동
-        auto& sessionManager = SessionManager::getInstance();
-        auto targetSession = sessionManager.getSessionByIndex(target_session_id);
-        if (!targetSession) {
-            throw std::runtime_error("요청한 세션을 찾을 수 없음");
+    if (bytes >= buffer_size) {
+        // 버퍼를 가득 채움: 메시지가 잘려 여러 버퍼로 나뉘었을 가능성이 크므로 바로 한 단계 위로
+        if (recv_class + 1 < class_count && state.target <= recv_class) {
+            state.target = static_cast<uint8_t>(recv_class + 1);
+            ++stats_.recv_class_upgrades;
         }
-        
-        // 세션 매니저에서 클라이언트 매핑 제거
-        sessionManager.removeSession(client_fd);
-        
-        // 새 세션에 클라이언트 추가
-        targetSession->addClient(client_socket);
-        
-        LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " moved to session ", target_session_id);
+        state.window_cqes = 0;
+        state.window_peak = 0;
+        return;
     }
-    catch (const std::exception& e) {
-        LOG_ERROR("[Session ", session_id_, "] Error moving client to session: ", e.what());
-        throw; // 호출자에게 예외 전파
+    
+    state.window_peak = std::max(state.window_peak, bytes);
+    if (++state.window_cqes < RECV_CLASS_WINDOW) {
+        return;
+    }
+    
+    // 최근 창에서 가장 큰 수신도 가득 채우지 않는 가장 작은 클래스로 내려감
+    unsigned fit = 0;
+    while (fit + 1 < class_count && io_ring_->getRecvClass(fit).getBufferSize() <= state.window_peak) {
+        ++fit;
     }
+    if (fit < state.target) {
+        state.target = static_cast<uint8_t>(fit);
+        ++stats_.recv_class_downgrades;
+    }
+    state.window_cqes = 0;
+    state.window_peak = 0;
 }
 
-void Session::sendMessage(SocketPtr client_socket, MessageType msg_type, const void* data, size_t length, uint16_t buffer_idx) {
-    if (!client_socket || !client_socket->isValid()) {
-        LOG_ERROR("[Session ", session_id_, "] Attempted to send message to invalid client socket");
-        throw std::runtime_error("Invalid client socket");
-    }
+void Session::handleRecvStarved(int32_t client_fd, unsigned recv_class) {
+    ++stats_.recv_enobufs;
+    unsigned target_class = recv_class;
     
-    int32_t client_fd = client_socket->getSocketFd();
-    try {
-        // 수신된 버퍼 재활용
-        ChatMessage* mutable_message = const_cast<ChatMessage*>(static_cast<const ChatMessage*>(data));
-        mutable_message->init(msg_type, static_cast<uint16_t>(length));
-        
-        if (length > MAX_MESSAGE_SIZE) {
-            throw std::runtime_error("메시지 크기 초과");
-        }
-        
-        // 실제 메시지 크기만큼만 전송 (헤더 + 페이로드)
-        size_t total_size = mutable_message->getTotalSize();
-        
-        if (io_ring_) {
-            io_ring_->prepareWrite(client_fd, mutable_message, total_size, buffer_idx);
-            LOG_DEBUG("[Session ", session_id_, "] Sending message type ", static_cast<int>(msg_type),
-                     " to client ", client_fd, ", length: ", length);
-        } else {
-            LOG_ERROR("[Session ", session_id_, "] IOUring is null in sendMessage");
+    auto state_it = recv_class_state_.find(client_fd);
+    if (state_it != recv_class_state_.end()) {
+        // 크기 클래스 모드: 현재 클래스의 버퍼가 바닥났으므로 한 단계 큰 클래스로 옮김
+        const unsigned next = std::max<unsigned>(state_it->second.target, recv_class) + 1;
+        if (next < io_ring_->getRecvClassCount()) {
+            state_it->second.target = static_cast<uint8_t>(next);
+            ++stats_.recv_class_upgrades;
         }
+        target_class = state_it->second.target;
     }
-    catch (const std::exception& e) {
-        LOG_ERROR("[Session ", session_id_, "] Send failed: ", e.what());
-        throw;
+    if (target_class >= io_ring_->getRecvClassCount()) {
+        target_class = io_ring_->getDefaultRecvClass();
+    }
+    
+    // 같은 배치에서 이미 반환된 버퍼가 있거나 링을 늘릴 수 있으면 바로 다시 등록
+    UringBuffer& group = io_ring_->getRecvClass(target_class);
+    if (group.available() == 0 && group.canGrow()) {
+        stats_.recv_buffers_grown += group.grow();
     }
+    if (group.available() > 0) {
+        armRecv(client_fd);
+        return;
+    }
+    
+    // 상한에 도달: 바로 재등록하면 ENOBUFS만 반복되므로 버퍼가 돌아올 때까지 대기열에 보관
+    LOG_WARN("[Session ", session_id_, "] Recv buffers exhausted (class ", target_class,
+             "), deferring recv for client ", client_fd);
+    starved_recvs_.push_back(client_fd);
+    ++stats_.recv_deferred;
 }
 
-void Session::processMessage(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx) {
-    if (!client_socket || !client_socket->isValid()) {
-        LOG_ERROR("[Session ", session_id_, "] Attempted to process message from invalid client socket");
+void Session::maintainRecvBuffers() {
+    if (!io_ring_->hasProvidedBuffers()) {
+        return;
+    }
+    stats_.recv_buffers_grown += io_ring_->growRecvBuffers();
+    if (starved_recvs_.empty()) {
         return;
     }
     
-    int32_t client_fd = client_socket->getSocketFd();
-    LOG_DEBUG("[Session ", session_id_, "] Processing message type ", static_cast<int>(message->header.type), 
+    // 대상 그룹에 여유가 생긴 연결만 다시 등록하고 나머지는 계속 대기
+    size_t kept = 0;
+    for (int32_t client_fd : starved_recvs_) {
+        unsigned recv_class = io_ring_->getDefaultRecvClass();
+        auto state_it = recv_class_state_.find(client_fd);
+        if (state_it != recv_class_state_.end()) {
+            recv_class = state_it->second.target;
+        }
+        if (!io_ring_->getRecvClass(recv_class).hasHeadroom()) {
+            starved_recvs_[kept++] = client_fd;
+            continue;
+        }
+        armRecv(client_fd);
+        ++stats_.recv_resumed;
+    }
+    starved_recvs_.resize(kept);
+}
+
+void Session::armRecv(int32_t client_fd, bool poll_first) {
+    // 이동 중인 연결은 대상 세션이 recv를 등록하므로 끝난 recv만 기록
+    auto migration_it = migrations_.find(client_fd);
+    if (migration_it != migrations_.end()) {
+        migration_it->second.recv_done = true;
+        return;
+    }
+    // 송신 큐가 차서 멈춘 연결은 큐가 줄어들 때 resumeRecv가 다시 등록
+    auto paused_it = paused_recvs_.find(client_fd);
+    if (paused_it != paused_recvs_.end()) {
+        paused_it->second = true;
+        return;
+    }
+    
+    unsigned recv_class = io_ring_->getDefaultRecvClass();
+    auto it = recv_class_state_.find(client_fd);
+    if (it != recv_class_state_.end()) {
+        it->second.current = it->second.target;
+        it->second.cancelling = false;
+        recv_class = it->second.current;
+    }
+    io_ring_->prepareRead(client_fd, poll_first, recv_class);
+}
+
+void Session::continueRecv(int32_t client_fd, bool more) {
+    if (!more) {
+        armRecv(client_fd);
+        return;
+    }
+    // 멀티샷 recv는 등록 시 고른 버퍼 그룹을 계속 쓰므로 클래스를 바꾸려면 취소 후 다시 등록
+    auto it = recv_class_state_.find(client_fd);
+    if (it != recv_class_state_.end() && it->second.target != it->second.current && !it->second.cancelling) {
+        io_ring_->prepareCancelRead(client_fd, it->second.current);
+        it->second.cancelling = true;
+    }
+}
+
+bool Session::handleReadIncremental(SocketPtr client_socket, uint16_t buffer_idx, unsigned bytes, bool buffer_more) {
+    auto& buffer_manager = io_ring_->getBufferManager();
+    // 커널은 같은 버퍼의 이전 recv가 끝난 지점부터 채우므로 데이터 위치는 버퍼 시작이 아님
+    const uint8_t* data = buffer_manager.consumeIncremental(buffer_idx, bytes, buffer_more);
+    if (!data) {
+        LOG_ERROR("[Session ", session_id_, "] Invalid incremental buffer ", buffer_idx,
+                 " from client ", client_socket->getSocketFd());
+        handleClose(client_socket);
+        return false;
+    }
+    ++stats_.recv_incremental;
+    if (!buffer_more) {
+        ++stats_.recv_incremental_retired;
+    }
+    
+    const bool registered = consumeStream(client_socket, data, bytes);
+    // 완성된 메시지는 처리됐고 남은 조각은 rx_carry_로 복사됐으므로 이번 범위는 모두 반환
+    buffer_manager.releaseIncremental(buffer_idx, bytes);
+    flushOutbound();
+    return registered;
+}
+
+bool Session::consumeStream(SocketPtr client_socket, const uint8_t* data, size_t length, uint16_t buffer_idx) {
+    const int32_t client_fd = client_socket->getSocketFd();
+    
+    // 이동 중인 연결의 데이터는 취소가 반영되기 전에 도착한 것이므로 대상 세션이 처리하도록 보관
+    auto migration_it = migrations_.find(client_fd);
+    if (migration_it != migrations_.end()) {
+        migration_it->second.carry.insert(migration_it->second.carry.end(), data, data + length);
+        return true;
+    }
+    
+    try {
+        // 조립 중인 큰 프레임이 있으면 이번 데이터에서 나머지 페이로드를 먼저 가져감
+        if (large_frames_.find(client_fd) != large_frames_.end()) {
+            const size_t taken = continueLargeFrame(client_socket, data, length, buffer_idx);
+            data += taken;
+            length -= taken;
+            if (large_frames_.find(client_fd) != large_frames_.end()) {
+                return true;
+            }
+            if (taken > 0 && streamInterrupted(client_fd, data, length)) {
+                return client_sockets_.find(client_fd) != client_sockets_.end();
+            }
+        }
+        
+        // 이전 recv에서 경계에 걸친 프레임이 있으면 그 프레임을 완성하는 만큼만 스필 영역에 복사
+        auto carry_it = rx_carry_.find(client_fd);
+        if (carry_it != rx_carry_.end() && !carry_it->second.empty()) {
+            // 처리 중 연결이 닫히면 rx_carry_ 항목이 지워지므로 지역 변수로 옮겨서 사용
+            std::vector<uint8_t> spill = std::move(carry_it->second);
+            size_t taken = 0;
+            FrameHeader header{};
+            // v2 헤더 길이는 varint에 따라 달라지므로 헤더가 완성될 때까지 한 바이트씩 이어 붙임
+            int parsed = parseClientHeader(spill.data(), spill.size(), header);
+            while (parsed == 0 && taken < length) {
+                spill.push_back(data[taken++]);
+                parsed = parseClientHeader(spill.data(), spill.size(), header);
+            }
+            if (parsed < 0) {
+                LOG_ERROR("[Session ", session_id_, "] Invalid message header from client ", client_fd,
+                         ": first byte 0x", std::hex, static_cast<int>(spill[0]), std::dec);
+                handleClose(client_socket);
+                return false;
+            }
+            
+            if (parsed > 0 && spill.size() == header.size && beginLargeFrame(client_fd, header, buffer_idx)) {
+                // 헤더만 경계에 걸친 큰 프레임: 페이로드는 복사하지 않고 이번 버퍼부터 고정
+                spill.clear();
+                rx_carry_[client_fd] = std::move(spill);
+                const size_t consumed = continueLargeFrame(client_socket, data + taken, length - taken, buffer_idx);
+                data += taken + consumed;
+                length -= taken + consumed;
+                if (large_frames_.find(client_fd) != large_frames_.end() || streamInterrupted(client_fd, data, length)) {
+                    return client_sockets_.find(client_fd) != client_sockets_.end();
+                }
+            } else {
+                if (parsed > 0) {
+                    const size_t frame_size = header.size + header.length;
+                    const size_t needed = std::min(frame_size - spill.size(), length - taken);
+                    spill.insert(spill.end(), data + taken, data + taken + needed);
+                    taken += needed;
+                    
+                    if (spill.size() == frame_size) {
+                        processMessage(client_socket, header, spill.data() + header.size, NO_RECV_BUFFER);
+                        spill.clear();
+                        if (streamInterrupted(client_fd, data + taken, length - taken)) {
+                            return client_sockets_.find(client_fd) != client_sockets_.end();
+                        }
+                    }
+                }
+                // 스필 영역은 비워도 용량을 유지해 다음 경계 조각에 재사용
+                const bool incomplete = !spill.empty();
+                rx_carry_[client_fd] = std::move(spill);
+                if (incomplete) {
+                    return true;  // 이번 데이터는 모두 스필 영역으로 들어감
+                }
+                data += taken;
+                length -= taken;
+            }
+        }
+        
+        // 나머지는 수신 버퍼 안에서 바로 파싱
+        size_t offset = 0;
+        while (offset < length) {
+            FrameHeader header{};
+            const int parsed = parseClientHeader(data + offset, length - offset, header);
+            if (parsed < 0) {
+                LOG_ERROR("[Session ", session_id_, "] Invalid message header from client ", client_fd,
+                         ": first byte 0x", std::hex, static_cast<int>(data[offset]), std::dec);
+                handleClose(client_socket);
+                return false;
+            }
+            if (parsed == 0) {
+                break;  // 헤더가 다음 recv에서 완성됨
+            }
+            const size_t frame_size = header.size + header.length;
+            if (length - offset < frame_size) {
+                // 경계에 걸친 큰 프레임은 스필 영역에 복사하지 않고 페이로드가 든 버퍼 범위를 고정
+                // (시작 시 고정 예산을 확인했으므로 첫 범위는 항상 고정됨)
+                if (beginLargeFrame(client_fd, header, buffer_idx)) {
+                    offset += header.size;
+                    continueLargeFrame(client_socket, data + offset, length - offset, buffer_idx);
+                    return true;
+                }
+                break;  // 나머지는 다음 recv에서 완성됨
+            }
+            
+            processMessage(client_socket, header, data + offset + header.size, NO_RECV_BUFFER);
+            offset += frame_size;
+            
+            if (streamInterrupted(client_fd, data + offset, length - offset)) {
+                return client_sockets_.find(client_fd) != client_sockets_.end();
+            }
+        }
+        
+        // 처리 중 다른 항목이 추가되었을 수 있으므로 반복자 대신 다시 조회
+        rx_carry_[client_fd].assign(data + offset, data + length);
+    } catch (const std::exception& e) {
+        LOG_ERROR("[Session ", session_id_, "] Failed to process stream from client ", client_fd, ": ", e.what());
+        handleClose(client_socket);
+        return false;
+    }
+    return true;
+}
+
+bool Session::beginLargeFrame(int32_t client_fd, const FrameHeader& header, uint16_t buffer_idx) {
+    if (!header.v2 || header.type != MessageType::CLIENT_CHAT || header.length < LARGE_FRAME_MIN_PAYLOAD) {
+        return false;
+    }
+    // 번들이 아닌 증분/크기 클래스 버퍼와 이동해 온 바이트는 고정할 수 없으므로 스필 영역에 복사
+    if (buffer_idx == NO_RECV_BUFFER) {
+        ++stats_.large_frame_copies;
+        return false;
+    }
+    
+    // 고정한 버퍼는 전송이 끝나야 링으로 돌아오므로 그룹 상한의 절반까지만 고정해 다른 연결의 recv가 굶지 않게 함
+    // (시작과 끝 버퍼는 일부만 찰 수 있으므로 페이로드가 덮는 버퍼 수 + 2를 예약)
+    const UringBuffer& buffer_manager = io_ring_->getBufferManager();
+    const unsigned needed = header.length / buffer_manager.getBufferSize() + 2;
+    if (pinned_buffers_ + pin_reserved_ + needed > buffer_manager.getNumBuffers() / 2) {
+        ++stats_.large_frame_copies;
+        return false;
+    }
+    
+    LargeFrame& frame = large_frames_[client_fd];
+    frame = LargeFrame{};
+    frame.header = header;
+    frame.reserved = needed;
+    pin_reserved_ += needed;
+    return true;
+}
+
+size_t Session::continueLargeFrame(SocketPtr client_socket, const uint8_t* data, size_t length, uint16_t buffer_idx) {
+    const int32_t client_fd = client_socket->getSocketFd();
+    auto frame_it = large_frames_.find(client_fd);
+    LargeFrame& frame = frame_it->second;
+    auto& buffer_manager = io_ring_->getBufferManager();
+    
+    const size_t taken = std::min<size_t>(frame.header.length - frame.received, length);
+    if (taken > 0) {
+        if (buffer_idx == NO_RECV_BUFFER) {
+            throw std::runtime_error("고정할 수 없는 데이터로 큰 프레임을 이어 받을 수 없음");
+        }
+        // 작은 recv가 이어져 예약보다 많은 버퍼를 덮으면 지금까지의 범위를 스필 영역으로 복사해 고정을 풂
+        if (frame.segments.size() >= frame.reserved && pinned_buffers_ + pin_reserved_ >= buffer_manager.getNumBuffers() / 2) {
+            std::vector<uint8_t> spill(MAX_FRAME_HEADER_SIZE + frame.received);
+            size_t used = encodeFrameHeader(spill.data(), frame.header.type, frame.header.flags, frame.header.length, true);
+            for (const QueuedSend& segment : frame.segments) {
+                memcpy(spill.data() + used, buffer_manager.getBufferAddr(segment.id, buffer_manager.getBaseAddr()) + segment.begin,
+                       segment.len);
+                used += segment.len;
+                unpinRecvBuffer(segment.id);
+            }
+            spill.resize(used);
+            pin_reserved_ -= frame.reserved;
+            large_frames_.erase(frame_it);
+            rx_carry_[client_fd] = std::move(spill);
+            ++stats_.large_frame_copies;
+            return 0;
+        }
+        
+        const uint8_t* base = buffer_manager.getBufferAddr(buffer_idx, buffer_manager.getBaseAddr());
+        pinRecvBuffer(buffer_idx);
+        frame.segments.push_back(QueuedSend{SendSource::PINNED, buffer_idx, static_cast<unsigned>(taken), 0,
+                                            static_cast<unsigned>(data - base)});
+        frame.received += static_cast<unsigned>(taken);
+        ++stats_.large_frame_buffers;
+    }
+    
+    if (frame.received == frame.header.length) {
+        LargeFrame done = std::move(frame);
+        large_frames_.erase(frame_it);
+        pin_reserved_ -= done.reserved;
+        dispatchLargeFrame(client_socket, done);
+    }
+    return taken;
+}
+
+void Session::dispatchLargeFrame(SocketPtr client_socket, LargeFrame& frame) {
+    const int32_t client_fd = client_socket->getSocketFd();
+    v2_clients_.insert(client_fd);
+    ++stats_.v2_frames;
+    ++stats_.large_frames;
+    total_messages_++;
+    LOG_INFO("[Session ", session_id_, "] Received chat message from client ", client_fd,
+             ", length: ", frame.header.length, " (", frame.segments.size(), " pinned buffers)");
+    
+    auto room_it = client_rooms_.find(client_fd);
+    if (room_it != client_rooms_.end()) {
+        broadcastLargeFrame(client_fd, room_it->second, frame);
+    }
+    
+    // 응답 헤더만 송신 풀 슬롯에 쓰고 페이로드는 고정해 둔 recv 버퍼 범위를 그대로 iovec으로 보냄
+    SendBufferPool* send_pool = io_ring_->getSendPool();
+    int slot = send_pool->acquire();
+    if (slot < 0) {
+        reclaimSkipSends();
+        slot = send_pool->acquire();
+    }
+    if (slot < 0) {
+        ++stats_.pool_exhausted;
+        for (const QueuedSend& segment : frame.segments) {
+            unpinRecvBuffer(segment.id);
+        }
+        throw std::runtime_error("송신 버퍼 풀 부족");
+    }
+    const size_t header_size = encodeResponseHeader(send_pool->getSlotAddr(static_cast<uint16_t>(slot)), client_fd,
+                                                    MessageType::SERVER_ECHO, frame.header.flags, frame.header.length);
+    
+    if (outbound_.slot >= 0 && outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    auto& queue = send_queues_[client_fd];
+    pushQueued(queue, QueuedSend{SendSource::POOL, static_cast<uint16_t>(slot), static_cast<unsigned>(header_size)});
+    for (const QueuedSend& segment : frame.segments) {
+        pushQueued(queue, segment);
+    }
+    queue.entries.back().frames = 1;
+    ++queue.frames;
+    frame.segments.clear();
+    pumpSendQueue(client_fd, queue);
+}
+
+void Session::pinRecvBuffer(uint16_t buffer_idx) {
+    if (buffer_idx >= recv_pins_.size()) {
+        recv_pins_.resize(std::max<size_t>(io_ring_->getBufferManager().getNumBuffers(), buffer_idx + 1), 0);
+    }
+    if (recv_pins_[buffer_idx]++ == 0) {
+        io_ring_->getBufferManager().markSending(buffer_idx);
+        ++pinned_buffers_;
+    }
+}
+
+void Session::unpinRecvBuffer(uint16_t buffer_idx) {
+    if (buffer_idx >= recv_pins_.size() || recv_pins_[buffer_idx] == 0) {
+        LOG_ERROR("[Session ", session_id_, "] Unpinning recv buffer ", buffer_idx, " that is not pinned");
+        return;
+    }
+    if (--recv_pins_[buffer_idx] == 0) {
+        --pinned_buffers_;
+        io_ring_->releaseBuffer(buffer_idx);
+    }
+}
+
+void Session::finishRecvBuffer(uint16_t buffer_idx) {
+    // 큰 프레임이 고정했으면 SENDING, 처리 중 연결이 닫혀 고정이 모두 풀렸으면 이미 링에 반환됨
+    if (io_ring_->getBufferManager().getOwner(buffer_idx) == BufferOwner::PARSER) {
+        io_ring_->releaseBuffer(buffer_idx);
+    }
+}
+
+bool Session::streamInterrupted(int32_t client_fd, const uint8_t* rest, size_t rest_length) {
+    // LEAVE로 닫혔으면 남은 바이트는 버림
+    if (client_sockets_.find(client_fd) == client_sockets_.end()) {
+        return true;
+    }
+    // JOIN으로 이동이 시작되었으면 남은 바이트(다음 메시지와 조각)는 대상 세션이 처리
+    auto migration_it = migrations_.find(client_fd);
+    if (migration_it != migrations_.end()) {
+        migration_it->second.carry.assign(rest, rest + rest_length);
+        rx_carry_.erase(client_fd);
+        return true;
+    }
+    return false;
+}
+
+void Session::queueOutbound(int32_t client_fd, MessageType msg_type, const void* data, size_t length, uint8_t flags) {
+    if (!io_ring_->getSendPool()) {
+        throw std::runtime_error("수신 프레이머 응답에는 송신 버퍼 풀이 필요함");
+    }
+    if (outbound_.slot >= 0 && outbound_.client_fd != client_fd) {
+        flushOutbound();
+    }
+    
+    uint8_t header[MAX_FRAME_HEADER_SIZE];
+    const size_t header_size = encodeResponseHeader(header, client_fd, msg_type, flags, length);
+    appendOutbound(client_fd, header, header_size);
+    appendOutbound(client_fd, static_cast<const uint8_t*>(data), length);
+    ++outbound_.frames;
+    ++stats_.pool_sends;
+}
+
+void Session::appendOutbound(int32_t client_fd, const uint8_t* data, size_t length) {
+    SendBufferPool* send_pool = io_ring_->getSendPool();
+    while (length > 0) {
+        // 슬롯이 차면 다음 슬롯으로 넘어가 같은 전송에 이어 붙이고, 벡터가 가득 찼을 때만 내보냄
+        if (outbound_.slot >= 0 && outbound_.used == SendBufferPool::SLOT_SIZE) {
+            if (outbound_.count + 1 >= IOUring::MAX_SEND_VECTOR) {
+                flushOutbound();
+            } else {
+                outbound_.slots[outbound_.count] = static_cast<uint16_t>(outbound_.slot);
+                outbound_.lens[outbound_.count] = outbound_.used;
+                ++outbound_.count;
+                outbound_.slot = -1;
+                outbound_.used = 0;
+            }
+        }
+        
+        if (outbound_.slot < 0) {
+            int slot = send_pool->acquire();
+            if (slot < 0) {
+                reclaimSkipSends();
+                slot = send_pool->acquire();
+            }
+            if (slot < 0) {
+                ++stats_.pool_exhausted;
+                throw std::runtime_error("송신 버퍼 풀 부족");
+            }
+            outbound_.client_fd = client_fd;
+            outbound_.slot = slot;
+        }
+        
+        const size_t chunk = std::min<size_t>(length, SendBufferPool::SLOT_SIZE - outbound_.used);
+        memcpy(send_pool->getSlotAddr(static_cast<uint16_t>(outbound_.slot)) + outbound_.used, data, chunk);
+        outbound_.used += static_cast<unsigned>(chunk);
+        data += chunk;
+        length -= chunk;
+    }
+}
+
+size_t Session::encodeResponseHeader(uint8_t* out, int32_t client_fd, MessageType msg_type, uint8_t flags,
+                                     size_t length) const {
+    return encodeFrameHeader(out, msg_type, flags, static_cast<uint32_t>(length), v2_clients_.count(client_fd) > 0);
+}
+
+void Session::flushOutbound() {
+    if (outbound_.slot < 0) {
+        return;
+    }
+    
+    // 가득 차서 넘어간 슬롯부터 도착 순서대로 송신 큐에 넣음 (큐가 비어 있으면 슬롯 여러 개가 sendmsg 하나로 나감)
+    const OutboundBatch batch = outbound_;
+    outbound_ = OutboundBatch{};
+    auto& queue = send_queues_[batch.client_fd];
+    for (unsigned i = 0; i < batch.count; ++i) {
+        pushQueued(queue, QueuedSend{SendSource::POOL, batch.slots[i], batch.lens[i]});
+    }
+    QueuedSend last{SendSource::POOL, static_cast<uint16_t>(batch.slot), batch.used};
+    last.frames = batch.frames;
+    pushQueued(queue, last);
+    if (batch.frames > 1) {
+        stats_.coalesced_frames += batch.frames - 1;
+    }
+    pumpSendQueue(batch.client_fd, queue);
+}
+
+void Session::enqueueSend(int32_t client_fd, const QueuedSend& entry) {
+    // 같은 연결에 모아 둔 번들 응답이 먼저 만들어졌으므로 앞에 넣어 순서를 지킴
+    if (outbound_.slot >= 0 && outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    auto& queue = send_queues_[client_fd];
+    QueuedSend queued = entry;
+    queued.frames = 1;
+    pushQueued(queue, queued);
+    pumpSendQueue(client_fd, queue);
+}
+
+void Session::pumpSendQueue(int32_t client_fd, SendQueue& queue) {
+    // 같은 소켓에 전송 SQE 두 개가 동시에 있으면 먼저 poll 대기에 들어간 쪽이 나중에 끝나 순서가 뒤바뀔 수 있으므로
+    // 완료를 추적하는 전송은 연결마다 하나만 둠
+    updateFlowControl(client_fd, queue);
+    if (queue.entries.empty()) {
+        queue.skip_blocked = false;
+    }
+    if (queue.in_flight > 0) {
+        ++stats_.queued_sends;
+        return;
+    }
+    
+    while (!queue.entries.empty()) {
+        const QueuedSend& head = queue.entries.front();
+        if (queue.entries.size() == 1 && head.offset == 0 &&
+            (head.source == SendSource::POOL || head.source == SendSource::RECV)) {
+            if (head.source == SendSource::POOL) {
+                // skip 모드 전송도 성공이 확인될 때까지 진행 중으로 두어 순서와 큐 상한을 지킴
+                const bool skip = io_ring_->skipsSendSuccess() && !queue.skip_blocked;
+                io_ring_->prepareSendFromPool(client_fd, head.id, head.len, skip);
+                queue.in_flight_tag = sendTag(skip ? OperationType::SEND_SKIP : OperationType::WRITE_FIXED, head.id);
+            } else {
+                const OperationType op_type = io_ring_->wantsZeroCopy(head.len) ? OperationType::SEND_ZC : OperationType::WRITE;
+                io_ring_->prepareWrite(client_fd, queuedSendAddr(head), head.len, head.id);
+                queue.in_flight_tag = sendTag(op_type, head.id);
+            }
+            queue.in_flight = 1;
+            return;
+        }
+        
+        // 쌓인 응답(또는 짧은 전송의 남은 꼬리부터)을 iovec에 담아 sendmsg 한 번으로 전송
+        iovec iov[IOUring::MAX_SEND_VECTOR];
+        const unsigned count = static_cast<unsigned>(std::min<size_t>(queue.entries.size(), IOUring::MAX_SEND_VECTOR));
+        for (unsigned i = 0; i < count; ++i) {
+            const QueuedSend& entry = queue.entries[i];
+            iov[i].iov_base = const_cast<uint8_t*>(queuedSendAddr(entry)) + entry.offset;
+            iov[i].iov_len = entry.len - entry.offset;
+        }
+        const uint16_t record = io_ring_->prepareSendVector(client_fd, iov, count);
+        queue.in_flight_tag = sendTag(OperationType::SEND_VECTOR, record);
+        queue.in_flight = count;
+        ++stats_.vector_sends;
+        stats_.vector_slots += count;
+        return;
+    }
+}
+
+bool Session::completeQueuedSend(const Operation& ctx, int32_t res) {
+    const bool zero_copy = ctx.op_type == OperationType::SEND_ZC;
+    const uint32_t tag = sendTag(ctx.op_type, ctx.buffer_idx);
+    auto queue_it = send_queues_.find(ctx.client_fd);
+    if (queue_it == send_queues_.end() || queue_it->second.in_flight == 0 || queue_it->second.in_flight_tag != tag) {
+        // 연결이 닫힌 뒤 도착한 완료: 보관해 둔 항목을 반환 (같은 fd 번호의 새 연결은 건드리지 않음)
+        auto closed_it = closed_sends_.find(tag);
+        if (closed_it == closed_sends_.end()) {
+            LOG_ERROR("[Session ", session_id_, "] Unexpected send completion for client ", ctx.client_fd);
+            return true;
+        }
+        if (!zero_copy) {
+            for (const QueuedSend& entry : closed_it->second) {
+                releaseQueuedSend(entry);
+            }
+        }
+        closed_sends_.erase(closed_it);
+        return true;
+    }
+    
+    SendQueue& queue = queue_it->second;
+    unsigned in_flight = queue.in_flight;
+    queue.in_flight = 0;
+    if (zero_copy) {
+        // 제로 카피 버퍼는 알림 CQE에서 IOUring이 반환하므로 결과와 관계없이 큐에서만 뺌
+        // (MSG_WAITALL이라 일부만 나갔다면 나머지를 보낼 수 없는 실패)
+        const unsigned len = queue.entries.front().len;
+        popQueued(queue);
+        if (res < 0 || static_cast<unsigned>(res) < len) {
+            return false;
+        }
+        pumpSendQueue(ctx.client_fd, queue);
+        return true;
+    }
+    // 실패한 전송의 항목은 연결을 닫을 때 반환
+    if (res < 0) {
+        return false;
+    }
+    
+    // 앞쪽 항목부터 전송된 바이트만큼 반환하고, 일부만 나간 항목은 위치를 기록해 다음 전송에서 이어 보냄
+    unsigned sent = static_cast<unsigned>(res);
+    for (; in_flight > 0; --in_flight) {
+        QueuedSend& entry = queue.entries.front();
+        const unsigned remaining = entry.len - entry.offset;
+        if (sent < remaining) {
+            entry.offset += sent;
+            ++stats_.short_sends;
+            break;
+        }
+        sent -= remaining;
+        releaseQueuedSend(entry);
+        popQueued(queue);
+    }
+    pumpSendQueue(ctx.client_fd, queue);
+    return true;
+}
+
+void Session::reclaimSkipSends() {
+    if (!io_ring_->skipsSendSuccess()) {
+        return;
+    }
+    confirmed_sends_.clear();
+    io_ring_->takeConfirmedSends(confirmed_sends_);
+    for (const auto& [client_fd, slot] : confirmed_sends_) {
+        // 연결이 닫혔으면 closed_sends_에 보관된 항목을 반환하고, 아니면 항목 전체가 나간 것
+        const Operation ctx{client_fd, OperationType::SEND_SKIP, slot};
+        int32_t sent = 0;
+        auto queue_it = send_queues_.find(client_fd);
+        if (queue_it != send_queues_.end() && queue_it->second.in_flight > 0 &&
+            queue_it->second.in_flight_tag == sendTag(OperationType::SEND_SKIP, slot)) {
+            sent = static_cast<int32_t>(queue_it->second.entries.front().len);
+        }
+        completeQueuedSend(ctx, sent);
+    }
+}
+
+void Session::dropSendQueue(int32_t client_fd) {
+    auto queue_it = send_queues_.find(client_fd);
+    if (queue_it == send_queues_.end()) {
+        return;
+    }
+    
+    SendQueue& queue = queue_it->second;
+    const auto pending_begin = queue.entries.begin() + queue.in_flight;
+    if (queue.in_flight > 0) {
+        // 커널이 아직 참조하는 항목은 완료 CQE에서 태그로 찾아 반환
+        closed_sends_[queue.in_flight_tag].assign(queue.entries.begin(), pending_begin);
+    }
+    for (auto it = pending_begin; it != queue.entries.end(); ++it) {
+        releaseQueuedSend(*it);
+    }
+    send_queues_.erase(queue_it);
+}
+
+void Session::releaseQueuedSend(const QueuedSend& entry) {
+    switch (entry.source) {
+        case SendSource::POOL:
+            io_ring_->getSendPool()->release(entry.id);
+            break;
+        case SendSource::RECV:
+            io_ring_->releaseBuffer(entry.id);
+            break;
+        case SendSource::PINNED:
+            unpinRecvBuffer(entry.id);
+            break;
+        case SendSource::SHARED:
+            releaseSharedSlot(entry.id);
+            break;
+        case SendSource::HISTORY:
+            unpinHistory(entry.id);
+            break;
+    }
+}
+
+const uint8_t* Session::queuedSendAddr(const QueuedSend& entry) {
+    if (entry.source == SendSource::POOL || entry.source == SendSource::SHARED) {
+        return io_ring_->getSendPool()->getSlotAddr(entry.id) + entry.begin;
+    }
+    if (entry.source == SendSource::HISTORY) {
+        return history_pins_[entry.id].segment->data() + entry.begin;
+    }
+    auto& buffer_manager = io_ring_->getBufferManager();
+    return buffer_manager.getBufferAddr(entry.id, buffer_manager.getBaseAddr()) + entry.begin;
+}
+
+void Session::pushQueued(SendQueue& queue, const QueuedSend& entry) {
+    queue.entries.push_back(entry);
+    queue.bytes += entry.len;
+    queue.frames += entry.frames;
+}
+
+void Session::popQueued(SendQueue& queue) {
+    const QueuedSend& entry = queue.entries.front();
+    queue.bytes -= entry.len;
+    queue.frames -= entry.frames;
+    queue.mid_frame = entry.frames == 0;
+    queue.entries.pop_front();
+}
+
+bool Session::exceedsSendLimit(const SendQueue& queue, size_t extra_bytes, unsigned extra_frames) const {
+    return (send_queue_max_bytes_ > 0 && queue.bytes + extra_bytes > send_queue_max_bytes_) ||
+           (send_queue_max_frames_ > 0 && queue.frames + extra_frames > send_queue_max_frames_);
+}
+
+bool Session::admitBroadcast(int32_t client_fd, SendQueue& queue, size_t frame_bytes) {
+    switch (slow_consumer_) {
+        case SlowConsumerPolicy::DROP_OLDEST:
+            while (exceedsSendLimit(queue, frame_bytes, 1) && dropQueuedBroadcast(queue)) {
+                ++stats_.slow_dropped;
+            }
+            break;
+        case SlowConsumerPolicy::COALESCE:
+            // 새 프레임이 최신 상태이므로 아직 나가지 않은 이전 브로드캐스트는 모두 필요 없음
+            while (dropQueuedBroadcast(queue)) {
+                ++stats_.slow_coalesced;
+            }
+            break;
+        case SlowConsumerPolicy::DISCONNECT:
+            LOG_WARN("[Session ", session_id_, "] Client ", client_fd, " send queue full (", queue.bytes, " bytes, ",
+                     queue.frames, " frames), disconnecting slow consumer");
+            queue.closing = true;
+            slow_closes_.push_back(client_fd);
+            ++stats_.slow_disconnects;
+            return false;
+        case SlowConsumerPolicy::DROP_NEWEST:
+            break;
+    }
+    // 버릴 브로드캐스트가 없으면 (자기 응답으로 찬 큐) 새 프레임을 버림
+    if (exceedsSendLimit(queue, frame_bytes, 1)) {
+        ++stats_.slow_dropped;
+        return false;
+    }
+    return true;
+}
+
+bool Session::dropQueuedBroadcast(SendQueue& queue) {
+    // 커널이 보내는 중인 항목과, 그 항목에 걸쳐 일부만 나간 프레임의 나머지는 건너뜀
+    size_t index = queue.in_flight;
+    if (index == 0 && !queue.entries.empty() && queue.entries.front().offset > 0) {
+        index = 1;
+    }
+    const bool partial = index > 0 ? queue.entries[index - 1].frames == 0 : queue.mid_frame;
+    if (partial) {
+        while (index < queue.entries.size() && queue.entries[index].frames == 0) {
+            ++index;
+        }
+        ++index;
+    }
+    while (index < queue.entries.size() && !queue.entries[index].broadcast) {
+        ++index;
+    }
+    if (index >= queue.entries.size()) {
+        return false;
+    }
+    
+    // 브로드캐스트 프레임은 enqueueShared가 연속으로 넣으므로 frames가 표시된 항목까지가 한 프레임
+    size_t end = index;
+    while (end < queue.entries.size() && queue.entries[end].frames == 0) {
+        ++end;
+    }
+    end = std::min(end + 1, queue.entries.size());
+    for (size_t i = index; i < end; ++i) {
+        const QueuedSend& entry = queue.entries[i];
+        queue.bytes -= entry.len;
+        queue.frames -= entry.frames;
+        releaseQueuedSend(entry);
+    }
+    queue.entries.erase(queue.entries.begin() + index, queue.entries.begin() + end);
+    return true;
+}
+
+void Session::updateFlowControl(int32_t client_fd, const SendQueue& queue) {
+    if (send_queue_max_bytes_ == 0 && send_queue_max_frames_ == 0) {
+        return;
+    }
+    if (!paused_recvs_.count(client_fd)) {
+        if (exceedsSendLimit(queue, 1, 1) && !queue.closing) {
+            pauseRecv(client_fd);
+        }
+        return;
+    }
+    // 멈추고 바로 다시 여는 것을 반복하지 않도록 상한의 절반 아래로 줄었을 때 재개
+    if ((send_queue_max_bytes_ == 0 || queue.bytes <= send_queue_max_bytes_ / 2) &&
+        (send_queue_max_frames_ == 0 || queue.frames <= send_queue_max_frames_ / 2)) {
+        resumeRecv(client_fd);
+    }
+}
+
+void Session::pauseRecv(int32_t client_fd) {
+    if (!paused_recvs_.emplace(client_fd, false).second) {
+        return;
+    }
+    ++stats_.flow_pauses;
+    LOG_DEBUG("[Session ", session_id_, "] Send queue of client ", client_fd, " is full, pausing recv");
+    
+    // 읽지 않으면 소켓 수신 버퍼가 차고 TCP 윈도우가 닫혀 상대가 보내는 속도가 늦춰짐
+    // (멀티샷 recv는 -ECANCELED로 끝나고 armRecv가 재등록을 미룸, 이미 끝났으면 취소는 실패 CQE만 남김)
+    unsigned recv_class = io_ring_->getDefaultRecvClass();
+    auto state_it = recv_class_state_.find(client_fd);
+    if (state_it != recv_class_state_.end()) {
+        recv_class = state_it->second.current;
+    }
+    io_ring_->prepareCancelRead(client_fd, recv_class);
+}
+
+void Session::resumeRecv(int32_t client_fd) {
+    auto paused_it = paused_recvs_.find(client_fd);
+    if (paused_it == paused_recvs_.end()) {
+        return;
+    }
+    const bool recv_stopped = paused_it->second;
+    paused_recvs_.erase(paused_it);
+    ++stats_.flow_resumes;
+    LOG_DEBUG("[Session ", session_id_, "] Send queue of client ", client_fd, " drained, resuming recv");
+    
+    // 취소가 아직 반영되지 않았으면 -ECANCELED CQE에서 다시 등록됨
+    if (recv_stopped) {
+        armRecv(client_fd);
+    }
+}
+
+void Session::closeSlowConsumers() {
+    if (slow_closes_.empty()) {
+        return;
+    }
+    std::vector<int32_t> closes;
+    closes.swap(slow_closes_);
+    for (const int32_t client_fd : closes) {
+        auto it = client_sockets_.find(client_fd);
+        if (it != client_sockets_.end()) {
+            handleClose(it->second);
+        }
+    }
+}
+
+void Session::handleWrite(io_uring_cqe* cqe, const Operation& ctx) {
+    // recv 버퍼는 송신 큐가 모두 전송한 뒤(또는 연결을 닫을 때) 링에 반환
+    if (!completeQueuedSend(ctx, cqe->res)) {
+        closeAfterSendFailure(ctx.client_fd, cqe->res, "Write");
+    }
+}
+
+void Session::handleSendZc(io_uring_cqe* cqe, const Operation& ctx) {
+    if (io_ring_->handleSendZcComplete(cqe, ctx.buffer_idx)) {
+        ++stats_.zc_notifs;
+        return;
+    }
+    
+    // 알림 CQE는 버퍼 반환용이므로 전송 완료는 첫 CQE로 판단
+    if (completeQueuedSend(ctx, cqe->res)) {
+        ++stats_.zc_sends;
+        return;
+    }
+    closeAfterSendFailure(ctx.client_fd, cqe->res, "Zero-copy send");
+}
+
+void Session::handlePoolSend(io_uring_cqe* cqe, const Operation& ctx) {
+    // skip 모드 전송은 실패했을 때만 CQE가 옴 (MSG_WAITALL이라 일부만 나간 경우도 보낸 바이트 수로 옴)
+    if (ctx.op_type == OperationType::SEND_SKIP) {
+        io_ring_->discardSkipSend(ctx.buffer_idx);
+        if (cqe->res == -EAGAIN || cqe->res >= 0) {
+            // 송신 버퍼가 가득 찬 느린 연결: 남은 꼬리를 큐에 두고 완료를 받는 전송으로 이어 보냄
+            auto queue_it = send_queues_.find(ctx.client_fd);
+            if (queue_it != send_queues_.end()) {
+                queue_it->second.skip_blocked = true;
+            }
+            ++stats_.skip_send_retries;
+            completeQueuedSend(ctx, std::max<int32_t>(cqe->res, 0));
+            return;
+        }
+        ++stats_.pool_send_errors;
+        if (!completeQueuedSend(ctx, cqe->res)) {
+            closeAfterSendFailure(ctx.client_fd, cqe->res, "Pooled send");
+        }
+        return;
+    }
+    
+    const bool ok = completeQueuedSend(ctx, cqe->res);
+    if (ctx.op_type == OperationType::SEND_VECTOR) {
+        io_ring_->releaseSendVector(ctx.buffer_idx);
+    }
+    if (!ok) {
+        ++stats_.pool_send_errors;
+        closeAfterSendFailure(ctx.client_fd, cqe->res, "Pooled send");
+    }
+}
+
+void Session::closeAfterSendFailure(int32_t client_fd, int32_t res, const char* what) {
+    if (res < 0 && res != -EAGAIN && res != -EBADF && res != -ECONNRESET && res != -EPIPE) {
+        LOG_ERROR("[Session ", session_id_, "] ", what, " failed for client ", client_fd, ": ", -res);
+    } else if (res >= 0) {
+        LOG_WARN("[Session ", session_id_, "] ", what, " for client ", client_fd, " stopped after ", res, " bytes");
+    }
+    // 실패한 응답 뒤의 응답을 보내면 스트림이 어긋나므로 연결을 닫음
+    auto it = client_sockets_.find(client_fd);
+    if (it != client_sockets_.end()) {
+        handleClose(it->second);
+    }
+}
+
+void Session::handleWakeup(io_uring_cqe* cqe) {
+    // eventfd 카운터를 비워 다음 신호에서 다시 폴링 이벤트가 발생하도록 함
+    uint64_t value = 0;
+    if (read(wakeup_fd_, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        LOG_ERROR("[Session ", session_id_, "] Failed to read wakeup eventfd: ", strerror(errno));
+    }
+    
+    drainPendingClients();
+    drainRoomInbox();
+    
+    // 멀티샷 폴링이 종료되었으면 다시 등록
+    if (!(cqe->flags & IORING_CQE_F_MORE)) {
+        io_ring_->prepareWakeup(wakeup_fd_);
+    }
+}
+
+void Session::handleReceivedFd(io_uring_cqe* cqe) {
+    // Listener가 IORING_OP_MSG_RING으로 전달한 고정 파일: res는 이 링에서 할당된 슬롯 번호
+    // (설치 실패는 송신 측 CQE로만 보고되므로 여기서는 항상 성공)
+    const int slot = cqe->res;
+    FixedFileTable* file_table = io_ring_->getFileTable();
+    if (!file_table) {
+        LOG_ERROR("[Session ", session_id_, "] Received fixed file ", slot, " without a file table");
+        return;
+    }
+    
+    if (!file_table->commit(static_cast<unsigned>(slot))) {
+        return;
+    }
+    
+    // 슬롯은 io_uring이 close_direct로 닫으므로 Socket은 소유권을 갖지 않음
+    registerClient(std::make_shared<Socket>(slot, false));
+}
+
+void Session::handleReceivedClient(io_uring_cqe* cqe) {
+    // Listener가 IORING_OP_MSG_RING으로 전달한 일반 fd: res가 accept된 fd 번호
+    // fd는 handleClose의 close SQE로만 닫으므로 Socket은 소유권을 갖지 않음
+    registerClient(std::make_shared<Socket>(cqe->res, false));
+}
+
+void Session::handleAccept(io_uring_cqe* cqe) {
+    if (cqe->res < 0) {
+        ++stats_.accept_errors;
+        LOG_ERROR("[Session ", session_id_, "] Accept failed: ", -cqe->res);
+    } else if (FixedFileTable* file_table = io_ring_->getFileTable()) {
+        // accept_direct는 이 링의 고정 파일 테이블에 바로 설치하므로 전달 없이 등록
+        const unsigned slot = static_cast<unsigned>(cqe->res);
+        if (file_table->commit(slot, false)) {
+            ++stats_.accepts;
+            registerClient(std::make_shared<Socket>(static_cast<int>(slot), false));
+        }
+    } else {
+        const int client_fd = cqe->res;
+        auto client_socket = std::make_shared<Socket>(client_fd, false);
+        if (!client_socket->setNonBlocking(true)) {
+            LOG_ERROR("[Session ", session_id_, "] Failed to set non-blocking mode for client ", client_fd);
+            io_ring_->prepareClose(client_fd);
+        } else {
+            ++stats_.accepts;
+            registerClient(std::move(client_socket));
+        }
+    }
+    
+    // 멀티샷 accept가 종료된 경우에만 다시 등록
+    if (!(cqe->flags & IORING_CQE_F_MORE) && listening_socket_ && listening_socket_->isValid()) {
+        io_ring_->prepareAccept(listening_socket_->getSocketFd());
+    }
+}
+
+void Session::handleCloseComplete(io_uring_cqe* cqe, const Operation& ctx) {
+    if (cqe->res < 0 && cqe->res != -EBADF) {
+        LOG_ERROR("[Session ", session_id_, "] Close failed for client ", ctx.client_fd, ": ", -cqe->res);
+    }
+    
+    if (FixedFileTable* file_table = io_ring_->getFileTable()) {
+        file_table->release(static_cast<unsigned>(ctx.client_fd));
+    }
+}
+
+void Session::handleClose(SocketPtr client_socket) {
+    if (!client_socket || !client_socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to close invalid client socket");
+        return;
+    }
+    
+    int32_t client_fd = client_socket->getSocketFd();
+    LOG_INFO("[Session ", session_id_, "] Closing connection for client ", client_fd);
+    
+    // 이 클라이언트에 쌓인 번들 응답은 close보다 먼저 제출
+    if (outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    
+    // 세션에서 클라이언트 제거
+    removeClient(client_socket);
+    
+    // 소켓 닫기 작업 예약
+    if (io_ring_) {
+        io_ring_->prepareClose(client_fd);
+    }
+}
+
+void Session::onClientJoinSession(SocketPtr client_socket, int32_t target_session_id, int32_t room_id) {
+    if (!client_socket || !client_socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to move invalid client socket");
+        throw std::runtime_error("Invalid client socket");
+    }
+    
+    int32_t client_fd = client_socket->getSocketFd();
+    LOG_DEBUG("[Session ", session_id_, "] Processing session join request from client ", client_fd, 
+             " to session ", target_session_id);
+    
+    if (migrations_.count(client_fd)) {
+        throw std::runtime_error("이미 다른 세션으로 이동 중");
+    }
+    if (!SessionManager::getInstance().getSessionByIndex(target_session_id)) {
+        throw std::runtime_error("요청한 세션을 찾을 수 없음");
+    }
+    
+    // 연결은 이 워커가 계속 소유하다가 recv가 끝나고 전송이 모두 완료된 배치 끝에서 넘김
+    // (대상 워커가 등록하기 전까지 두 링이 같은 fd에서 recv하거나 응답 순서가 뒤바뀌지 않음)
+    Migration& migration = migrations_[client_fd];
+    migration.target_session = target_session_id;
+    migration.room = room_id;
+    // 이동을 시작하면 방 메시지는 더 받지 않음 (대상 세션에 등록될 때 참가)
+    leaveRoom(client_fd);
+    
+    // 1) 이 링의 멀티샷 recv를 끝냄: 버퍼 부족으로 미뤄 둔 recv는 등록되어 있지 않으므로 대기열에서만 제거
+    auto starved_it = std::find(starved_recvs_.begin(), starved_recvs_.end(), client_fd);
+    if (starved_it != starved_recvs_.end()) {
+        starved_recvs_.erase(starved_it);
+        migration.recv_done = true;
+    } else {
+        unsigned recv_class = io_ring_->getDefaultRecvClass();
+        bool cancel_pending = false;
+        auto state_it = recv_class_state_.find(client_fd);
+        if (state_it != recv_class_state_.end()) {
+            recv_class = state_it->second.current;
+            cancel_pending = state_it->second.cancelling;
+            state_it->second.cancelling = true;
+        }
+        // fd 단위 취소(cancel_fd)는 진행 중인 전송까지 취소하므로 recv의 user_data로 대상을 지정
+        if (!cancel_pending) {
+            io_ring_->prepareCancelRead(client_fd, recv_class);
+        }
+    }
+    
+    // 2) 이 연결에 모아 둔 응답은 지금 제출하고 완료 CQE를 기다림
+    if (outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    
+    LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " migrating to session ", target_session_id);
+}
+
+void Session::completeMigrations() {
+    if (migrations_.empty()) {
+        return;
+    }
+    
+    // 넘기는 동안 migrations_가 바뀌므로 대상 fd를 먼저 모음
+    std::vector<int32_t> ready;
+    for (const auto& migration_pair : migrations_) {
+        if (migration_pair.second.recv_done) {
+            ready.push_back(migration_pair.first);
+        }
+    }
+    for (int32_t client_fd : ready) {
+        tryCompleteMigration(client_fd);
+    }
+}
+
+void Session::tryCompleteMigration(int32_t client_fd) {
+    auto migration_it = migrations_.find(client_fd);
+    if (migration_it == migrations_.end() || !migration_it->second.recv_done) {
+        return;
+    }
+    if (outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    // 3) 송신 큐에 진행 중이거나 차례를 기다리는 응답이 남아 있으면 다음 배치에서 다시 확인
+    auto queue_it = send_queues_.find(client_fd);
+    if (queue_it != send_queues_.end() && (queue_it->second.in_flight > 0 || !queue_it->second.entries.empty())) {
+        return;
+    }
+    
+    auto socket_it = client_sockets_.find(client_fd);
+    if (socket_it == client_sockets_.end()) {
+        migrations_.erase(migration_it);
+        return;
+    }
+    
+    const int32_t target_session_id = migration_it->second.target_session;
+    auto target_session = SessionManager::getInstance().getSessionByIndex(target_session_id);
+    if (!target_session) {
+        LOG_ERROR("[Session ", session_id_, "] Migration target session ", target_session_id, " disappeared");
+        handleClose(socket_it->second);
+        return;
+    }
+    
+    MigratedClient client;
+    client.socket = socket_it->second;
+    client.carry = std::move(migration_it->second.carry);
+    auto state_it = recv_class_state_.find(client_fd);
+    if (state_it != recv_class_state_.end()) {
+        client.recv_class = state_it->second.target;
+    }
+    client.protocol_v2 = v2_clients_.count(client_fd) > 0;
+    client.room = migration_it->second.room;
+    
+    // 고정 파일 슬롯은 이 링에서만 유효하므로 대상 링의 테이블에 새 슬롯으로 설치해 넘김
+    if (io_ring_->usesFixedFiles()) {
+        handOffDirectClient(target_session, std::move(client));
+        return;
+    }
+    
+    stats_.migration_carry_bytes += client.carry.size();
+    ++stats_.migrations_out;
+    
+    // 4) 이 세션의 상태를 모두 지우고 대상 세션의 대기열에 넣은 뒤 대상 링에 알림 CQE를 올림
+    removeClient(client.socket);
+    target_session->addClient(std::move(client));
+    io_ring_->prepareSendMigration(target_session->getIOUring()->getRingFd(), client_fd,
+                                   static_cast<uint16_t>(target_session_id));
+    
+    LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " handed over to session ", target_session_id);
+}
+
+void Session::handOffDirectClient(const std::shared_ptr<Session>& target_session, MigratedClient client) {
+    const int32_t slot = client.socket->getSocketFd();
+    const int32_t target_session_id = target_session->getSessionId();
+    removeClient(client.socket);
+    
+    // 대상 테이블에 자리가 없으면 MSG_RING 설치가 -ENFILE로 실패하므로 미리 예약하고, 안 되면 이 세션에 남김
+    FixedFileTable* target_table = target_session->getIOUring()->getFileTable();
+    if (!target_table || !target_table->reserve()) {
+        LOG_WARN("[Session ", session_id_, "] Session ", target_session_id, " file table is full, keeping client ",
+                 slot);
+        ++stats_.migration_fd_failures;
+        adoptClient(client);
+        return;
+    }
+    
+    // 4) 연결 상태는 대상 세션에 티켓으로 보관하고, 대상 링은 RECV_MIGRATION_FD CQE의 새 슬롯으로 등록
+    // 원본 슬롯은 전달이 끝난 SEND_FD CQE에서 close_direct로 닫음
+    OutgoingFd& outgoing = outgoing_fds_[slot];
+    outgoing.carry_bytes = client.carry.size();
+    outgoing.ticket = target_session->addDirectClient(std::move(client));
+    io_ring_->prepareSendFd(target_session->getIOUring()->getRingFd(), static_cast<unsigned>(slot),
+                            makeContext(OperationType::RECV_MIGRATION_FD, static_cast<int32_t>(outgoing.ticket), 0),
+                            static_cast<uint16_t>(target_session_id));
+    
+    LOG_DEBUG("[Session ", session_id_, "] Client slot ", slot, " passed to session ", target_session_id);
+}
+
+void Session::handleSendFdComplete(io_uring_cqe* cqe, const Operation& ctx) {
+    const int32_t slot = ctx.client_fd;
+    auto outgoing_it = outgoing_fds_.find(slot);
+    if (outgoing_it == outgoing_fds_.end()) {
+        LOG_ERROR("[Session ", session_id_, "] Unknown fixed file hand-off completion for slot ", slot);
+        return;
+    }
+    const OutgoingFd outgoing = outgoing_it->second;
+    outgoing_fds_.erase(outgoing_it);
+    
+    if (cqe->res >= 0) {
+        // 대상 링이 자체 참조를 가지므로 이 링의 슬롯은 닫음 (슬롯은 close 완료 CQE에서 반환)
+        stats_.migration_carry_bytes += outgoing.carry_bytes;
+        ++stats_.migrations_out;
+        io_ring_->prepareClose(slot);
+        return;
+    }
+    
+    // 설치에 실패하면 대상 링에는 CQE가 오지 않으므로 보관한 연결을 되찾아 원본 슬롯으로 계속 서비스
+    LOG_WARN("[Session ", session_id_, "] Failed to pass slot ", slot, " to session ", ctx.buffer_idx, ": ",
+             -cqe->res, ", keeping client");
+    ++stats_.migration_fd_failures;
+    MigratedClient client;
+    auto target_session = SessionManager::getInstance().getSessionByIndex(ctx.buffer_idx);
+    if (!target_session || !target_session->takeDirectClient(outgoing.ticket, client)) {
+        io_ring_->prepareClose(slot);
+        return;
+    }
+    target_session->getIOUring()->getFileTable()->unreserve();
+    adoptClient(client);
+}
+
+void Session::handleReceivedMigrationFd(io_uring_cqe* cqe, const Operation& ctx) {
+    // 다른 세션이 IORING_OP_MSG_RING으로 넘긴 고정 파일: res는 이 링에서 할당된 슬롯 번호
+    const unsigned slot = static_cast<unsigned>(cqe->res);
+    FixedFileTable* file_table = io_ring_->getFileTable();
+    if (!file_table || !file_table->commit(slot)) {
+        LOG_ERROR("[Session ", session_id_, "] Received migrated fixed file ", slot, " without a file table slot");
+        return;
+    }
+    
+    MigratedClient client;
+    if (!takeDirectClient(static_cast<uint32_t>(ctx.client_fd), client)) {
+        LOG_ERROR("[Session ", session_id_, "] No migrated client for ticket ", static_cast<uint32_t>(ctx.client_fd));
+        io_ring_->prepareClose(static_cast<int>(slot));
+        return;
+    }
+    // 소스 링의 슬롯 번호 대신 이 링의 슬롯으로 등록 (Socket은 소유권을 갖지 않음)
+    client.socket = std::make_shared<Socket>(static_cast<int>(slot), false);
+    adoptClient(client);
+    ++stats_.migrations_in;
+}
+
+void Session::handleSendRoomFailed(io_uring_cqe* cqe, const Operation& ctx) {
+    // 메시지는 이미 대상 세션의 수신함에 있으므로 eventfd로 깨워 처리하게 함
+    LOG_WARN("[Session ", session_id_, "] Room inbox notice to session ", ctx.buffer_idx, " failed: ", -cqe->res,
+             ", falling back to wakeup");
+    if (auto target_session = SessionManager::getInstance().getSessionByIndex(ctx.buffer_idx)) {
+        target_session->wakeup();
+    }
+}
+
+void Session::handleHistorySync(io_uring_cqe* cqe, const Operation& ctx) {
+    auto sync_it = history_syncs_.find(ctx.buffer_idx);
+    if (sync_it == history_syncs_.end()) {
+        LOG_ERROR("[Session ", session_id_, "] Unknown history sync completion ", ctx.buffer_idx);
+        return;
+    }
+    HistorySync sync = std::move(sync_it->second);
+    history_syncs_.erase(sync_it);
+    
+    const bool ok = cqe->res >= 0;
+    if (!ok) {
+        ++stats_.history_sync_errors;
+        LOG_ERROR("[Session ", session_id_, "] History segment ", sync.segment->sequence(), " fdatasync failed: ",
+                  strerror(-cqe->res));
+    }
+    // 동기화하는 동안 더 기록되었으면 (다른 세션의 기록 포함) 이번 배치 끝에 다시 동기화
+    if (sync.segment->endSync(sync.target, ok)) {
+        history_dirty_.push_back(std::move(sync.segment));
+    }
+}
+
+void Session::handleSendMigrationFailed(io_uring_cqe* cqe, const Operation& ctx) {
+    // 연결은 이미 대상 세션의 대기열에 있으므로 eventfd로 깨워 가져가게 함
+    LOG_WARN("[Session ", session_id_, "] Migration notice for client ", ctx.client_fd, " to session ",
+             ctx.buffer_idx, " failed: ", -cqe->res, ", falling back to wakeup");
+    if (auto target_session = SessionManager::getInstance().getSessionByIndex(ctx.buffer_idx)) {
+        target_session->wakeup();
+    }
+}
+
+void Session::sendMessage(SocketPtr client_socket, MessageType msg_type, const void* data, size_t length, uint16_t buffer_idx,
+                          uint8_t flags) {
+    if (!client_socket || !client_socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to send message to invalid client socket");
+        throw std::runtime_error("Invalid client socket");
+    }
+    
+    int32_t client_fd = client_socket->getSocketFd();
+    try {
+        const bool v2 = v2_clients_.count(client_fd) > 0;
+        if (length > (v2 ? MAX_V2_MESSAGE_SIZE : MAX_MESSAGE_SIZE)) {
+            throw std::runtime_error("메시지 크기 초과");
+        }
+        if (!io_ring_) {
+            LOG_ERROR("[Session ", session_id_, "] IOUring is null in sendMessage");
+            return;
+        }
+        
+        // 번들 recv에서 온 메시지: 같은 클라이언트의 응답을 송신 풀 슬롯에 모아 한 번에 전송
+        if (buffer_idx == NO_RECV_BUFFER) {
+            queueOutbound(client_fd, msg_type, data, length, flags);
+            return;
+        }
+        
+        // 실제 메시지 크기만큼만 전송 (연결의 프로토콜 버전에 맞는 헤더 + 페이로드)
+        uint8_t header[MAX_FRAME_HEADER_SIZE];
+        const size_t header_size = encodeResponseHeader(header, client_fd, msg_type, flags, length);
+        const size_t total_size = header_size + length;
+        
+        // 송신 풀이 있으면 응답을 풀 슬롯에 만들고 recv 버퍼는 바로 링에 돌려줌
+        // (제로 카피 대상인 큰 응답은 복사하지 않도록 recv 버퍼 경로 유지)
+        SendBufferPool* send_pool = io_ring_->getSendPool();
+        if (send_pool && total_size <= SendBufferPool::SLOT_SIZE &&
+            !io_ring_->wantsZeroCopy(static_cast<unsigned>(total_size))) {
+            int slot = send_pool->acquire();
+            if (slot < 0) {
+                reclaimSkipSends();
+                slot = send_pool->acquire();
+            }
+            if (slot >= 0) {
+                uint8_t* pooled = send_pool->getSlotAddr(static_cast<uint16_t>(slot));
+                memcpy(pooled, header, header_size);
+                memcpy(pooled + header_size, data, length);
+                io_ring_->releaseBuffer(buffer_idx);
+                enqueueSend(client_fd, QueuedSend{SendSource::POOL, static_cast<uint16_t>(slot), static_cast<unsigned>(total_size)});
+                ++stats_.pool_sends;
+                LOG_DEBUG("[Session ", session_id_, "] Sending message type ", static_cast<int>(msg_type),
+                         " to client ", client_fd, " from send pool slot ", slot, ", length: ", length);
+                return;
+            }
+            // 풀이 바닥나면 recv 버퍼를 재활용하는 경로로 대체
+            ++stats_.pool_exhausted;
+        }
+        
+        // 수신된 버퍼 재활용: 페이로드를 헤더 뒤로 옮기고 헤더를 버퍼 앞에 기록 (에코는 이미 제자리)
+        auto& buffer_manager = io_ring_->getBufferManager();
+        uint8_t* message = buffer_manager.getBufferAddr(buffer_idx, buffer_manager.getBaseAddr());
+        if (!message) {
+            throw std::runtime_error("잘못된 버퍼 인덱스");
+        }
+        if (total_size > buffer_manager.getBufferSize()) {
+            throw std::runtime_error("응답이 recv 버퍼보다 큼");
+        }
+        memmove(message + header_size, data, length);
+        memcpy(message, header, header_size);
+        
+        buffer_manager.markSending(buffer_idx);
+        enqueueSend(client_fd, QueuedSend{SendSource::RECV, buffer_idx, static_cast<unsigned>(total_size)});
+        LOG_DEBUG("[Session ", session_id_, "] Sending message type ", static_cast<int>(msg_type),
+                 " to client ", client_fd, ", length: ", length);
+    }
+    catch (const std::exception& e) {
+        LOG_ERROR("[Session ", session_id_, "] Send failed: ", e.what());
+        throw;
+    }
+}
+
+void Session::processMessage(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx) {
+    if (!client_socket || !client_socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to process message from invalid client socket");
+        return;
+    }
+    
+    int32_t client_fd = client_socket->getSocketFd();
+    LOG_DEBUG("[Session ", session_id_, "] Processing message type ", static_cast<int>(header.type), 
               " from client ", client_fd);
+    
+    // v2 프레임을 보낸 연결은 이후 응답도 v2로 보냄
+    if (header.v2) {
+        v2_clients_.insert(client_fd);
+        ++stats_.v2_frames;
+    }
               
-    switch (message->header.type) {
+    switch (header.type) {
         case MessageType::CLIENT_JOIN:
-            handleJoinSession(client_socket, message, buffer_idx);
+            handleJoinSession(client_socket, header, payload, buffer_idx);
             break;
         case MessageType::CLIENT_LEAVE:
-            handleLeaveSession(client_socket, message, buffer_idx);
+            handleLeaveSession(client_socket, header, payload, buffer_idx);
             break;
         case MessageType::CLIENT_CHAT:
-            handleChatMessage(client_socket, message, buffer_idx);
+            handleChatMessage(client_socket, header, payload, buffer_idx);
+            break;
+        case MessageType::CLIENT_COMMAND:
+            handleCommand(client_socket, header, payload, buffer_idx);
             break;
         default:
-            LOG_ERROR("[Session ", session_id_, "] Unknown message type: ", static_cast<int>(message->header.type));
+            LOG_ERROR("[Session ", session_id_, "] Unknown message type: ", static_cast<int>(header.type));
             break;
     }
     
     total_messages_++;
 }
 
-void Session::handleJoinSession(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx) {
+void Session::handleJoinSession(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx) {
     if (!client_socket || !client_socket->isValid()) {
         LOG_ERROR("[Session ", session_id_, "] Attempted to process JOIN from invalid client socket");
         return;
@@ -429,42 +2240,58 @@ void Session::handleJoinSession(SocketPtr client_socket, const ChatMessage* mess
     int32_t client_fd = client_socket->getSocketFd();
     LOG_DEBUG("[Session ", session_id_, "] Processing JOIN request from client ", client_fd);
     
-    if (!message || message->header.length < sizeof(int32_t)) {
+    if (!payload || header.length < sizeof(int32_t)) {
         LOG_ERROR("[Session ", session_id_, "] Invalid JOIN message format");
         return;
     }
 
-    const int32_t* session_id_ptr = reinterpret_cast<const int32_t*>(message->data);
-    int32_t requested_session_id = *session_id_ptr;
+    // 페이로드는 방 번호 (세션 스레드와 무관, 음수는 사용하지 않음)
+    int32_t room_id;
+    memcpy(&room_id, payload, sizeof(room_id));
     
-    LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " requesting to join session ", requested_session_id);
+    LOG_DEBUG("[Session ", session_id_, "] Client ", client_fd, " requesting to join room ", room_id);
     
     try {
-        // 현재 세션과 요청한 세션이 동일하면 그대로 유지
-        if (requested_session_id == session_id_) {
-            std::stringstream ss;
-            ss << "Already in session " << session_id_;
-            std::string msg = ss.str();
-            sendMessage(client_socket, MessageType::SERVER_ACK, msg.c_str(), msg.length(), buffer_idx);
-            return;
+        if (room_id < 0) {
+            throw std::runtime_error("잘못된 방 번호");
         }
         
-        // 세션 이동 처리
-        onClientJoinSession(client_socket, requested_session_id);
+        // --room-affinity: 방의 홈 세션으로 연결을 옮기고 대상 세션에 등록될 때 참가 (성공 메시지는 보내지 않음)
+        const auto& sessions = SessionManager::getInstance().getAvailableSessions();
+        const int32_t home_session = static_cast<int32_t>(room_id % static_cast<int32_t>(sessions.size()));
+        if (room_affinity_ && home_session != session_id_) {
+            onClientJoinSession(client_socket, home_session, room_id);
+            return;
+        }
         
-        // 성공 메시지는 이동된 세션에서 보내지 않음 (클라이언트가 이미 이동됨)
+        std::stringstream ss;
+        auto room_it = client_rooms_.find(client_fd);
+        const bool joined = room_it == client_rooms_.end() || room_it->second != room_id;
+        if (!joined) {
+            ss << "Already in room " << room_id;
+        } else {
+            joinRoom(client_fd, room_id);
+            ss << "Joined room " << room_id;
+        }
+        std::string msg = ss.str();
+        sendMessage(client_socket, MessageType::SERVER_ACK, msg.c_str(), msg.length(), buffer_idx);
+        // 참가 응답 뒤에 방의 최근 메시지를 이어 보냄
+        if (joined) {
+            replayHistory(client_fd, room_id);
+        }
     }
     catch (const std::exception& e) {
-        LOG_ERROR("[Session ", session_id_, "] Error joining session: ", e.what());
+        LOG_ERROR("[Session ", session_id_, "] Error joining room: ", e.what());
         
         std::stringstream ss;
-        ss << "Failed to join session: " << e.what();
+        ss << "Failed to join room: " << e.what();
         std::string error_message = ss.str();
         sendMessage(client_socket, MessageType::SERVER_ERROR, error_message.c_str(), error_message.length(), buffer_idx);
     }
 }
 
-void Session::handleLeaveSession(SocketPtr client_socket, const ChatMessage* /* message */, uint16_t /* buffer_idx */) {
+void Session::handleLeaveSession(SocketPtr client_socket, const FrameHeader& /* header */, const uint8_t* /* payload */,
+                                 uint16_t /* buffer_idx */) {
     if (!client_socket || !client_socket->isValid()) {
         LOG_ERROR("[Session ", session_id_, "] Attempted to process LEAVE from invalid client socket");
         return;
@@ -475,7 +2302,7 @@ void Session::handleLeaveSession(SocketPtr client_socket, const ChatMessage* /*
     handleClose(client_socket);
 }
 
-void Session::handleChatMessage(SocketPtr client_socket, const ChatMessage* message, uint16_t buffer_idx) {
+void Session::handleChatMessage(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx) {
     if (!client_socket || !client_socket->isValid()) {
         LOG_ERROR("[Session ", session_id_, "] Attempted to process CHAT from invalid client socket");
         return;
@@ -483,20 +2310,780 @@ void Session::handleChatMessage(SocketPtr client_socket, const ChatMessage* mess
     
     int32_t client_fd = client_socket->getSocketFd();
     
-    if (!message || message->header.length == 0 || message->header.length > MAX_MESSAGE_SIZE) {
+    if (!payload || header.length == 0 || header.length > (header.v2 ? MAX_V2_MESSAGE_SIZE : MAX_MESSAGE_SIZE)) {
         LOG_WARN("[Session ", session_id_, "] Invalid message length from client ", client_fd);
         return;
     }
     
     // 메시지 수신 로그
     LOG_INFO("[Session ", session_id_, "] Received chat message from client ", client_fd, 
-             ", length: ", message->header.length);
+             ", length: ", header.length);
+    
+    // 방 멤버에게 먼저 전달 (에코가 recv 버퍼를 링에 돌려주거나 페이로드를 옮기기 전에 공유 프레임으로 복사)
+    auto room_it = client_rooms_.find(client_fd);
+    if (room_it != client_rooms_.end()) {
+        broadcastChat(client_fd, room_it->second, header, payload);
+    }
     
-    // 송신자에게 에코 메시지 전송
+    // 송신자에게 에코 메시지 전송 (v2 flags는 그대로 돌려보냄)
     sendMessage(client_socket, MessageType::SERVER_ECHO, 
-               message->data, message->header.length, buffer_idx);
+               payload, header.length, buffer_idx, header.flags);
+}
+
+void Session::handleCommand(SocketPtr client_socket, const FrameHeader& header, const uint8_t* payload, uint16_t buffer_idx) {
+    if (!client_socket || !client_socket->isValid()) {
+        LOG_ERROR("[Session ", session_id_, "] Attempted to process COMMAND from invalid client socket");
+        return;
+    }
+    
+    int32_t client_fd = client_socket->getSocketFd();
+    static constexpr char ANNOUNCE_COMMAND[] = "announce ";
+    static constexpr size_t ANNOUNCE_PREFIX = sizeof(ANNOUNCE_COMMAND) - 1;
+    
+    if (payload && header.length > ANNOUNCE_PREFIX && memcmp(payload, ANNOUNCE_COMMAND, ANNOUNCE_PREFIX) == 0) {
+        // 공지 한 건이 서버의 모든 연결로 증폭되므로 운영자 토큰을 보낸 연결만, 연결별 최소 간격을 두고 허용
+        const uint8_t* token = payload + ANNOUNCE_PREFIX;
+        const size_t args_length = header.length - ANNOUNCE_PREFIX;
+        const auto* separator = static_cast<const uint8_t*>(memchr(token, ' ', args_length));
+        const char* rejection = nullptr;
+        if (announce_token_.empty()) {
+            rejection = "Announcements are disabled";
+        } else if (!separator || separator + 1 == token + args_length ||
+                   !announceTokenMatches(token, static_cast<size_t>(separator - token))) {
+            rejection = "Announcement not authorized";
+        } else {
+            const auto now = std::chrono::steady_clock::now();
+            auto [last_it, first] = last_announce_.try_emplace(client_fd, now);
+            if (!first && now - last_it->second < announce_interval_) {
+                rejection = "Announcement rate limited";
+            } else {
+                last_it->second = now;
+            }
+        }
+        if (rejection) {
+            ++stats_.announce_rejected;
+            LOG_WARN("[Session ", session_id_, "] Rejected announcement from client ", client_fd, ": ", rejection);
+            sendMessage(client_socket, MessageType::SERVER_ERROR, rejection, strlen(rejection), buffer_idx);
+            return;
+        }
+        
+        // 공지 본문을 먼저 복사 (응답이 recv 버퍼를 돌려주기 전에)
+        const uint8_t* text = separator + 1;
+        const uint64_t broadcast_id = announce(text, static_cast<size_t>(token + args_length - text));
+        LOG_INFO("[Session ", session_id_, "] Client ", client_fd, " started announcement ", broadcast_id);
+        
+        std::stringstream ss;
+        ss << "Announcement " << broadcast_id << " queued";
+        std::string msg = ss.str();
+        sendMessage(client_socket, MessageType::SERVER_ACK, msg.c_str(), msg.length(), buffer_idx);
+        return;
+    }
+    
+    LOG_WARN("[Session ", session_id_, "] Unknown command from client ", client_fd);
+    static constexpr char UNKNOWN_COMMAND[] = "Unknown command";
+    sendMessage(client_socket, MessageType::SERVER_ERROR, UNKNOWN_COMMAND, sizeof(UNKNOWN_COMMAND) - 1, buffer_idx);
+}
+
+void Session::joinRoom(int32_t client_fd, int32_t room_id) {
+    leaveRoom(client_fd);
+    
+    RoomMembers& room = rooms_[room_id];
+    if (room.members.empty()) {
+        RoomRegistry::getInstance().join(room_id, session_id_);
+    }
+    room.index.emplace(client_fd, room.members.size());
+    room.members.push_back(client_fd);
+    client_rooms_[client_fd] = room_id;
+    LOG_INFO("[Session ", session_id_, "] Client ", client_fd, " joined room ", room_id,
+             ", local members: ", room.members.size());
+}
+
+void Session::leaveRoom(int32_t client_fd) {
+    auto client_it = client_rooms_.find(client_fd);
+    if (client_it == client_rooms_.end()) {
+        return;
+    }
+    const int32_t room_id = client_it->second;
+    client_rooms_.erase(client_it);
+    
+    auto room_it = rooms_.find(room_id);
+    RoomMembers& room = room_it->second;
+    const size_t index = room.index[client_fd];
+    room.index.erase(client_fd);
+    if (index != room.members.size() - 1) {
+        room.members[index] = room.members.back();
+        room.index[room.members[index]] = index;
+    }
+    room.members.pop_back();
+    
+    // 이 세션의 마지막 멤버가 나가면 다른 세션이 더 이상 이 세션으로 방 메시지를 보내지 않도록 함
+    if (room.members.empty()) {
+        rooms_.erase(room_it);
+        RoomRegistry::getInstance().leave(room_id, session_id_);
+    }
+}
+
+bool Session::buildSharedFrame(SharedFrame& frame, MessageType msg_type, uint8_t flags, const uint8_t* payload,
+                               size_t length, bool v2) {
+    SendBufferPool* send_pool = io_ring_->getSendPool();
+    
+    // payload가 없으면 length는 헤더에만 기록 (큰 프레임의 페이로드는 고정한 recv 버퍼에서 따로 보냄)
+    uint8_t header[MAX_FRAME_HEADER_SIZE];
+    const size_t header_size = encodeFrameHeader(header, msg_type, flags, static_cast<uint32_t>(length), v2);
+    const size_t body = payload ? length : 0;
+    size_t remaining = header_size + body;
+    size_t copied = 0;
+    frame.count = 0;
+    while (remaining > 0) {
+        const int slot = acquireSharedSlot();
+        if (slot < 0) {
+            releaseSharedFrame(frame);
+            frame.count = 0;
+            return false;
+        }
+        
+        // 헤더는 첫 슬롯 앞에, 페이로드는 슬롯 경계를 넘어 이어서 씀
+        uint8_t* out = send_pool->getSlotAddr(static_cast<uint16_t>(slot));
+        unsigned used = 0;
+        if (frame.count == 0) {
+            memcpy(out, header, header_size);
+            used = static_cast<unsigned>(header_size);
+        }
+        const size_t chunk = std::min<size_t>(body - copied, SendBufferPool::SLOT_SIZE - used);
+        if (chunk > 0) {
+            memcpy(out + used, payload + copied, chunk);
+        }
+        copied += chunk;
+        used += static_cast<unsigned>(chunk);
+        remaining -= used;
+        
+        // 만드는 쪽의 참조는 수신자를 모두 넣은 뒤 releaseSharedFrame으로 놓음
+        frame.slots[frame.count] = static_cast<uint16_t>(slot);
+        frame.lens[frame.count] = used;
+        ++frame.count;
+    }
+    stats_.broadcast_slots += frame.count;
+    return true;
+}
+
+int Session::acquireSharedSlot() {
+    SendBufferPool* send_pool = io_ring_->getSendPool();
+    if (shared_refs_.size() < send_pool->capacity()) {
+        shared_refs_.resize(send_pool->capacity(), 0);
+        slot_trackers_.resize(send_pool->capacity());
+    }
+    int slot = send_pool->acquire();
+    if (slot < 0) {
+        reclaimSkipSends();
+        slot = send_pool->acquire();
+    }
+    if (slot < 0) {
+        ++stats_.pool_exhausted;
+        return -1;
+    }
+    shared_refs_[slot] = 1;
+    return slot;
+}
+
+bool Session::enqueueShared(int32_t client_fd, const SharedFrame& frame, const std::vector<QueuedSend>* pinned) {
+    if (outbound_.slot >= 0 && outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    auto& queue = send_queues_[client_fd];
+    if (queue.closing) {
+        return false;
+    }
+    
+    size_t frame_bytes = 0;
+    for (unsigned i = 0; i < frame.count; ++i) {
+        frame_bytes += frame.lens[i];
+    }
+    if (pinned) {
+        for (const QueuedSend& segment : *pinned) {
+            frame_bytes += segment.len;
+        }
+    }
+    if (exceedsSendLimit(queue, frame_bytes, 1) && !admitBroadcast(client_fd, queue, frame_bytes)) {
+        return false;
+    }
+    
+    // 프레임의 항목은 모두 broadcast로, 마지막 항목에 프레임 끝을 표시 (정책이 프레임 단위로 버릴 수 있도록)
+    const size_t first = queue.entries.size();
+    for (unsigned i = 0; i < frame.count; ++i) {
+        ++shared_refs_[frame.slots[i]];
+        pushQueued(queue, QueuedSend{SendSource::SHARED, frame.slots[i], frame.lens[i]});
+    }
+    if (pinned) {
+        for (const QueuedSend& segment : *pinned) {
+            pinRecvBuffer(segment.id);
+            pushQueued(queue, segment);
+        }
+    }
+    for (size_t i = first; i < queue.entries.size(); ++i) {
+        queue.entries[i].broadcast = true;
+    }
+    queue.entries.back().frames = 1;
+    ++queue.frames;
+    ++stats_.broadcast_deliveries;
+    pumpSendQueue(client_fd, queue);
+    return true;
+}
+
+void Session::releaseSharedFrame(const SharedFrame& frame) {
+    for (unsigned i = 0; i < frame.count; ++i) {
+        releaseSharedSlot(frame.slots[i]);
+    }
+}
+
+void Session::releaseSharedSlot(uint16_t slot) {
+    if (slot >= shared_refs_.size() || shared_refs_[slot] == 0) {
+        LOG_ERROR("[Session ", session_id_, "] Releasing shared send slot ", slot, " that has no references");
+        return;
+    }
+    if (--shared_refs_[slot] == 0) {
+        io_ring_->getSendPool()->release(slot);
+        if (slot_trackers_[slot]) {
+            // 이 프레임을 받은 모든 연결의 전송이 끝남
+            std::shared_ptr<BroadcastTracker> tracker = std::move(slot_trackers_[slot]);
+            slot_trackers_[slot].reset();
+            releaseTracker(tracker);
+        }
+    }
+}
+
+void Session::broadcastChat(int32_t sender_fd, int32_t room_id, const FrameHeader& header, const uint8_t* payload) {
+    appendHistory(room_id, header.flags, payload, header.length);
+    
+    // 다른 세션에 먼저 넘겨야 이 세션의 팬아웃이 먼저 끝나도 추적기가 0이 되지 않음
+    FanoutJob job;
+    job.tracker = newTracker();
+    job.owned = postToRoomSessions(room_id, job.tracker, [&]() {
+        return std::make_shared<const RoomPayload>(
+            RoomPayload{MessageType::SERVER_CHAT, header.flags, std::vector<uint8_t>(payload, payload + header.length)});
+    });
+    job.flags = header.flags;
+    job.payload = payload;
+    job.length = header.length;
+    job.room_id = room_id;
+    job.sender_fd = sender_fd;
+    
+    static const std::vector<int32_t> no_members;
+    auto room_it = rooms_.find(room_id);
+    startFanout(std::move(job), room_it != rooms_.end() ? room_it->second.members : no_members);
+    ++stats_.broadcasts;
+}
+
+bool Session::announceTokenMatches(const uint8_t* token, size_t length) const {
+    if (length != announce_token_.size()) {
+        return false;
+    }
+    uint8_t diff = 0;
+    for (size_t i = 0; i < length; ++i) {
+        diff |= static_cast<uint8_t>(token[i] ^ static_cast<uint8_t>(announce_token_[i]));
+    }
+    return diff == 0;
+}
+
+uint64_t Session::announce(const uint8_t* text, size_t length) {
+    FanoutJob job;
+    job.tracker = newTracker();
+    job.owned = std::make_shared<const RoomPayload>(
+        RoomPayload{MessageType::SERVER_NOTIFICATION, FRAME_FLAG_NONE, std::vector<uint8_t>(text, text + length)});
+    postToRoomSessions(ANNOUNCE_ROOM, job.tracker, [&]() { return job.owned; });
+    job.type = MessageType::SERVER_NOTIFICATION;
+    job.payload = job.owned->data.data();
+    job.length = length;
+    
+    announce_targets_.clear();
+    for (const auto& client : client_sockets_) {
+        announce_targets_.push_back(client.first);
+    }
+    const uint64_t broadcast_id = job.tracker->id;
+    startFanout(std::move(job), announce_targets_);
+    ++stats_.announcements;
+    return broadcast_id;
+}
+
+void Session::startFanout(FanoutJob&& job, const std::vector<int32_t>& targets) {
+    if (fanout_jobs_.empty()) {
+        size_t budget = fanout_slice_ > 0 ? fanout_slice_ : SIZE_MAX;
+        if (runFanout(job, targets, budget)) {
+            finishFanout(job);
+            return;
+        }
+    }
+    
+    // 남은 수신자는 다음 배치부터 보냄 (앞선 작업이 있으면 같은 연결에 순서가 뒤바뀌지 않도록 그 뒤에서)
+    if (!job.owned) {
+        job.owned = std::make_shared<const RoomPayload>(
+            RoomPayload{job.type, job.flags, std::vector<uint8_t>(job.payload, job.payload + job.length)});
+    }
+    job.payload = job.owned->data.data();
+    job.targets.assign(targets.begin() + job.cursor, targets.end());
+    job.cursor = 0;
+    ++stats_.fanout_deferred;
+    LOG_DEBUG("[Session ", session_id_, "] Broadcast ", job.tracker->id, " deferred with ", job.targets.size(),
+              " recipients left");
+    fanout_jobs_.push_back(std::move(job));
+}
+
+bool Session::runFanout(FanoutJob& job, const std::vector<int32_t>& targets, size_t& budget) {
+    while (job.cursor < targets.size()) {
+        if (budget == 0) {
+            return false;
+        }
+        --budget;
+        const int32_t member_fd = targets[job.cursor++];
+        if (member_fd == job.sender_fd) {
+            continue;
+        }
+        // 나눠 보내는 동안 나간 연결 (방을 옮기거나 닫힘)은 건너뜀
+        if (job.room_id == ANNOUNCE_ROOM) {
+            if (client_sockets_.count(member_fd) == 0) {
+                continue;
+            }
+        } else {
+            auto room_it = client_rooms_.find(member_fd);
+            if (room_it == client_rooms_.end() || room_it->second != job.room_id) {
+                continue;
+            }
+        }
+        
+        // 수신자의 프로토콜 버전별로 처음 필요할 때 한 번만 만듦 (v1 수신자는 1021바이트를 넘는 메시지를 받을 수 없음)
+        const bool v2 = v2_clients_.count(member_fd) > 0;
+        if (!v2 && job.length > MAX_MESSAGE_SIZE) {
+            ++stats_.broadcast_skipped;
+            continue;
+        }
+        SharedFrame& frame = job.frames[v2 ? 1 : 0];
+        if (frame.count == 0) {
+            if (!buildSharedFrame(frame, job.type, job.flags, job.payload, job.length, v2)) {
+                if (!job.pool_blocked) {
+                    // 전송 완료로 슬롯이 돌아올 다음 배치에서 이 수신자부터 다시 시도
+                    job.pool_blocked = true;
+                    --job.cursor;
+                    LOG_DEBUG("[Session ", session_id_, "] Send pool exhausted during broadcast ", job.tracker->id,
+                              ", retrying next batch");
+                    return false;
+                }
+                ++stats_.broadcast_failures;
+                LOG_WARN("[Session ", session_id_, "] Send pool exhausted during broadcast ", job.tracker->id,
+                         ", dropping ", targets.size() - job.cursor + 1, " remaining recipients");
+                job.cursor = targets.size();
+                break;
+            }
+            job.pool_blocked = false;
+            trackSharedFrame(frame, job.tracker);
+        }
+        if (enqueueShared(member_fd, frame)) {
+            ++job.delivered;
+        }
+    }
+    return true;
+}
+
+void Session::finishFanout(FanoutJob& job) {
+    job.tracker->recipients.fetch_add(job.delivered, std::memory_order_relaxed);
+    job.tracker->sessions.fetch_add(1, std::memory_order_relaxed);
+    releaseSharedFrame(job.frames[0]);
+    releaseSharedFrame(job.frames[1]);
+    job.frames[0].count = 0;
+    job.frames[1].count = 0;
+    releaseTracker(job.tracker);
+}
+
+void Session::runFanoutSlices() {
+    size_t budget = fanout_slice_;
+    while (!fanout_jobs_.empty() && budget > 0) {
+        FanoutJob& job = fanout_jobs_.front();
+        ++stats_.fanout_slices;
+        if (!runFanout(job, job.targets, budget)) {
+            break;
+        }
+        finishFanout(job);
+        fanout_jobs_.pop_front();
+    }
+}
+
+bool Session::fanoutWaitsForPool() {
+    if (!fanout_jobs_.front().pool_blocked) {
+        return false;
+    }
+    // 성공 CQE가 없는 skip 전송은 제출하고 CQ를 지나가야 슬롯이 돌아오므로 먼저 반영한 뒤 판단
+    io_ring_->submit();
+    reclaimSkipSends();
+    return io_ring_->getSendPool()->available() == 0;
+}
+
+std::shared_ptr<BroadcastTracker> Session::newTracker() {
+    auto tracker = std::make_shared<BroadcastTracker>();
+    tracker->id = RoomRegistry::getInstance().nextBroadcastId();
+    return tracker;
+}
+
+void Session::trackSharedFrame(const SharedFrame& frame, const std::shared_ptr<BroadcastTracker>& tracker) {
+    // 연결마다 슬롯을 순서대로 보내므로 마지막 슬롯의 참조가 0이 되면 프레임 전체가 모두에게 나간 것
+    tracker->holds.fetch_add(1, std::memory_order_relaxed);
+    slot_trackers_[frame.slots[frame.count - 1]] = tracker;
+}
+
+void Session::releaseTracker(const std::shared_ptr<BroadcastTracker>& tracker) {
+    if (tracker->holds.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    const uint64_t recipients = tracker->recipients.load(std::memory_order_relaxed);
+    if (recipients == 0) {
+        return;
+    }
+    
+    const uint64_t latency_us = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - tracker->start).count());
+    ++stats_.fanout_completed;
+    stats_.fanout_latency_us_total += latency_us;
+    stats_.fanout_latency_us_max = std::max(stats_.fanout_latency_us_max, latency_us);
+    if (fanout_budget_us_ > 0 && latency_us > fanout_budget_us_) {
+        ++stats_.fanout_over_budget;
+        LOG_WARN("[Session ", session_id_, "] Broadcast ", tracker->id, " reached ", recipients, " recipients in ",
+                 tracker->sessions.load(std::memory_order_relaxed), " sessions after ", latency_us, " us (budget ",
+                 fanout_budget_us_, " us)");
+    } else {
+        LOG_DEBUG("[Session ", session_id_, "] Broadcast ", tracker->id, " reached ", recipients, " recipients in ",
+                  tracker->sessions.load(std::memory_order_relaxed), " sessions after ", latency_us, " us");
+    }
+}
+
+Session* Session::peerSession(int32_t target_id) {
+    if (target_id < 0) {
+        return nullptr;
+    }
+    if (peer_sessions_.size() <= static_cast<size_t>(target_id)) {
+        peer_sessions_.resize(target_id + 1);
+    }
+    auto& target_session = peer_sessions_[target_id];
+    if (!target_session) {
+        target_session = SessionManager::getInstance().getSessionByIndex(target_id);
+    }
+    return target_session.get();
+}
+
+template <typename MakePayload>
+std::shared_ptr<const RoomPayload> Session::postToRoomSessions(int32_t room_id,
+                                                               const std::shared_ptr<BroadcastTracker>& tracker,
+                                                               MakePayload&& make_payload) {
+    if (room_id == ANNOUNCE_ROOM) {
+        room_sessions_ = SessionManager::getInstance().getAvailableSessions();
+    } else {
+        RoomRegistry::getInstance().sessionsOf(room_id, room_sessions_);
+    }
+    std::shared_ptr<const RoomPayload> payload;
+    for (const int32_t target_id : room_sessions_) {
+        if (target_id == session_id_) {
+            continue;
+        }
+        Session* target_session = peerSession(target_id);
+        if (!target_session) {
+            continue;
+        }
+        if (!payload) {
+            payload = make_payload();
+        }
+        
+        // 받는 세션의 팬아웃 몫 (그 세션이 작업을 끝낼 때 놓음)
+        tracker->holds.fetch_add(1, std::memory_order_relaxed);
+        auto* message = new RoomMessage;
+        message->room_id = room_id;
+        message->payload = payload;
+        message->tracker = tracker;
+        ++stats_.room_posts;
+        if (target_session->postRoomMessage(message)) {
+            // 이미 메시지가 있던 수신함은 앞선 알림으로 비워지므로 비어 있던 경우에만 깨움
+            io_ring_->prepareRoomNotify(target_session->getIOUring()->getRingFd(), static_cast<uint16_t>(target_id));
+            ++stats_.room_notifies;
+        }
+    }
+    return payload;
+}
+
+void Session::drainRoomInbox() {
+    static const std::vector<int32_t> no_members;
+    RoomMessage* message = room_inbox_.drain();
+    while (message) {
+        RoomMessage* next = message->next;
+        const RoomPayload& payload = *message->payload;
+        
+        // 보낸 뒤 이 세션의 마지막 멤버가 나간 방이면 수신자 없이 끝냄
+        const std::vector<int32_t>* targets = &no_members;
+        if (message->room_id == ANNOUNCE_ROOM) {
+            announce_targets_.clear();
+            for (const auto& client : client_sockets_) {
+                announce_targets_.push_back(client.first);
+            }
+            targets = &announce_targets_;
+        } else {
+            auto room_it = rooms_.find(message->room_id);
+            if (room_it != rooms_.end()) {
+                targets = &room_it->second.members;
+            }
+        }
+        
+        FanoutJob job;
+        job.tracker = std::move(message->tracker);
+        job.owned = std::move(message->payload);
+        job.type = payload.type;
+        job.flags = payload.flags;
+        job.payload = job.owned->data.data();
+        job.length = job.owned->data.size();
+        job.room_id = message->room_id;
+        startFanout(std::move(job), *targets);
+        ++stats_.room_received;
+        
+        delete message;
+        message = next;
+    }
+}
+
+void Session::broadcastLargeFrame(int32_t sender_fd, int32_t room_id, const LargeFrame& frame) {
+    // 고정 범위는 이 링의 recv 버퍼이므로 다른 세션이나 나눠 보낼 작업에는 본문을 한 번 모아서 넘김
+    std::shared_ptr<const RoomPayload> gathered;
+    auto gather = [&]() {
+        if (!gathered) {
+            auto payload = std::make_shared<RoomPayload>();
+            payload->type = MessageType::SERVER_CHAT;
+            payload->flags = frame.header.flags;
+            payload->data.reserve(frame.header.length);
+            auto& buffer_manager = io_ring_->getBufferManager();
+            for (const QueuedSend& segment : frame.segments) {
+                const uint8_t* data = buffer_manager.getBufferAddr(segment.id, buffer_manager.getBaseAddr()) + segment.begin;
+                payload->data.insert(payload->data.end(), data, data + segment.len);
+            }
+            gathered = std::move(payload);
+        }
+        return gathered;
+    };
+    if (RoomHistory::getInstance().enabled()) {
+        const auto& body = gather()->data;
+        appendHistory(room_id, frame.header.flags, body.data(), body.size());
+    }
+    auto tracker = newTracker();
+    postToRoomSessions(room_id, tracker, gather);
+    ++stats_.broadcasts;
+    
+    static const std::vector<int32_t> no_members;
+    auto room_it = rooms_.find(room_id);
+    const std::vector<int32_t>& members = room_it != rooms_.end() ? room_it->second.members : no_members;
+    if (!fanout_jobs_.empty() || (fanout_slice_ > 0 && members.size() > fanout_slice_)) {
+        FanoutJob job;
+        job.tracker = std::move(tracker);
+        job.owned = gather();
+        job.flags = frame.header.flags;
+        job.payload = job.owned->data.data();
+        job.length = job.owned->data.size();
+        job.room_id = room_id;
+        job.sender_fd = sender_fd;
+        startFanout(std::move(job), members);
+        return;
+    }
     
-    // 여기에 세션 내 다른 모든 클라이언트에게 메시지 전달 로직을 추가할 수 있음
-    // 현재는 에코만 구현
-} 
+    // 한 조각에 끝나면 헤더 슬롯 하나만 공유하고 페이로드는 송신자가 보낸 recv 버퍼 범위를 수신자마다 한 번씩 더 고정해 보냄
+    // (완료 시간은 헤더 슬롯 기준)
+    SharedFrame header_frame;
+    uint64_t delivered = 0;
+    for (const int32_t member_fd : members) {
+        if (member_fd == sender_fd) {
+            continue;
+        }
+        if (v2_clients_.count(member_fd) == 0) {
+            ++stats_.broadcast_skipped;
+            continue;
+        }
+        if (header_frame.count == 0) {
+            if (!buildSharedFrame(header_frame, MessageType::SERVER_CHAT, frame.header.flags, nullptr,
+                                  frame.header.length, true)) {
+                ++stats_.broadcast_failures;
+                LOG_WARN("[Session ", session_id_, "] Send pool exhausted while broadcasting large frame from client ",
+                         sender_fd);
+                break;
+            }
+            trackSharedFrame(header_frame, tracker);
+        }
+        if (enqueueShared(member_fd, header_frame, &frame.segments)) {
+            ++delivered;
+        }
+    }
+    tracker->recipients.fetch_add(delivered, std::memory_order_relaxed);
+    tracker->sessions.fetch_add(1, std::memory_order_relaxed);
+    releaseSharedFrame(header_frame);
+    releaseTracker(tracker);
+}
+
+
+void Session::appendHistory(int32_t room_id, uint8_t flags, const uint8_t* payload, size_t length) {
+    RoomHistory& history = RoomHistory::getInstance();
+    if (!history.enabled()) {
+        return;
+    }
+    std::shared_ptr<HistorySegment> segment = history.append(room_id, MessageType::SERVER_CHAT, flags, payload, length);
+    if (!segment) {
+        ++stats_.history_append_failures;
+        return;
+    }
+    ++stats_.history_appends;
+    if (history_dirty_.empty() || history_dirty_.back() != segment) {
+        history_dirty_.push_back(std::move(segment));
+    }
+}
+
+void Session::commitHistory() {
+    if (history_dirty_.empty()) {
+        return;
+    }
+    std::vector<std::shared_ptr<HistorySegment>> dirty;
+    dirty.swap(history_dirty_);
+    for (auto& segment : dirty) {
+        // 이미 반영되었거나 다른 동기화가 진행 중이면 건너뜀 (진행 중인 쪽이 완료 후 남은 기록을 다시 동기화)
+        size_t target = 0;
+        if (!segment->beginSync(target)) {
+            continue;
+        }
+        const uint16_t tag = next_history_sync_++;
+        if (!io_ring_->prepareHistorySync(segment->fd(), tag)) {
+            segment->endSync(target, false);
+            history_dirty_.push_back(std::move(segment));
+            continue;
+        }
+        history_syncs_[tag] = HistorySync{std::move(segment), target};
+        ++stats_.history_syncs;
+    }
+}
+
+void Session::replayHistory(int32_t client_fd, int32_t room_id) {
+    RoomHistory& history = RoomHistory::getInstance();
+    if (!history.enabled() || history.replayCount() == 0) {
+        return;
+    }
+    std::vector<HistoryRecord> records;
+    history.recent(room_id, history.replayCount(), records);
+    if (records.empty()) {
+        return;
+    }
+    if (outbound_.slot >= 0 && outbound_.client_fd == client_fd) {
+        flushOutbound();
+    }
+    auto& queue = send_queues_[client_fd];
+    if (queue.closing) {
+        return;
+    }
+    
+    // 송신 큐 상한 안에 들어가는 만큼만 최근 메시지부터 거꾸로 고르고, 보낼 때는 오래된 것부터 보냄
+    // (v1 연결은 1021바이트를 넘는 메시지를 받을 수 없음)
+    const bool v2 = v2_clients_.count(client_fd) > 0;
+    size_t first = records.size();
+    size_t planned_bytes = 0;
+    unsigned planned_frames = 0;
+    while (first > 0) {
+        const HistoryRecord& record = records[first - 1];
+        if (v2 || record.length <= MAX_MESSAGE_SIZE) {
+            uint8_t header[MAX_FRAME_HEADER_SIZE];
+            const size_t frame_bytes = encodeFrameHeader(header, record.type, record.flags, record.length, v2) + record.length;
+            if (exceedsSendLimit(queue, planned_bytes + frame_bytes, planned_frames + 1)) {
+                break;
+            }
+            planned_bytes += frame_bytes;
+            ++planned_frames;
+        }
+        --first;
+    }
+    for (size_t i = 0; i < first; ++i) {
+        if (v2 || records[i].length <= MAX_MESSAGE_SIZE) {
+            ++stats_.history_replay_capped;
+        }
+    }
+    
+    // 프레임 헤더는 공유 슬롯 하나에 이어 쓰고 (항목마다 슬롯 참조), 페이로드는 세그먼트 매핑을 가리키는 항목으로 보냄
+    // 재생 프레임은 브로드캐스트처럼 느린 수신자 정책으로 버릴 수 있게 표시
+    SendBufferPool* send_pool = io_ring_->getSendPool();
+    int slot = -1;
+    unsigned used = 0;
+    size_t replayed = 0;
+    for (size_t i = first; i < records.size(); ++i) {
+        const HistoryRecord& record = records[i];
+        if (!v2 && record.length > MAX_MESSAGE_SIZE) {
+            continue;
+        }
+        if (slot < 0 || used + MAX_FRAME_HEADER_SIZE > SendBufferPool::SLOT_SIZE) {
+            if (slot >= 0) {
+                releaseSharedSlot(static_cast<uint16_t>(slot));
+            }
+            slot = acquireSharedSlot();
+            used = 0;
+        }
+        const int pin = slot >= 0 ? pinHistory(record.segment) : -1;
+        if (pin < 0) {
+            ++stats_.history_replay_failures;
+            LOG_WARN("[Session ", session_id_, "] Stopped history replay of room ", room_id, " to client ", client_fd,
+                     " after ", replayed, " of ", records.size() - first, " messages");
+            break;
+        }
+        
+        uint8_t* out = send_pool->getSlotAddr(static_cast<uint16_t>(slot)) + used;
+        const size_t header_size = encodeFrameHeader(out, record.type, record.flags, record.length, v2);
+        QueuedSend header{SendSource::SHARED, static_cast<uint16_t>(slot), static_cast<unsigned>(header_size)};
+        header.begin = used;
+        header.broadcast = true;
+        ++shared_refs_[slot];
+        pushQueued(queue, header);
+        QueuedSend body{SendSource::HISTORY, static_cast<uint16_t>(pin), record.length};
+        body.begin = record.offset;
+        body.frames = 1;
+        body.broadcast = true;
+        pushQueued(queue, body);
+        used += static_cast<unsigned>(header_size);
+        ++replayed;
+    }
+    if (slot >= 0) {
+        releaseSharedSlot(static_cast<uint16_t>(slot));
+    }
+    
+    ++stats_.history_replays;
+    stats_.history_replayed += replayed;
+    LOG_DEBUG("[Session ", session_id_, "] Replaying ", replayed, " messages of room ", room_id, " to client ", client_fd);
+    if (replayed > 0) {
+        pumpSendQueue(client_fd, queue);
+    }
+}
+
+int Session::pinHistory(const std::shared_ptr<HistorySegment>& segment) {
+    auto pin_it = history_pin_ids_.find(segment.get());
+    if (pin_it != history_pin_ids_.end()) {
+        ++history_pins_[pin_it->second].refs;
+        return pin_it->second;
+    }
+    uint16_t pin;
+    if (!free_history_pins_.empty()) {
+        pin = free_history_pins_.back();
+        free_history_pins_.pop_back();
+    } else if (history_pins_.size() <= UINT16_MAX) {
+        pin = static_cast<uint16_t>(history_pins_.size());
+        history_pins_.emplace_back();
+    } else {
+        return -1;
+    }
+    history_pins_[pin].segment = segment;
+    history_pins_[pin].refs = 1;
+    history_pin_ids_.emplace(segment.get(), pin);
+    return pin;
+}
 
+void Session::unpinHistory(uint16_t pin) {
+    if (pin >= history_pins_.size() || history_pins_[pin].refs == 0) {
+        LOG_ERROR("[Session ", session_id_, "] Releasing history pin ", pin, " that has no references");
+        return;
+    }
+    HistoryPin& entry = history_pins_[pin];
+    if (--entry.refs == 0) {
+        // 마지막 재생 전송이 끝남 (보관 정책으로 지워진 세그먼트면 여기서 매핑이 해제될 수 있음)
+        history_pin_ids_.erase(entry.segment.get());
+        entry.segment.reset();
+        free_history_pins_.push_back(pin);
+    }
+}
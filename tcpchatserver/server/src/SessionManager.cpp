@@ -1,10 +1,16 @@
 #include "SessionManager.h"
 #include "Utils.h"
 #include "Logger.h"
+#include "ServerConfig.h"
+#include "SocketManager.h"
+#include "RoomHistory.h"
 #include <stdexcept>
+#include <cstring>
 #include <chrono>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <pthread.h>
 
 SessionManager::SessionManager() : running_(false), should_terminate_(false) {
     LOG_INFO("[SessionManager] Initialized");
@@ -30,18 +36,129 @@ void SessionManager::initialize(unsigned int num_threads) {
     available_sessions_.clear();
     next_session_id_ = 0;
     
+    const auto& config = ServerConfig::getInstance();
+    const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    // 첫 세션 링이 부모가 되어 나머지 링이 폴러(SQPOLL)와 io-wq 백엔드를 공유
+    const bool attach_to_parent = config.shared_wq || (config.sqpoll && config.sqpoll_shared);
+    int shared_ring_fd = -1;
+    
+    // 고정 파일 테이블 크기는 RLIMIT_NOFILE을 넘을 수 없음
+    unsigned fixed_file_slots = 0;
+    if (config.direct_fds) {
+        fixed_file_slots = FixedFileTable::clampToFileLimit(config.direct_fd_slots);
+    }
+    
+    // 한 recv에 여러 프레임이 오거나 프레임이 recv 경계에 걸치면 응답을 recv 버퍼에 만들 수 없으므로
+    // 수신 프레이머용 송신 풀은 항상 생성 (지정하지 않으면 기본 크기)
+    unsigned send_pool_slots = config.send_pool_slots;
+    if (send_pool_slots == 0) {
+        send_pool_slots = DEFAULT_SEND_POOL_SLOTS;
+        LOG_INFO("[SessionManager] Using a default send pool of ", send_pool_slots, " slots");
+    }
+    if (config.send_skip_success) {
+        // 생략된 성공은 커널의 SQ head/CQ 갱신 순서로 추정하는데, 이 순서는 io_uring ABI가 보장하지 않음
+        LOG_WARN("[SessionManager] --send-skip-success is experimental: send success is inferred from kernel SQ/CQ ordering");
+    }
+    
+    // 예상 연결 수가 주어지면 SQ/CQ를 그에 맞춰 산정 (0이면 기존 고정 크기)
+    unsigned sq_entries = 0;
+    unsigned cq_entries = 0;
+    if (config.expected_connections > 0) {
+        sq_entries = IOUring::submissionEntriesFor(config.expected_connections);
+        cq_entries = IOUring::completionEntriesFor(config.expected_connections, sq_entries);
+        LOG_INFO("[SessionManager] Sizing session rings for ", config.expected_connections,
+                 " connections: SQ ", sq_entries, ", CQ ", cq_entries);
+    }
+    
+    // 방 히스토리는 세션이 기록/재생을 시작하기 전에 기존 세그먼트를 복구
+    if (!config.history_dir.empty()) {
+        RoomHistory::getInstance().open(config.history_dir, config.history_segment_bytes, config.history_replay,
+                                        config.history_retain_bytes, config.history_retain_secs);
+    }
+    
     for (unsigned int i = 0; i < num_threads; ++i) {
         int32_t session_id = static_cast<int32_t>(next_session_id_++);
-        auto session = std::make_shared<Session>(session_id);
+        
+        RingOptions ring_options;
+        ring_options.sqpoll = config.sqpoll;
+        ring_options.sq_thread_idle_ms = config.sqpoll_idle_ms;
+        if (config.ring_profile == RingProfile::SINGLE_ISSUER) {
+            ring_options.single_issuer = true;
+            ring_options.register_ring_fd = true;
+        }
+        if (config.sqpoll && config.sqpoll_cpu >= 0) {
+            // 세션마다 폴러를 서로 다른 CPU에 고정 (공유 모드에서는 첫 링의 설정만 사용됨)
+            ring_options.sq_thread_cpu = static_cast<int>((config.sqpoll_cpu + i) % num_cpus);
+        }
+        if (attach_to_parent) {
+            ring_options.attach_wq_fd = shared_ring_fd;
+        }
+        ring_options.fixed_file_slots = fixed_file_slots;
+        ring_options.iowq_max_bounded = config.iowq_max_bounded;
+        ring_options.iowq_max_unbounded = config.iowq_max_unbounded;
+        ring_options.iowq_cpu = sessionCpu(session_id);
+        ring_options.sq_entries = sq_entries;
+        ring_options.cq_entries = cq_entries;
+        ring_options.auto_resize = config.ring_autoresize;
+        ring_options.send_zc_threshold = config.send_zc_threshold;
+        ring_options.send_pool_slots = send_pool_slots;
+        ring_options.recv_bundle = config.recv_bundle;
+        ring_options.recv_buffers = config.recv_buffers;
+        ring_options.recv_buffer_cap = config.recv_buffer_cap;
+        ring_options.buffer_debug = config.buffer_debug;
+        ring_options.recv_size_classes = config.recv_size_classes;
+        ring_options.recv_incremental = config.recv_incremental;
+        ring_options.recv_buffer_size = config.inc_buffer_size;
+        ring_options.recv_buffer_count = config.inc_buffers;
+        ring_options.send_skip_success = config.send_skip_success;
+        
+        auto session = std::make_shared<Session>(session_id, ring_options);
+        if (attach_to_parent && shared_ring_fd < 0) {
+            shared_ring_fd = session->getIOUring()->getRingFd();
+        }
         sessions_[session_id] = session;
         available_sessions_.push_back(session_id);
         LOG_DEBUG("[SessionManager] Created session ", session_id, " with dedicated IOUring");
     }
 }
 
+void SessionManager::openListeners(const std::string& host, uint16_t port) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    
+    const auto& config = ServerConfig::getInstance();
+    SocketPtr first_socket;
+    for (int32_t session_id : available_sessions_) {
+        auto listening_socket = SocketUtils::createListeningSocket(host, port, true);
+        if (!listening_socket || !listening_socket->isValid()) {
+            throw std::runtime_error("Failed to create reuseport listening socket for session " + std::to_string(session_id));
+        }
+        if (!first_socket) {
+            first_socket = listening_socket;
+        }
+        sessions_[session_id]->setListeningSocket(std::move(listening_socket));
+    }
+    
+    // 프로그램은 그룹 전체에 적용되므로 소켓 하나에만 붙임
+    // 세션 i는 CPU (base + i)에 고정되므로 CPU c는 세션 (c - base) % n으로 보냄
+    if (config.reuseport_cpu_steer && first_socket) {
+        const unsigned num_sessions = static_cast<unsigned>(available_sessions_.size());
+        const unsigned base = config.session_cpu >= 0 ? static_cast<unsigned>(config.session_cpu) % num_sessions : 0;
+        if (config.session_cpu < 0) {
+            LOG_WARN("[SessionManager] --reuseport-cpu-steer without --session-cpu: sessions are not pinned to the steered CPUs");
+        }
+        if (!SocketUtils::attachReuseportCpuSteering(first_socket, num_sessions, (num_sessions - base) % num_sessions)) {
+            LOG_WARN("[SessionManager] Falling back to kernel hash distribution across reuseport sockets");
+        }
+    }
+    
+    LOG_INFO("[SessionManager] Opened ", available_sessions_.size(), " reuseport listeners on ", host, ":", port);
+}
+
 void SessionManager::start() {
     running_ = true;
     should_terminate_ = false;
+    workers_ready_ = 0;
+    workers_failed_ = 0;
     
     // 각 세션별로 전용 쓰레드 시작
     for (const auto& session_pair : sessions_) {
@@ -62,6 +179,19 @@ void SessionManager::start() {
         LOG_INFO("[SessionManager] Started worker thread for session ", session_id);
     }
     
+    // 비활성(R_DISABLED) 링이 활성화되기 전에 Listener가 전달하지 않도록 모든 워커의 준비를 기다림
+    while (workers_ready_.load() < session_threads_.size()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    
+    // 활성화에 실패한 세션(예: 송신 풀 등록 실패)은 연결을 받을 수 없으므로 서버를 시작하지 않음
+    if (workers_failed_.load() > 0) {
+        const size_t failed = workers_failed_.load();
+        stop();
+        LOG_ERROR("[SessionManager] ", failed, " session worker(s) failed to start");
+        throw std::runtime_error("Failed to start " + std::to_string(failed) + " session worker(s)");
+    }
+    
     LOG_INFO("[SessionManager] Started session manager with ", available_sessions_.size(), " sessions and worker threads");
 }
 
@@ -72,6 +202,11 @@ void SessionManager::stop() {
     
     LOG_INFO("[SessionManager] Stopping all session threads...");
     
+    // 빈 세션도 링에서 블로킹 대기하므로 eventfd로 깨워 종료 플래그를 확인하게 함
+    for (const auto& session_pair : sessions_) {
+        session_pair.second->wakeup();
+    }
+    
     // Wait for all session threads to terminate
     for (auto& thread_pair : session_threads_) {
         int32_t session_id = thread_pair.first;
@@ -87,6 +222,11 @@ void SessionManager::stop() {
     // Clear thread objects
     session_threads_.clear();
     
+    // 워커가 모두 종료된 뒤이므로 통계를 안전하게 읽을 수 있음
+    for (const auto& session_pair : sessions_) {
+        session_pair.second->logStats();
+    }
+    
     LOG_INFO("[SessionManager] All session threads stopped");
 }
 
@@ -99,15 +239,33 @@ void SessionManager::sessionWorker(std::shared_ptr<Session> session) {
     const int32_t session_id = session->getSessionId();
     LOG_INFO("[SessionManager] Session ", session_id, " worker thread started");
     
+    // 워커 스레드를 고정하면 이 스레드의 io-wq도 같은 CPU로 맞춰짐 (IOUring::activate)
+    const int cpu = sessionCpu(session_id);
+    if (cpu >= 0) {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+        if (ret != 0) {
+            LOG_WARN("[SessionManager] Failed to pin session ", session_id, " to CPU ", cpu, ": ", strerror(ret));
+        }
+    }
+    
     try {
+        // 링은 이 스레드에서만 제출되도록 워커 스레드에서 활성화
+        try {
+            session->onWorkerStart();
+        } catch (const std::exception& e) {
+            LOG_ERROR("[SessionManager] Failed to start session ", session_id, " worker: ", e.what());
+            workers_failed_++;
+            workers_ready_++;
+            return;
+        }
+        workers_ready_++;
+        
         // Use a reference to the shared_ptr to avoid copies in the loop
         while (running_ && !should_terminate_) {
-            // Wait if session is empty
-            if (session->getClientCount() == 0) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
-            }
-            
+            // 빈 세션도 링에서 대기: 새 클라이언트는 RECV_CLIENT/RECV_FD CQE로, 세션 이동은 RECV_MIGRATION CQE로 깨움
             try {
                 // Process session events
                 session->processEvents();
@@ -123,110 +281,57 @@ void SessionManager::sessionWorker(std::shared_ptr<Session> session) {
     LOG_INFO("[SessionManager] Session ", session_id, " worker thread terminated");
 }
 
-int32_t SessionManager::assignClientToSession(SocketPtr client_socket) {
-    if (!client_socket || !client_socket->isValid()) {
-        LOG_ERROR("[SessionManager] Invalid socket passed to assignClientToSession");
-        return -1;
-    }
-    
-    int32_t client_fd = client_socket->getSocketFd();
-    if (client_fd < 0) {
-        LOG_ERROR("[SessionManager] Socket has invalid file descriptor");
-        return -1;
+std::shared_ptr<Session> SessionManager::pickSession() {
+    const size_t num_sessions = available_sessions_.size();
+    if (num_sessions == 0) {
+        return nullptr;
     }
     
-    try {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        if (available_sessions_.empty()) {
-            LOG_ERROR("[SessionManager] No available sessions to assign client ", client_fd);
-            return -1;
-        }
-        
-        // 세션 목록이 비어있지 않다면 라운드 로빈 방식으로 순환
-        size_t session_index = next_session_index_.fetch_add(1) % available_sessions_.size();
-        int32_t session_id = available_sessions_[session_index];
-        
-        // 선택된 세션에 클라이언트 추가
-        auto session_it = sessions_.find(session_id);
-        if (session_it == sessions_.end()) {
-            LOG_ERROR("[SessionManager] Session not found: ", session_id);
-            return -1;
-        }
-        
-        // 세션 매핑 정보 추가
-        client_sessions_[client_fd] = session_id;
-        
-        // 세션에 클라이언트 추가
-        session_it->second->addClient(client_socket);
-        
-        LOG_INFO("[SessionManager] Assigned client ", client_fd, " to session ", session_id);
-        return session_id;
-    } catch (const std::exception& e) {
-        LOG_ERROR("[SessionManager] Exception in assignClientToSession for client ", client_fd, ": ", e.what());
-        return -1;
+    size_t session_index = next_session_index_.fetch_add(1, std::memory_order_relaxed) % num_sessions;
+    auto session_it = sessions_.find(available_sessions_[session_index]);
+    if (session_it == sessions_.end()) {
+        LOG_ERROR("[SessionManager] Session not found: ", available_sessions_[session_index]);
+        return nullptr;
     }
+    return session_it->second;
 }
 
-bool SessionManager::processEvents() {
-    // 멀티쓰레드 모드에서는 이 메서드는 더 이상 사용되지 않음 (각 세션이 자체 쓰레드에서 처리)
-    // 하지만 호환성을 위해 유지
-    return running_;
-}
-
-void SessionManager::removeSession(int32_t client_fd) {
-    if (client_fd < 0) {
-        LOG_ERROR("[SessionManager] Attempted to remove invalid client_fd: ", client_fd);
-        return;
-    }
-    
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    try {
-        auto it = client_sessions_.find(client_fd);
-        if (it != client_sessions_.end()) {
-            int32_t session_id = it->second;
-            
-            auto session_it = sessions_.find(session_id);
-            if (session_it != sessions_.end()) {
-                auto session = session_it->second;
-                // 파일 디스크립터를 사용하는 대신 Socket 객체 생성
-                auto socket_ptr = std::make_shared<Socket>(client_fd);
-                session->removeClient(socket_ptr);
-                LOG_INFO("[SessionManager] Removed client ", client_fd, " from session ", session_id);
-                
-                // 세션이 비어있으면 세션 정리 로직을 여기에 추가할 수 있음
-            } else {
-                LOG_ERROR("[SessionManager] Session ", session_id, " not found for client ", client_fd);
-            }
-            
-            client_sessions_.erase(it);
-            LOG_DEBUG("[SessionManager] Removed client-session mapping for client ", client_fd);
-        } else {
-            LOG_DEBUG("[SessionManager] Client ", client_fd, " not found in any session");
-        }
-    }
-    catch (const std::exception& e) {
-        LOG_ERROR("[SessionManager] Exception in removeSession for client ", client_fd, ": ", e.what());
+int SessionManager::sessionCpu(int32_t session_id) {
+    const int base = ServerConfig::getInstance().session_cpu;
+    if (base < 0) {
+        return -1;
     }
+    const unsigned num_cpus = std::max(1u, std::thread::hardware_concurrency());
+    return static_cast<int>((static_cast<unsigned>(base) + static_cast<unsigned>(session_id)) % num_cpus);
 }
 
-std::shared_ptr<Session> SessionManager::getSession(int32_t client_fd) {
+std::shared_ptr<Session> SessionManager::reserveDirectSession() {
     std::lock_guard<std::mutex> lock(mutex_);
     
-    auto it = client_sessions_.find(client_fd);
-    if (it != client_sessions_.end()) {
-        int32_t session_id = it->second;
-        auto session_it = sessions_.find(session_id);
+    const size_t num_sessions = available_sessions_.size();
+    for (size_t attempt = 0; attempt < num_sessions; ++attempt) {
+        size_t session_index = next_session_index_.fetch_add(1) % num_sessions;
+        auto session_it = sessions_.find(available_sessions_[session_index]);
+        if (session_it == sessions_.end()) {
+            continue;
+        }
         
-        if (session_it != sessions_.end()) {
+        FixedFileTable* file_table = session_it->second->getIOUring()->getFileTable();
+        if (file_table && file_table->reserve()) {
             return session_it->second;
         }
     }
     
+    LOG_ERROR("[SessionManager] No session has a free fixed file slot");
     return nullptr;
 }
 
+bool SessionManager::processEvents() {
+    // 멀티쓰레드 모드에서는 이 메서드는 더 이상 사용되지 않음 (각 세션이 자체 쓰레드에서 처리)
+    // 하지만 호환성을 위해 유지
+    return running_;
+}
+
 const std::set<int32_t>& SessionManager::getSessionClients(int32_t session_id) {
     static std::set<int32_t> empty_set;
     
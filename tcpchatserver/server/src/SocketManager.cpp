@@ -2,6 +2,10 @@
 #include "Logger.h"
 #include <stdexcept>
 #include "Context.h"
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <linux/filter.h>
 
 // SocketUtils 네임스페이스 내 함수 구현
 namespace SocketUtils {
@@ -36,7 +40,7 @@ bool setSocketReuseAddr(SocketPtr socket, bool reuseAddr) {
     return result;
 }
 
-SocketPtr createListeningSocket(const std::string& host, uint16_t port) {
+SocketPtr createListeningSocket(const std::string& host, uint16_t port, bool reusePort) {
     // TCP 소켓 생성
     auto socket = createTCPSocket();
     if (!socket) {
@@ -47,6 +51,10 @@ SocketPtr createListeningSocket(const std::string& host, uint16_t port) {
     if (!setSocketReuseAddr(socket, true)) {
         return nullptr;
     }
+    if (reusePort && !socket->setReusePort(true)) {
+        LOG_ERROR("[SocketUtils] Failed to set SO_REUSEPORT: ", strerror(errno));
+        return nullptr;
+    }
     
     // 주소 바인딩
     SocketAddress address(host, port);
@@ -65,6 +73,33 @@ SocketPtr createListeningSocket(const std::string& host, uint16_t port) {
     return socket;
 }
 
+bool attachReuseportCpuSteering(SocketPtr socket, unsigned groupSize, unsigned cpuOffset) {
+    if (!socket || !socket->isValid() || groupSize == 0) {
+        LOG_ERROR("[SocketUtils] Invalid arguments in attachReuseportCpuSteering");
+        return false;
+    }
+    
+    // A = 현재 CPU (SYN을 처리하는 CPU, 새 연결의 SO_INCOMING_CPU와 같음); A = (A + offset) % n; return A
+    // 반환값이 그룹 크기 이상이면 커널은 기본 해시 분배로 되돌아감
+    sock_filter code[] = {
+        { BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<uint32_t>(SKF_AD_OFF + SKF_AD_CPU) },
+        { BPF_ALU | BPF_ADD | BPF_K, 0, 0, cpuOffset },
+        { BPF_ALU | BPF_MOD | BPF_K, 0, 0, groupSize },
+        { BPF_RET | BPF_A, 0, 0, 0 },
+    };
+    sock_fprog program{};
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+    
+    if (setsockopt(socket->getSocketFd(), SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) != 0) {
+        LOG_ERROR("[SocketUtils] Failed to attach reuseport CPU steering program: ", strerror(errno));
+        return false;
+    }
+    
+    LOG_INFO("[SocketUtils] Attached reuseport CPU steering for ", groupSize, " sockets");
+    return true;
+}
+
 SocketPtr createClientSocket(const std::string& host, uint16_t port) {
     // TCP 소켓 생성
     auto socket = createTCPSocket();
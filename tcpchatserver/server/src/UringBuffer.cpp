@@ -11,33 +11,33 @@
 #include <iostream>
 #include "Utils.h"
 
-template <unsigned N> constexpr bool is_power_of_two() {
-    static_assert(N <= 32768, "N must be N <= 32768");
-    return (N == 1 || N == 2 || N == 4 || N == 8 || N == 16 || N == 32 || N == 64 || N == 128 || N == 256 ||
-            N == 512 || N == 1024 || N == 2048 || N == 4096 || N == 8192 || N == 16384 || N == 32768);
+namespace {
+
+constexpr bool is_power_of_two(unsigned n) {
+    return n != 0 && (n & (n - 1)) == 0;
 }
 
-template <unsigned N> constexpr unsigned log2() {
-    static_assert(is_power_of_two<N>(), "N must be a power of 2");
-    unsigned val = N;
+constexpr unsigned log2(unsigned n) {
     unsigned ret = 0;
-    while (val > 1) {
-        val >>= 1;
+    while (n > 1) {
+        n >>= 1;
         ret++;
     }
     return ret;
 }
 
-static constexpr unsigned buffer_ring_size() {
-    return (UringBuffer::IO_BUFFER_SIZE + sizeof(io_uring_buf)) * UringBuffer::NUM_IO_BUFFERS;
+constexpr size_t buffer_ring_size(unsigned buffer_size, uint16_t num_buffers) {
+    return (static_cast<size_t>(buffer_size) + sizeof(io_uring_buf)) * num_buffers;
 }
 
-static uint8_t* get_buffer_base_addr(void* ring_addr) {
-    return static_cast<uint8_t*>(ring_addr) + (sizeof(io_uring_buf) * UringBuffer::NUM_IO_BUFFERS);
+uint8_t* get_buffer_base_addr(void* ring_addr, uint16_t num_buffers) {
+    return static_cast<uint8_t*>(ring_addr) + (sizeof(io_uring_buf) * num_buffers);
 }
 
+} // namespace
+
 uint8_t* UringBuffer::getBufferAddr(uint16_t idx, uint8_t* buf_base_addr) {
-    if (idx >= NUM_IO_BUFFERS) {
+    if (idx >= num_buffers_) {
         LOG_ERROR("[Buffer] Invalid buffer index: ", idx);
         return nullptr;
     }
@@ -47,16 +47,36 @@ uint8_t* UringBuffer::getBufferAddr(uint16_t idx, uint8_t* buf_base_addr) {
         return nullptr;
     }
     
-    return buf_base_addr + (idx << log2<UringBuffer::IO_BUFFER_SIZE>());
+    return buf_base_addr + (static_cast<size_t>(idx) << buffer_shift_);
 }
 
-UringBuffer::UringBuffer(io_uring* ring) 
-    : ring_(ring), buf_ring_(nullptr), buffer_base_addr_(nullptr), ring_size_(buffer_ring_size())
+UringBuffer::UringBuffer(io_uring* ring, unsigned buffer_size, uint16_t num_buffers, bool incremental, uint16_t bgid,
+                         uint16_t initial_buffers)
+    : ring_(ring), buf_ring_(nullptr), buffer_base_addr_(nullptr),
+      buffer_size_(buffer_size), num_buffers_(num_buffers), buffer_shift_(log2(buffer_size)), bgid_(bgid),
+      ring_size_(buffer_ring_size(buffer_size, num_buffers)), incremental_(incremental),
+      active_buffers_(initial_buffers == 0 ? num_buffers : std::min(initial_buffers, num_buffers)),
+      owner_(num_buffers, BufferOwner::IN_RING), zc_held_(num_buffers, 0), successor_(num_buffers, 0)
 {
     if (!ring_) {
         LOG_ERROR("Cannot initialize UringBuffer with null io_uring pointer");
         throw std::invalid_argument("Null io_uring pointer");
     }
+    if (!is_power_of_two(buffer_size_) || !is_power_of_two(num_buffers_) || num_buffers_ > 32768) {
+        LOG_ERROR("Buffer size and count must be powers of two (size: ", buffer_size_, ", count: ", num_buffers_, ")");
+        throw std::invalid_argument("Invalid buffer ring geometry");
+    }
+#ifndef IORING_CQE_F_BUF_MORE
+    if (incremental_) {
+        LOG_ERROR("Incremental buffer consumption is not supported by this liburing/kernel header");
+        throw std::runtime_error("IOU_PBUF_RING_INC not available");
+    }
+#endif
+    if (incremental_) {
+        inc_filled_.assign(num_buffers_, 0);
+        inc_released_.assign(num_buffers_, 0);
+        inc_retired_.assign(num_buffers_, 0);
+    }
     
     initBufferRing();
     LOG_INFO("UringBuffer initialized successfully");
@@ -67,7 +87,7 @@ UringBuffer::~UringBuffer() {
         if (buf_ring_) {
             // First unregister the buffer ring from io_uring
             if (ring_) {
-                io_uring_unregister_buf_ring(ring_, 1);
+                io_uring_unregister_buf_ring(ring_, bgid_);
             }
             
             // Then release the memory-mapped region
@@ -89,7 +109,7 @@ void UringBuffer::initBufferRing() {
     // Allocate memory-mapped region for buffer ring
     void* ring_addr = mmap(nullptr, ring_size_, 
                           PROT_READ | PROT_WRITE,
-                          MAP_ANONYMOUS | MAP_PRIVATE,
+                          MAP_ANONYMOUS | MAP_PRIVATE | MAP_NORESERVE,
                           -1, 0);
     if (ring_addr == MAP_FAILED) {
         LOG_ERROR("Failed to mmap buffer ring: ", strerror(errno));
@@ -99,10 +119,16 @@ void UringBuffer::initBufferRing() {
     // Register buffer ring with io_uring
     io_uring_buf_reg reg{};
     reg.ring_addr = reinterpret_cast<__u64>(ring_addr);
-    reg.ring_entries = NUM_IO_BUFFERS;
-    reg.bgid = 1;  // Buffer group ID
+    reg.ring_entries = num_buffers_;
+    reg.bgid = bgid_;  // Buffer group ID
 
-    int reg_result = io_uring_register_buf_ring(ring_, &reg, 0);
+    unsigned reg_flags = 0;
+#ifdef IORING_CQE_F_BUF_MORE
+    if (incremental_) {
+        reg_flags |= IOU_PBUF_RING_INC;
+    }
+#endif
+    int reg_result = io_uring_register_buf_ring(ring_, &reg, reg_flags);
     if (reg_result < 0) {
         LOG_ERROR("Failed to register buffer ring: ", strerror(-reg_result));
         munmap(ring_addr, ring_size_);
@@ -114,11 +140,11 @@ void UringBuffer::initBufferRing() {
     io_uring_buf_ring_init(buf_ring_);
 
     // Calculate base address for the actual buffers
-    buffer_base_addr_ = get_buffer_base_addr(ring_addr);
+    buffer_base_addr_ = get_buffer_base_addr(ring_addr, num_buffers_);
 
     try {
-        // Initialize all buffers in the ring
-        for (uint16_t i = 0; i < NUM_IO_BUFFERS; ++i) {
+        // Initialize the initial buffers in the ring (the rest are added by grow())
+        for (uint16_t i = 0; i < active_buffers_; ++i) {
             uint8_t* buf_addr = getBufferAddr(i, buffer_base_addr_);
             if (!buf_addr) {
                 throw std::runtime_error("Failed to get buffer address for index " + std::to_string(i));
@@ -127,36 +153,208 @@ void UringBuffer::initBufferRing() {
             // Register buffer with io_uring
             io_uring_buf_ring_add(buf_ring_, 
                                 buf_addr, 
-                                IO_BUFFER_SIZE, 
+                                buffer_size_, 
                                 i,
-                                io_uring_buf_ring_mask(NUM_IO_BUFFERS), 
+                                io_uring_buf_ring_mask(num_buffers_), 
                                 i);
+            if (i > 0) {
+                successor_[i - 1] = i;
+            }
         }
+        last_added_ = static_cast<uint16_t>(active_buffers_ - 1);
         
         // Submit all buffers at once
-        io_uring_buf_ring_advance(buf_ring_, NUM_IO_BUFFERS);
+        io_uring_buf_ring_advance(buf_ring_, active_buffers_);
+        free_buffers_ = active_buffers_;
+        min_free_buffers_ = active_buffers_;
         
-        LOG_DEBUG("Initialized buffer ring with ", NUM_IO_BUFFERS, " buffers of size ", IO_BUFFER_SIZE);
+        LOG_DEBUG("Initialized buffer ring (bgid ", bgid_, ") with ", active_buffers_, "/", num_buffers_,
+                  " buffers of size ", buffer_size_, incremental_ ? " (incremental)" : "");
     } catch (const std::exception& e) {
         // Clean up on failure
         LOG_ERROR("Exception during buffer initialization: ", e.what());
-        io_uring_unregister_buf_ring(ring_, 1);
+        io_uring_unregister_buf_ring(ring_, bgid_);
         munmap(ring_addr, ring_size_);
         throw;
     }
 }
 
 void UringBuffer::releaseBuffer(uint16_t idx, uint8_t* buf_base_addr) {
-    if (idx >= NUM_IO_BUFFERS) {
+    if (idx >= num_buffers_) {
         LOG_ERROR("[Buffer] Invalid buffer index ", idx, " release attempt");
         return;
     }
+    if (zc_held_[idx]) {
+        // 링에 되돌리면 다음 recv가 전송 중인 페이지를 덮어씀
+        LOG_ERROR("[Buffer] Buffer ", idx, " released while a zero-copy send is in flight");
+        return;
+    }
+    if (owner_[idx] == BufferOwner::IN_RING) {
+        // 같은 ID가 링에 두 번 들어가면 두 recv가 한 버퍼에 동시에 쓰게 됨
+        ++double_releases_;
+        LOG_ERROR("[Buffer] Double release of buffer ", idx, " in group ", bgid_);
+        return;
+    }
+
+    // tail은 배치 끝(flushReleases)에 한 번만 넘김
+    io_uring_buf_ring_add(buf_ring_, getBufferAddr(idx, buf_base_addr), buffer_size_, idx,
+                         io_uring_buf_ring_mask(num_buffers_), static_cast<int>(pending_adds_));
+    ++pending_adds_;
+    owner_[idx] = BufferOwner::IN_RING;
+    successor_[last_added_] = idx;
+    last_added_ = idx;
+    ++free_buffers_;
+}
+
+void UringBuffer::flushReleases() {
+    if (pending_adds_ == 0) {
+        return;
+    }
+    io_uring_buf_ring_advance(buf_ring_, static_cast<int>(pending_adds_));
+    pending_adds_ = 0;
+}
+
+void UringBuffer::markReceived(uint16_t first_idx, unsigned count) {
+    uint16_t idx = first_idx;
+    for (unsigned i = 0; i < count && idx < num_buffers_; ++i) {
+        if (owner_[idx] != BufferOwner::IN_RING) {
+            // 링에 없다고 기록된 버퍼를 커널이 돌려줌: 이전에 장부 밖에서 링에 추가되었음을 의미
+            LOG_ERROR("[Buffer] Buffer ", idx, " in group ", bgid_, " received while not in ring (state ",
+                      static_cast<int>(owner_[idx]), ")");
+        } else if (free_buffers_ > 0) {
+            --free_buffers_;
+        }
+        owner_[idx] = BufferOwner::PARSER;
+        if (debug_) {
+            received_this_batch_.push_back(idx);
+        }
+        idx = successor_[idx];
+    }
+    min_free_buffers_ = std::min(min_free_buffers_, free_buffers_);
+}
+
+void UringBuffer::markSending(uint16_t idx) {
+    if (idx >= num_buffers_ || owner_[idx] != BufferOwner::PARSER) {
+        LOG_ERROR("[Buffer] Buffer ", idx, " in group ", bgid_, " handed to send while not owned by parser");
+        return;
+    }
+    owner_[idx] = BufferOwner::SENDING;
+}
+
+unsigned UringBuffer::auditParserOwned() {
+    unsigned leaked = 0;
+    for (uint16_t idx : received_this_batch_) {
+        if (owner_[idx] != BufferOwner::PARSER || (incremental_ && !inc_retired_[idx])) {
+            continue;
+        }
+        LOG_ERROR("[Buffer] Leak: buffer ", idx, " in group ", bgid_, " still owned by parser after its batch");
+        if (incremental_) {
+            inc_filled_[idx] = 0;
+            inc_released_[idx] = 0;
+            inc_retired_[idx] = 0;
+        }
+        releaseBuffer(idx, buffer_base_addr_);
+        ++leaked;
+    }
+    received_this_batch_.clear();
+    return leaked;
+}
 
+unsigned UringBuffer::grow(unsigned count) {
+    const unsigned added = std::min(count, num_buffers_ - active_buffers_);
+    if (added == 0) {
+        return 0;
+    }
     
-    io_uring_buf_ring_add(buf_ring_, getBufferAddr(idx, buf_base_addr), IO_BUFFER_SIZE, idx,
-                         io_uring_buf_ring_mask(NUM_IO_BUFFERS), 0);
-    io_uring_buf_ring_advance(buf_ring_, 1);
+    const int mask = io_uring_buf_ring_mask(num_buffers_);
+    for (unsigned i = 0; i < added; ++i) {
+        const uint16_t idx = static_cast<uint16_t>(active_buffers_ + i);
+        io_uring_buf_ring_add(buf_ring_, getBufferAddr(idx, buffer_base_addr_), buffer_size_, idx, mask,
+                             static_cast<int>(pending_adds_ + i));
+        successor_[last_added_] = idx;
+        last_added_ = idx;
+    }
+    pending_adds_ += added;
+    active_buffers_ += added;
+    free_buffers_ += added;
+    LOG_INFO("[Buffer] Buffer group ", bgid_, " grown to ", active_buffers_, "/", num_buffers_, " buffers");
+    return added;
+}
+
+void UringBuffer::collectBundle(uint16_t first_idx, unsigned bytes, std::vector<uint16_t>& out) const {
+    out.clear();
+    uint16_t idx = first_idx;
+    // 마지막 버퍼만 부분적으로 채워지고 나머지는 buffer_size_만큼 가득 참
+    for (unsigned covered = 0; covered < bytes && idx < num_buffers_; covered += buffer_size_) {
+        out.push_back(idx);
+        idx = successor_[idx];
+    }
+}
+
+void UringBuffer::holdForZeroCopy(uint16_t idx) {
+    if (idx >= num_buffers_) {
+        LOG_ERROR("[Buffer] Invalid buffer index ", idx, " zero-copy hold attempt");
+        return;
+    }
+    if (zc_held_[idx]) {
+        LOG_ERROR("[Buffer] Buffer ", idx, " already held for zero-copy");
+        return;
+    }
+    if (owner_[idx] != BufferOwner::SENDING) {
+        LOG_ERROR("[Buffer] Buffer ", idx, " in group ", bgid_, " held for zero-copy before being handed to send");
+    }
+    zc_held_[idx] = 1;
+    ++zc_in_flight_;
+}
+
+void UringBuffer::completeZeroCopy(uint16_t idx) {
+    if (idx >= num_buffers_ || !zc_held_[idx]) {
+        LOG_ERROR("[Buffer] Unexpected zero-copy completion for buffer ", idx);
+        return;
+    }
+    zc_held_[idx] = 0;
+    --zc_in_flight_;
+    releaseBuffer(idx, buffer_base_addr_);
 }
 
+uint8_t* UringBuffer::consumeIncremental(uint16_t idx, unsigned bytes, bool buffer_more) {
+    if (!incremental_ || idx >= num_buffers_) {
+        LOG_ERROR("[Buffer] Invalid incremental consume of buffer ", idx);
+        return nullptr;
+    }
+    if (inc_retired_[idx] || inc_filled_[idx] + bytes > buffer_size_) {
+        LOG_ERROR("[Buffer] Incremental buffer ", idx, " overrun (filled ", inc_filled_[idx], ", bytes ", bytes, ")");
+        return nullptr;
+    }
 
+    // 커널은 이전 recv가 끝난 지점부터 이어서 채움
+    uint8_t* data = getBufferAddr(idx, buffer_base_addr_) + inc_filled_[idx];
+    inc_filled_[idx] += bytes;
+    if (!buffer_more) {
+        // 커널이 버퍼를 다 쓰고 링에서 뺌 (부분적으로 쓰는 동안에는 링 head에 남아 있음)
+        inc_retired_[idx] = 1;
+        markReceived(idx);
+    }
+    return data;
+}
 
+void UringBuffer::releaseIncremental(uint16_t idx, unsigned bytes) {
+    if (!incremental_ || idx >= num_buffers_) {
+        LOG_ERROR("[Buffer] Invalid incremental release of buffer ", idx);
+        return;
+    }
+    inc_released_[idx] += bytes;
+    if (inc_released_[idx] > inc_filled_[idx]) {
+        LOG_ERROR("[Buffer] Incremental buffer ", idx, " released more bytes than received");
+        inc_released_[idx] = inc_filled_[idx];
+    }
+    if (!inc_retired_[idx] || inc_released_[idx] != inc_filled_[idx]) {
+        return;
+    }
+
+    // 커널이 놓았고 파서도 모든 바이트를 처리함: 버퍼 전체를 다시 링에 추가
+    inc_filled_[idx] = 0;
+    inc_released_[idx] = 0;
+    inc_retired_[idx] = 0;
+    releaseBuffer(idx, buffer_base_addr_);
+}